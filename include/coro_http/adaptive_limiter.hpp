@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace coro_http {
+
+struct AdaptiveLimit {
+    int initial_limit{20};
+    int min_limit{1};
+    int max_limit{200};
+    double backoff_ratio{0.9};      // Multiplicative decrease on 5xx / timeout
+    double rtt_tolerance{1.5};      // Latency growth tolerated before shrinking
+    double smoothing{0.2};          // Weight of each new limit estimate
+    int long_window{600};           // Samples averaged into the baseline RTT
+};
+
+// Concurrency limit that follows the upstream's latency, after the Gradient2
+// limiter from Netflix concurrency-limits. A baseline ("long") RTT is tracked
+// with a slow moving average and compared against the recent ("short") RTT:
+// while they agree the limit grows by roughly sqrt(limit), and once recent
+// latency climbs above rtt_tolerance times the baseline the limit shrinks in
+// proportion. 5xx responses and timeouts back off multiplicatively (AIMD).
+// Not thread-safe; callers serialize access.
+class AdaptiveLimiter {
+public:
+    explicit AdaptiveLimiter(const AdaptiveLimit& options)
+        : options_(options),
+          limit_(std::clamp<double>(options.initial_limit, options.min_limit, options.max_limit)) {}
+    
+    // Feed one completed request. `in_flight` is the number of requests that
+    // were outstanding when it completed, including itself.
+    void on_sample(std::chrono::microseconds rtt, int in_flight, bool overloaded) {
+        if (overloaded) {
+            limit_ = std::max<double>(options_.min_limit, limit_ * options_.backoff_ratio);
+            return;
+        }
+        
+        double sample = static_cast<double>(std::max<long long>(rtt.count(), 1));
+        short_rtt_ = short_rtt_ > 0 ? short_rtt_ * 0.9 + sample * 0.1 : sample;
+        
+        double alpha = 2.0 / (std::max(options_.long_window, 1) + 1);
+        long_rtt_ = long_rtt_ > 0 ? long_rtt_ * (1.0 - alpha) + sample * alpha : sample;
+        
+        // Let the baseline follow quickly once latency improves again
+        if (long_rtt_ / short_rtt_ > 2.0) {
+            long_rtt_ *= 0.95;
+        }
+        
+        // Too few requests in flight to learn anything about the upstream's capacity
+        if (in_flight < limit_ / 2) {
+            return;
+        }
+        
+        double gradient = std::clamp(options_.rtt_tolerance * long_rtt_ / short_rtt_, 0.5, 1.0);
+        double estimate = limit_ * gradient + std::sqrt(limit_);
+        limit_ = limit_ * (1.0 - options_.smoothing) + estimate * options_.smoothing;
+        limit_ = std::clamp<double>(limit_, options_.min_limit, options_.max_limit);
+    }
+    
+    int limit() const {
+        return static_cast<int>(limit_);
+    }
+    
+    std::chrono::microseconds rtt() const {
+        return std::chrono::microseconds(static_cast<long long>(short_rtt_));
+    }
+    
+    std::chrono::microseconds baseline_rtt() const {
+        return std::chrono::microseconds(static_cast<long long>(long_rtt_));
+    }
+
+private:
+    AdaptiveLimit options_;
+    double limit_;
+    double short_rtt_{0};
+    double long_rtt_{0};
+};
+
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "error.hpp"
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#if defined(_WIN32)
+#include <cstdio>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace coro_http {
+
+// Response body stored in an anonymous temporary file instead of memory. The
+// file is unlinked as soon as it is created, so it disappears with the last
+// reference to it, whatever happens to the process. view() maps the file, so
+// the body's pages belong to the page cache and can be dropped under memory
+// pressure rather than counting as process memory.
+class BodyFile {
+public:
+    // Create an empty file in `directory`, or in TMPDIR (/tmp) when empty
+    static std::shared_ptr<BodyFile> create(const std::string& directory = "") {
+        return std::shared_ptr<BodyFile>(new BodyFile(directory));
+    }
+    
+#if !defined(_WIN32)
+    // Read-only view of `size` bytes at `offset` of an open file, such as a body
+    // kept in the disk cache. The descriptor is borrowed, not duplicated: `owner`
+    // keeps it open for as long as the view exists, so any number of views into
+    // one file share a single descriptor. Such a body must not be appended to.
+    static std::shared_ptr<BodyFile> map(std::shared_ptr<const void> owner, int fd, uint64_t offset, uint64_t size) {
+        return std::shared_ptr<BodyFile>(new BodyFile(std::move(owner), fd, offset, size));
+    }
+#endif
+    
+    ~BodyFile() {
+#if defined(_WIN32)
+        std::fclose(file_);
+#else
+        if (mapped_) {
+            ::munmap(mapped_, mapped_size_);
+        }
+        if (!owner_) {
+            ::close(fd_);
+        }
+#endif
+    }
+    
+    BodyFile(const BodyFile&) = delete;
+    BodyFile& operator=(const BodyFile&) = delete;
+    
+    void append(const char* data, size_t size) {
+#if defined(_WIN32)
+        if (std::fwrite(data, 1, size, file_) != size) {
+            throw std::system_error(errno, std::generic_category(), "Failed to write response body file");
+        }
+        size_ += size;
+#else
+        while (size > 0) {
+            ssize_t n = ::write(fd_, data, size);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw std::system_error(errno, std::generic_category(), "Failed to write response body file");
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+            size_ += static_cast<uint64_t>(n);
+        }
+#endif
+    }
+    
+    uint64_t size() const { return size_; }
+    
+    // The whole body, valid as long as this object. Mapped on first use; on
+    // platforms without mmap support here it is read into memory instead.
+    std::string_view view() const {
+        if (size_ == 0) {
+            return {};
+        }
+#if defined(_WIN32)
+        if (contents_.size() != size_) {
+            std::fflush(file_);
+            std::rewind(file_);
+            contents_.resize(static_cast<size_t>(size_));
+            if (std::fread(contents_.data(), 1, contents_.size(), file_) != contents_.size()) {
+                throw std::system_error(errno, std::generic_category(), "Failed to read response body file");
+            }
+            std::fseek(file_, 0, SEEK_END);
+        }
+        return contents_;
+#else
+        // Mappings start on a page boundary, so a view at an offset maps a little more
+        uint64_t lead = offset_ % static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+        size_t length = static_cast<size_t>(lead + size_);
+        if (!mapped_ || mapped_size_ != length) {
+            if (mapped_) {
+                ::munmap(mapped_, mapped_size_);
+                mapped_ = nullptr;
+            }
+            void* data = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd_, static_cast<off_t>(offset_ - lead));
+            if (data == MAP_FAILED) {
+                throw std::system_error(errno, std::generic_category(), "Failed to map response body file");
+            }
+            mapped_ = data;
+            mapped_size_ = length;
+        }
+        return std::string_view(static_cast<const char*>(mapped_) + lead, static_cast<size_t>(size_));
+#endif
+    }
+
+#if !defined(_WIN32)
+    // Descriptor of the file, e.g. to sendfile() the body elsewhere, and where
+    // in it the body starts
+    int native_handle() const { return fd_; }
+    uint64_t offset() const { return offset_; }
+#endif
+
+private:
+    explicit BodyFile(const std::string& directory) {
+#if defined(_WIN32)
+        (void)directory;
+        file_ = std::tmpfile();
+        if (!file_) {
+            throw std::system_error(errno, std::generic_category(), "Failed to create response body file");
+        }
+#else
+        std::string dir = directory;
+        if (dir.empty()) {
+            const char* tmp = std::getenv("TMPDIR");
+            dir = tmp && *tmp ? tmp : "/tmp";
+        }
+        std::string path = dir + "/coro_http_body_XXXXXX";
+        fd_ = ::mkstemp(path.data());
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "Failed to create response body file in " + dir);
+        }
+        ::unlink(path.c_str());
+#endif
+    }
+
+#if !defined(_WIN32)
+    BodyFile(std::shared_ptr<const void> owner, int fd, uint64_t offset, uint64_t size)
+        : owner_(std::move(owner)), fd_(fd), offset_(offset), size_(size) {}
+#endif
+
+#if defined(_WIN32)
+    std::FILE* file_{nullptr};
+    mutable std::string contents_;
+#else
+    std::shared_ptr<const void> owner_;  // Holds a borrowed descriptor open
+    int fd_{-1};
+    mutable void* mapped_{nullptr};
+    mutable size_t mapped_size_{0};
+    uint64_t offset_{0};
+#endif
+    uint64_t size_{0};
+};
+
+// Accumulates a decoded response body: in memory up to `spill_threshold` bytes,
+// in a BodyFile once it grows past that. A body larger than `max_size` fails
+// with error::response_too_large. Zero disables either limit.
+class BodyCollector {
+public:
+    BodyCollector(uint64_t max_size, uint64_t spill_threshold, std::string spill_directory)
+        : max_size_(max_size), spill_threshold_(spill_threshold), spill_directory_(std::move(spill_directory)) {}
+    
+    void append(const char* data, size_t size) {
+        if (max_size_ > 0 && size > max_size_ - size_) {
+            throw std::system_error(make_error_code(error::response_too_large));
+        }
+        size_ += size;
+        if (file_) {
+            file_->append(data, size);
+            return;
+        }
+        memory_.append(data, size);
+        if (spill_threshold_ > 0 && memory_.size() > spill_threshold_) {
+            file_ = BodyFile::create(spill_directory_);
+            file_->append(memory_.data(), memory_.size());
+            std::string().swap(memory_);
+        }
+    }
+    
+    uint64_t size() const { return size_; }
+    
+    // The body once complete: file() when it was spilled, take() otherwise
+    const std::shared_ptr<BodyFile>& file() const { return file_; }
+    std::string take() { return std::move(memory_); }
+
+private:
+    uint64_t max_size_;
+    uint64_t spill_threshold_;
+    std::string spill_directory_;
+    uint64_t size_{0};
+    std::string memory_;
+    std::shared_ptr<BodyFile> file_;
+};
+
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <asio.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace coro_http {
+
+// Request body produced piece by piece while it is being sent, so large uploads
+// need not be held in memory. A source with a known size() is sent with
+// Content-Length, one without as Transfer-Encoding: chunked.
+class BodySource {
+public:
+    virtual ~BodySource() = default;
+    
+    // Next piece of the body, empty at the end. The data stays valid until the
+    // next call.
+    virtual asio::awaitable<std::string_view> co_next() = 0;
+    
+    // Total size in bytes, if known before sending
+    virtual std::optional<uint64_t> size() const { return std::nullopt; }
+    
+    // Start again from the beginning so the request can be retried or replayed.
+    // Sources that cannot produce their data twice return false.
+    virtual bool rewind() { return false; }
+};
+
+// Body already held in memory
+class MemoryBodySource : public BodySource {
+public:
+    explicit MemoryBodySource(std::string data) : data_(std::move(data)) {}
+    
+    asio::awaitable<std::string_view> co_next() override {
+        std::string_view piece = done_ ? std::string_view() : std::string_view(data_);
+        done_ = true;
+        co_return piece;
+    }
+    
+    std::optional<uint64_t> size() const override { return data_.size(); }
+    
+    bool rewind() override {
+        done_ = false;
+        return true;
+    }
+
+private:
+    std::string data_;
+    bool done_{false};
+};
+
+// Body in memory owned by someone else, who keeps it alive until it has been sent
+class ViewBodySource : public BodySource {
+public:
+    explicit ViewBodySource(std::string_view data) : data_(data) {}
+    
+    asio::awaitable<std::string_view> co_next() override {
+        std::string_view piece = done_ ? std::string_view() : data_;
+        done_ = true;
+        co_return piece;
+    }
+    
+    std::optional<uint64_t> size() const override { return data_.size(); }
+    
+    bool rewind() override {
+        done_ = false;
+        return true;
+    }
+
+private:
+    std::string_view data_;
+    bool done_{false};
+};
+
+// Body produced by an async generator: each call to the producer returns the next
+// piece, and an empty string ends the body. Pass the size when it is known in
+// advance to send Content-Length instead of chunked encoding.
+class ProducerBodySource : public BodySource {
+public:
+    using Producer = std::function<asio::awaitable<std::string>()>;
+    
+    explicit ProducerBodySource(Producer producer, std::optional<uint64_t> size = std::nullopt)
+        : producer_(std::move(producer)), size_(size) {}
+    
+    asio::awaitable<std::string_view> co_next() override {
+        piece_ = co_await producer_();
+        co_return std::string_view(piece_);
+    }
+    
+    std::optional<uint64_t> size() const override { return size_; }
+
+private:
+    Producer producer_;
+    std::optional<uint64_t> size_;
+    std::string piece_;
+};
+
+// Body produced by a plain callback, called until it returns an empty string
+class CallbackBodySource : public BodySource {
+public:
+    using Callback = std::function<std::string()>;
+    
+    explicit CallbackBodySource(Callback callback, std::optional<uint64_t> size = std::nullopt)
+        : callback_(std::move(callback)), size_(size) {}
+    
+    asio::awaitable<std::string_view> co_next() override {
+        piece_ = callback_();
+        co_return std::string_view(piece_);
+    }
+    
+    std::optional<uint64_t> size() const override { return size_; }
+
+private:
+    Callback callback_;
+    std::optional<uint64_t> size_;
+    std::string piece_;
+};
+
+// Several sources sent back to back as one body. The size is known when every
+// part's size is, and the body can be rewound when every part can.
+class CompositeBodySource : public BodySource {
+public:
+    explicit CompositeBodySource(std::vector<std::shared_ptr<BodySource>> parts) : parts_(std::move(parts)) {}
+    
+    asio::awaitable<std::string_view> co_next() override {
+        while (current_ < parts_.size()) {
+            std::string_view piece = co_await parts_[current_]->co_next();
+            if (!piece.empty()) {
+                co_return piece;
+            }
+            ++current_;
+        }
+        co_return std::string_view();
+    }
+    
+    std::optional<uint64_t> size() const override {
+        uint64_t total = 0;
+        for (const auto& part : parts_) {
+            auto size = part->size();
+            if (!size) {
+                return std::nullopt;
+            }
+            total += *size;
+        }
+        return total;
+    }
+    
+    bool rewind() override {
+        for (const auto& part : parts_) {
+            if (!part->rewind()) {
+                return false;
+            }
+        }
+        current_ = 0;
+        return true;
+    }
+    
+    const std::vector<std::shared_ptr<BodySource>>& parts() const { return parts_; }
+
+private:
+    std::vector<std::shared_ptr<BodySource>> parts_;
+    size_t current_{0};
+};
+
+}
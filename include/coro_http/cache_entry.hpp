@@ -0,0 +1,119 @@
+#pragma once
+
+#include "http_response.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace coro_http {
+
+// Location of a response body inside the disk cache's segment files
+struct DiskBody {
+    uint64_t segment{0};
+    uint64_t offset{0};
+    uint64_t size{0};
+    uint32_t crc{0};
+};
+
+// Cache-Control directives that matter to a private cache (RFC 9111 section 5.2)
+struct CacheControl {
+    bool no_store{false};
+    bool no_cache{false};
+    bool must_revalidate{false};
+    std::optional<long long> max_age;
+    std::optional<long long> stale_while_revalidate;  // RFC 5861
+
+    static CacheControl parse(const std::string& value) {
+        CacheControl cc;
+        size_t pos = 0;
+        while (pos < value.size()) {
+            size_t end = value.find(',', pos);
+            if (end == std::string::npos) {
+                end = value.size();
+            }
+            std::string directive = value.substr(pos, end - pos);
+            pos = end + 1;
+
+            std::string name = directive.substr(0, directive.find('='));
+            std::string argument = name.size() < directive.size() ? directive.substr(name.size() + 1) : "";
+            trim(name);
+            trim(argument);
+            std::transform(name.begin(), name.end(), name.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            if (argument.size() >= 2 && argument.front() == '"' && argument.back() == '"') {
+                argument = argument.substr(1, argument.size() - 2);
+            }
+
+            if (name == "no-store") {
+                cc.no_store = true;
+            } else if (name == "no-cache") {
+                cc.no_cache = true;
+            } else if (name == "must-revalidate") {
+                cc.must_revalidate = true;
+            } else if (name == "max-age") {
+                cc.max_age = parse_seconds(argument);
+            } else if (name == "stale-while-revalidate") {
+                cc.stale_while_revalidate = parse_seconds(argument);
+            }
+        }
+        return cc;
+    }
+
+private:
+    static void trim(std::string& s) {
+        size_t start = s.find_first_not_of(" \t");
+        s = start == std::string::npos ? "" : s.substr(start, s.find_last_not_of(" \t") - start + 1);
+    }
+
+    // Invalid values count as 0, i.e. stale (RFC 9111 section 1.2.2)
+    static long long parse_seconds(const std::string& s) {
+        if (s.empty() || !std::all_of(s.begin(), s.end(), [](unsigned char c) { return std::isdigit(c); })) {
+            return 0;
+        }
+        try {
+            return std::stoll(s);
+        } catch (...) {
+            return 0x7fffffff;  // Larger than any sensible lifetime
+        }
+    }
+};
+
+// A stored response and what is needed to judge its freshness. Entries are never
+// modified once stored; a revalidation stores a new one in its place.
+struct CachedResponse {
+    HttpResponse response;
+    std::vector<std::pair<std::string, std::string>> vary;  // Request header (lowercase) and its value
+    std::chrono::steady_clock::time_point response_time;
+    std::chrono::seconds initial_age{0};
+    std::chrono::seconds freshness_lifetime{0};
+    std::chrono::seconds stale_while_revalidate{0};
+    bool no_cache{false};          // Revalidate before every use
+    size_t size{0};                // Bytes charged against the cache budget
+    std::optional<DiskBody> disk_body;  // Where the body is kept in the disk cache, if it is
+    mutable std::atomic<bool> revalidating{false};
+
+    std::chrono::seconds age(std::chrono::steady_clock::time_point now) const {
+        return initial_age + std::chrono::duration_cast<std::chrono::seconds>(now - response_time);
+    }
+
+    bool fresh(std::chrono::steady_clock::time_point now) const {
+        return !no_cache && age(now) < freshness_lifetime;
+    }
+
+    // Stale, but may still be served while it is revalidated in the background
+    bool serve_while_revalidating(std::chrono::steady_clock::time_point now) const {
+        return !no_cache && age(now) < freshness_lifetime + stale_while_revalidate;
+    }
+
+    bool validatable() const {
+        return !response.get_header("ETag").empty() || !response.get_header("Last-Modified").empty();
+    }
+};
+
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <asio.hpp>
+#include <asio/experimental/awaitable_operators.hpp>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <type_traits>
+
+namespace coro_http {
+
+// Cancellation token shared between the caller and in-flight requests.
+// Copies refer to the same state; cancel() may be called from any thread
+// and reaches every request currently holding the token.
+class CancellationToken {
+public:
+    CancellationToken() : state_(std::make_shared<State>()) {}
+    
+    void cancel() {
+        std::map<int, std::function<void()>> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            if (state_->cancelled) return;
+            state_->cancelled = true;
+            callbacks.swap(state_->callbacks);
+        }
+        
+        for (auto& [id, callback] : callbacks) {
+            callback();
+        }
+    }
+    
+    bool is_cancelled() const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->cancelled;
+    }
+    
+    // Register a callback invoked once on cancel(). Returns 0 and does not
+    // register anything if the token is already cancelled.
+    int add_callback(std::function<void()> callback) {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (state_->cancelled) return 0;
+        int id = ++state_->next_id;
+        state_->callbacks.emplace(id, std::move(callback));
+        return id;
+    }
+    
+    void remove_callback(int id) {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->callbacks.erase(id);
+    }
+
+private:
+    struct State {
+        std::mutex mutex;
+        bool cancelled{false};
+        int next_id{0};
+        std::map<int, std::function<void()>> callbacks;
+    };
+    
+    std::shared_ptr<State> state_;
+};
+
+// Await `op` and store any exception in `error` instead of propagating it.
+// Lets a failing operation still count as "finished first" when raced against a timer.
+template<typename T>
+asio::awaitable<std::optional<T>> co_capture(asio::awaitable<T> op, std::exception_ptr& error) {
+    try {
+        co_return co_await std::move(op);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    co_return std::nullopt;
+}
+
+inline asio::awaitable<void> co_capture(asio::awaitable<void> op, std::exception_ptr& error) {
+    try {
+        co_await std::move(op);
+    } catch (...) {
+        error = std::current_exception();
+    }
+}
+
+// Completes when `token` is cancelled or `deadline` passes, whichever comes first.
+// cancel() may run on another thread, so it only posts the timer cancellation.
+inline asio::awaitable<void> co_wait_cancelled(std::optional<std::chrono::steady_clock::time_point> deadline,
+                                               std::optional<CancellationToken> token) {
+    auto executor = co_await asio::this_coro::executor;
+    auto timer = std::make_shared<asio::steady_timer>(executor);
+    timer->expires_at(deadline ? *deadline : asio::steady_timer::time_point::max());
+    
+    int callback_id = 0;
+    if (token) {
+        std::weak_ptr<asio::steady_timer> weak_timer = timer;
+        callback_id = token->add_callback([executor, weak_timer]() {
+            asio::post(executor, [weak_timer]() {
+                if (auto timer = weak_timer.lock()) {
+                    timer->cancel();
+                }
+            });
+        });
+        if (token->is_cancelled()) {
+            token->remove_callback(callback_id);
+            co_return;
+        }
+    }
+    
+    co_await timer->async_wait(asio::as_tuple(asio::use_awaitable));
+    
+    if (token) {
+        token->remove_callback(callback_id);
+    }
+}
+
+// Race `op` against a per-request deadline and cancellation token. A cancelled
+// request throws asio::error::operation_aborted, an expired one asio::error::timed_out.
+// Pooled connections interrupted mid-request are closed by the pooled paths.
+template<typename T>
+asio::awaitable<T> co_with_cancellation(asio::awaitable<T> op,
+                                        std::optional<std::chrono::steady_clock::time_point> deadline,
+                                        std::optional<CancellationToken> token) {
+    if (token && token->is_cancelled()) {
+        throw std::system_error(asio::error::make_error_code(asio::error::operation_aborted));
+    }
+    
+    using namespace asio::experimental::awaitable_operators;
+    
+    std::exception_ptr error;
+    auto result = co_await (co_capture(std::move(op), error) || co_wait_cancelled(deadline, token));
+    
+    if (result.index() == 1) {
+        if (token && token->is_cancelled()) {
+            throw std::system_error(asio::error::make_error_code(asio::error::operation_aborted));
+        }
+        throw std::system_error(asio::error::make_error_code(asio::error::timed_out));
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    if constexpr (!std::is_void_v<T>) {
+        co_return std::move(*std::get<0>(result));
+    }
+}
+
+}
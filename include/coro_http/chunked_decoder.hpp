@@ -1,7 +1,11 @@
 #pragma once
 
+#include "error.hpp"
+#include <algorithm>
+#include <cstddef>
 #include <string>
 #include <sstream>
+#include <system_error>
 
 namespace coro_http {
 
@@ -34,4 +38,87 @@ inline std::string decode_chunked(const std::string& data) {
     return result;
 }
 
+// Incremental chunked transfer decoding for a body that arrives in arbitrary pieces
+class ChunkedDecoder {
+public:
+    // Decode up to `size` bytes, appending chunk data to `out`. Returns the number of
+    // bytes consumed, which is less than `size` only once the body is complete.
+    size_t feed(const char* data, size_t size, std::string& out) {
+        size_t pos = 0;
+        while (pos < size && state_ != State::done) {
+            if (state_ == State::data) {
+                size_t take = std::min(remaining_, size - pos);
+                out.append(data + pos, take);
+                pos += take;
+                remaining_ -= take;
+                if (remaining_ == 0) {
+                    state_ = State::data_end;
+                }
+                continue;
+            }
+            
+            char c = data[pos++];
+            if (c != '\n') {
+                if (line_.size() >= max_line_size) {
+                    throw std::system_error(make_error_code(error::protocol_error), "Chunk header line too long");
+                }
+                line_ += c;
+                continue;
+            }
+            if (!line_.empty() && line_.back() == '\r') {
+                line_.pop_back();
+            }
+            on_line();
+            line_.clear();
+        }
+        return pos;
+    }
+    
+    bool done() const {
+        return state_ == State::done;
+    }
+
+private:
+    enum class State { size, data, data_end, trailer, done };
+    
+    static constexpr size_t max_line_size = 8192;
+    
+    void on_line() {
+        switch (state_) {
+            case State::size: {
+                // Chunk extensions after ';' are ignored
+                std::string size_field = line_.substr(0, line_.find(';'));
+                size_t chunk_size = 0;
+                try {
+                    chunk_size = std::stoul(size_field, nullptr, 16);
+                } catch (...) {
+                    throw std::system_error(make_error_code(error::protocol_error), "Invalid chunk size");
+                }
+                if (chunk_size == 0) {
+                    state_ = State::trailer;
+                } else {
+                    remaining_ = chunk_size;
+                    state_ = State::data;
+                }
+                break;
+            }
+            case State::data_end:
+                state_ = State::size;
+                break;
+            case State::trailer:
+                // Trailer fields are dropped; an empty line ends the body
+                if (line_.empty()) {
+                    state_ = State::done;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    
+    State state_{State::size};
+    std::string line_;
+    size_t remaining_{0};
+};
+
 }
@@ -0,0 +1,299 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace coro_http {
+
+struct CircuitBreakerOptions {
+    int failure_threshold{5};                   // consecutive failures that open the circuit
+    double failure_rate_threshold{0.5};         // failure ratio over `window` that opens it
+    int minimum_requests{20};                   // outcomes in `window` before the ratio counts
+    std::chrono::milliseconds window{10000};
+    std::chrono::milliseconds open_duration{5000};  // fail fast this long before probing
+    int half_open_probes{3};                    // probes admitted, all of which must succeed
+};
+
+enum class CircuitState {
+    closed,
+    open,
+    half_open
+};
+
+// Classic closed / open / half-open circuit breaker for one upstream.
+// Closed: requests flow; the circuit opens after failure_threshold consecutive
+// failures, or once the failure ratio over the sliding window passes
+// failure_rate_threshold. Open: requests are rejected without touching the
+// network until open_duration has passed. Half-open: up to half_open_probes
+// requests go through one after another as probes; the circuit closes when all
+// of them succeed and reopens on the first failure.
+// Not thread-safe; callers serialize access.
+class CircuitBreaker {
+public:
+    struct Stats {
+        CircuitState state{CircuitState::closed};
+        uint64_t times_opened{0};
+        uint64_t times_half_opened{0};
+        uint64_t times_closed{0};
+        uint64_t rejected{0};                   // requests failed fast while open
+        int consecutive_failures{0};
+        double failure_rate{0.0};               // over the sliding window
+    };
+    
+    explicit CircuitBreaker(const CircuitBreakerOptions& options) : options_(options) {}
+    
+    // Whether a request may go out now. A request admitted while half-open is a
+    // probe; its outcome must be reported with probe = true.
+    bool allow(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) {
+        if (state_ == CircuitState::open) {
+            if (now - opened_at_ < options_.open_duration) {
+                ++stats_.rejected;
+                return false;
+            }
+            transition(CircuitState::half_open, now);
+        }
+        
+        if (state_ == CircuitState::half_open) {
+            // One probe at a time, so a trickle rather than a burst reaches the upstream
+            if (probe_in_flight_ || probes_admitted_ >= options_.half_open_probes) {
+                ++stats_.rejected;
+                return false;
+            }
+            probe_in_flight_ = true;
+            ++probes_admitted_;
+        }
+        return true;
+    }
+    
+    // Outcomes of requests admitted before the circuit last changed state (a slow
+    // request sent while closed, finishing while half-open) are not counted
+    void on_success(bool probe, std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) {
+        if (probe && state_ == CircuitState::half_open) {
+            probe_in_flight_ = false;
+            if (++probe_successes_ >= options_.half_open_probes) {
+                transition(CircuitState::closed, now);
+            }
+            return;
+        }
+        if (probe || state_ != CircuitState::closed) {
+            return;
+        }
+        consecutive_failures_ = 0;
+        bucket_at(now).successes++;
+    }
+    
+    void on_failure(bool probe, std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) {
+        if (probe && state_ == CircuitState::half_open) {
+            probe_in_flight_ = false;
+            transition(CircuitState::open, now);
+            return;
+        }
+        if (probe || state_ != CircuitState::closed) {
+            return;
+        }
+        
+        ++consecutive_failures_;
+        bucket_at(now).failures++;
+        if (consecutive_failures_ >= options_.failure_threshold) {
+            transition(CircuitState::open, now);
+            return;
+        }
+        
+        auto [successes, failures] = window_counts(now);
+        int total = successes + failures;
+        if (total >= options_.minimum_requests &&
+            static_cast<double>(failures) / total >= options_.failure_rate_threshold) {
+            transition(CircuitState::open, now);
+        }
+    }
+    
+    // The request ended without telling anything about the upstream (e.g. it was
+    // cancelled); frees a half-open probe slot for the next request
+    void on_ignored(bool probe) {
+        if (probe && state_ == CircuitState::half_open && probe_in_flight_) {
+            probe_in_flight_ = false;
+            --probes_admitted_;
+        }
+    }
+    
+    CircuitState state() const {
+        return state_;
+    }
+    
+    Stats get_stats(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) const {
+        Stats stats = stats_;
+        stats.state = state_;
+        stats.consecutive_failures = consecutive_failures_;
+        auto [successes, failures] = window_counts(now);
+        if (successes + failures > 0) {
+            stats.failure_rate = static_cast<double>(failures) / (successes + failures);
+        }
+        return stats;
+    }
+
+private:
+    static constexpr int bucket_count = 10;
+    
+    struct Bucket {
+        int64_t tick{-1};
+        int successes{0};
+        int failures{0};
+    };
+    
+    int64_t tick_of(std::chrono::steady_clock::time_point now) const {
+        auto width = std::max<int64_t>(options_.window.count() / bucket_count, 1);
+        return std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() / width;
+    }
+    
+    Bucket& bucket_at(std::chrono::steady_clock::time_point now) {
+        int64_t tick = tick_of(now);
+        Bucket& bucket = buckets_[tick % bucket_count];
+        if (bucket.tick != tick) {
+            bucket = Bucket{tick, 0, 0};
+        }
+        return bucket;
+    }
+    
+    std::pair<int, int> window_counts(std::chrono::steady_clock::time_point now) const {
+        int64_t tick = tick_of(now);
+        int successes = 0;
+        int failures = 0;
+        for (const auto& bucket : buckets_) {
+            if (bucket.tick > tick - bucket_count) {
+                successes += bucket.successes;
+                failures += bucket.failures;
+            }
+        }
+        return {successes, failures};
+    }
+    
+    void transition(CircuitState next, std::chrono::steady_clock::time_point now) {
+        state_ = next;
+        switch (next) {
+            case CircuitState::open:
+                ++stats_.times_opened;
+                opened_at_ = now;
+                break;
+            case CircuitState::half_open:
+                ++stats_.times_half_opened;
+                probes_admitted_ = 0;
+                probe_successes_ = 0;
+                probe_in_flight_ = false;
+                break;
+            case CircuitState::closed:
+                ++stats_.times_closed;
+                consecutive_failures_ = 0;
+                buckets_ = {};
+                break;
+        }
+    }
+    
+    CircuitBreakerOptions options_;
+    CircuitState state_{CircuitState::closed};
+    std::chrono::steady_clock::time_point opened_at_{};
+    int consecutive_failures_{0};
+    int probes_admitted_{0};
+    int probe_successes_{0};
+    bool probe_in_flight_{false};
+    std::array<Bucket, bucket_count> buckets_{};
+    Stats stats_;
+};
+
+// One circuit breaker per host, created on first use
+class CircuitBreakerRegistry {
+public:
+    // Outcome reporter for one admitted request. Destroying it without reporting
+    // (an exception unwinding past it, cancellation) counts as "ignored".
+    class Ticket {
+    public:
+        Ticket() = default;
+        Ticket(CircuitBreakerRegistry* registry, std::shared_ptr<CircuitBreaker> breaker, bool probe)
+            : registry_(registry), breaker_(std::move(breaker)), probe_(probe) {}
+        
+        Ticket(Ticket&& other) noexcept
+            : registry_(other.registry_), breaker_(std::move(other.breaker_)), probe_(other.probe_) {}
+        
+        Ticket& operator=(Ticket&& other) noexcept {
+            if (this != &other) {
+                finish(Result::ignored);
+                registry_ = other.registry_;
+                breaker_ = std::move(other.breaker_);
+                probe_ = other.probe_;
+            }
+            return *this;
+        }
+        
+        Ticket(const Ticket&) = delete;
+        Ticket& operator=(const Ticket&) = delete;
+        
+        ~Ticket() {
+            finish(Result::ignored);
+        }
+        
+        void success() { finish(Result::success); }
+        void failure() { finish(Result::failure); }
+    
+    private:
+        enum class Result { success, failure, ignored };
+        
+        void finish(Result result) {
+            if (!breaker_) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(registry_->mutex_);
+            switch (result) {
+                case Result::success: breaker_->on_success(probe_); break;
+                case Result::failure: breaker_->on_failure(probe_); break;
+                case Result::ignored: breaker_->on_ignored(probe_); break;
+            }
+            breaker_.reset();
+        }
+        
+        CircuitBreakerRegistry* registry_{nullptr};
+        std::shared_ptr<CircuitBreaker> breaker_;
+        bool probe_{false};
+    };
+    
+    explicit CircuitBreakerRegistry(const CircuitBreakerOptions& options = CircuitBreakerOptions{})
+        : options_(options) {}
+    
+    // Admit a request to `host`, or return nullopt when its circuit is open
+    std::optional<Ticket> try_acquire(const std::string& host) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& breaker = breakers_[host];
+        if (!breaker) {
+            breaker = std::make_shared<CircuitBreaker>(options_);
+        }
+        if (!breaker->allow()) {
+            return std::nullopt;
+        }
+        bool probe = breaker->state() == CircuitState::half_open;
+        return std::optional<Ticket>(std::in_place, this, breaker, probe);
+    }
+    
+    CircuitBreaker::Stats get_stats(const std::string& host) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = breakers_.find(host);
+        return it != breakers_.end() ? it->second->get_stats() : CircuitBreaker::Stats{};
+    }
+    
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        breakers_.clear();
+    }
+
+private:
+    CircuitBreakerOptions options_;
+    std::unordered_map<std::string, std::shared_ptr<CircuitBreaker>> breakers_;
+    mutable std::mutex mutex_;
+};
+
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <set>
 #include <string>
 
 namespace coro_http {
@@ -15,6 +18,31 @@ struct ClientConfig {
     
     bool enable_compression{true};
     
+    // Request body compression (Content-Encoding on uploads); the server must accept it
+    bool compress_requests{false};             // Compress request bodies sent to any host
+    std::set<std::string> compress_request_hosts;  // Or only those sent to these hosts
+    std::string request_compression{"gzip"};   // "gzip" or "deflate"
+    int request_compression_level{6};          // zlib level, 1 (fast) to 9 (small)
+    size_t request_compression_min_size{1024}; // Smaller bodies are not worth compressing
+    
+    // Response size limits, 0 for none; a larger response fails with error::response_too_large
+    size_t max_response_header_size{64 * 1024};  // Status line and header fields
+    uint64_t max_response_body_size{0};         // Decoded body
+    
+    // Bodies larger than this are kept in an unlinked temporary file instead of
+    // memory, see HttpResponse::body_file(); 0 keeps every body in memory
+    uint64_t response_spill_threshold{0};
+    std::string response_spill_directory;       // TMPDIR (/tmp) when empty
+    
+    // In-memory HTTP cache for GET responses, honoring Cache-Control, Expires and Vary
+    bool enable_cache{false};
+    size_t cache_max_bytes{64 * 1024 * 1024};  // Split evenly between the shards
+    size_t cache_shards{16};                   // Independently locked parts of the cache
+    // Persistent tier behind it, kept across restarts; empty keeps the cache in memory only
+    std::string cache_directory;
+    uint64_t cache_disk_max_bytes{1024ull * 1024 * 1024};
+    uint64_t cache_segment_size{64 * 1024 * 1024};  // Unit of disk writes and eviction
+    
     bool verify_ssl{false};
     std::string ca_cert_file;
     std::string ca_cert_path;
@@ -31,6 +59,22 @@ struct ClientConfig {
     bool enable_rate_limit{false};
     int rate_limit_requests{100};      // requests per window
     std::chrono::seconds rate_limit_window{1};  // window size
+    std::chrono::seconds host_limit_idle_timeout{300};  // Drop idle per-host limiter entries after this
+    
+    // Adaptive concurrency: per-host in-flight limit driven by latency, 5xx and timeouts
+    bool enable_adaptive_concurrency{false};
+    int adaptive_initial_limit{20};
+    int adaptive_min_limit{1};
+    int adaptive_max_limit{200};
+    
+    // Circuit breaker: fail fast while a host keeps failing (connect errors, timeouts, 5xx)
+    bool enable_circuit_breaker{false};
+    int circuit_failure_threshold{5};          // Consecutive failures that open the circuit
+    double circuit_failure_rate{0.5};          // Failure ratio over the window that opens it
+    int circuit_minimum_requests{20};          // Requests in the window before the ratio counts
+    std::chrono::milliseconds circuit_window{10000};
+    std::chrono::milliseconds circuit_open_duration{5000};  // Fail fast this long, then probe
+    int circuit_half_open_probes{3};           // Successful probes needed to close again
     
     // Retry settings
     bool enable_retry{false};
@@ -41,9 +85,33 @@ struct ClientConfig {
     bool retry_on_timeout{true};       // Retry on connection/read timeout
     bool retry_on_connection_error{true};  // Retry on connection errors
     bool retry_on_5xx{false};          // Retry on 5xx server errors (disabled by default)
+    bool retry_non_idempotent{false};  // Also retry POST/PATCH that may have reached the server
+    bool retry_on_rate_limit{true};    // Retry on 429 Too Many Requests and 503 Service Unavailable
+    bool honor_retry_after{true};      // Wait as long as Retry-After / RateLimit-* headers ask, host-wide
+    std::chrono::milliseconds max_retry_after{60000};  // Longer server-requested waits are not retried
+    bool enable_retry_budget{true};    // Cap retries client-wide so they cannot amplify an outage
+    double retry_budget_ratio{0.1};    // Retries allowed per request, on average
+    int retry_budget_burst{10};        // Retries allowed before the ratio applies
     
     // Cookie settings
     bool enable_cookies{false};        // Enable automatic cookie management
+    
+    // Hedged requests (GET/HEAD without a body only)
+    bool enable_hedging{false};        // Send a second copy when the first is slow
+    double hedge_percentile{0.95};     // Hedge once the host's observed latency at this quantile has passed
+    std::chrono::milliseconds hedge_min_delay{5};  // Never hedge sooner than this
+    double hedge_budget_ratio{0.1};    // At most this fraction of extra requests
+    int hedge_min_samples{20};         // Latency samples per host needed before hedging
+    
+    // Identical GET/HEAD requests in flight at the same time share one exchange
+    bool coalesce_requests{false};
+    
+    // Event streams: reconnect when the stream ends or its connection fails,
+    // resuming with Last-Event-ID
+    bool sse_reconnect{false};
+    std::chrono::milliseconds sse_retry_delay{3000};      // Until the server sends a retry: field
+    std::chrono::milliseconds sse_max_retry_delay{60000}; // Cap of the backoff after repeated failures
+    int sse_max_reconnect_attempts{0};  // Consecutive failed attempts before giving up, 0 for no limit
 };
 
 }
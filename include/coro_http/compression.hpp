@@ -1,8 +1,17 @@
 #pragma once
 
+#include "body_source.hpp"
+#include "error.hpp"
+#include <algorithm>
+#include <limits>
 #include <string>
 #include <zlib.h>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
 
 namespace coro_http {
 
@@ -68,4 +77,271 @@ inline std::string decompress_deflate(const std::string& compressed_data) {
     return decompressed;
 }
 
+// Incremental gzip/deflate decompression for a body that arrives in pieces
+class Inflater {
+public:
+    enum class Format { gzip, deflate };
+    
+    explicit Inflater(Format format) {
+        int ret = format == Format::gzip ? inflateInit2(&stream_, 16 + MAX_WBITS) : inflateInit(&stream_);
+        if (ret != Z_OK) {
+            throw std::runtime_error("Failed to initialize decompression");
+        }
+    }
+    
+    ~Inflater() {
+        inflateEnd(&stream_);
+    }
+    
+    Inflater(const Inflater&) = delete;
+    Inflater& operator=(const Inflater&) = delete;
+    
+    // Output produced by one bounded feed() in the streaming paths, so that a
+    // small compressed read cannot expand into a huge buffer at once
+    static constexpr size_t output_step = 64 * 1024;
+    
+    // Decompress up to `size` bytes, appending at most `max_out` bytes of output to
+    // `out`. Returns the number of input bytes used; when the output limit stops
+    // it early, feed the rest again, and while stalled() call feed() even without
+    // new input to collect output zlib is still holding. Input after the end of
+    // the compressed stream counts as used and is ignored.
+    size_t feed(const char* data, size_t size, std::string& out,
+                size_t max_out = std::numeric_limits<size_t>::max()) {
+        stalled_ = false;
+        if (done_) {
+            return size;
+        }
+        // zlib counts input in uInt, so a larger input goes in slices
+        size_t given = 0;
+        stream_.avail_in = 0;
+        
+        char buffer[32768];
+        size_t produced = 0;
+        while (true) {
+            if (stream_.avail_in == 0 && given < size) {
+                uInt slice = static_cast<uInt>(std::min<size_t>(size - given, std::numeric_limits<uInt>::max()));
+                stream_.avail_in = slice;
+                stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data + given));
+                given += slice;
+            }
+            if (produced == max_out) {
+                stalled_ = true;
+                break;
+            }
+            size_t room = std::min(sizeof(buffer), max_out - produced);
+            stream_.avail_out = static_cast<uInt>(room);
+            stream_.next_out = reinterpret_cast<Bytef*>(buffer);
+            
+            int ret = inflate(&stream_, Z_NO_FLUSH);
+            if (ret == Z_BUF_ERROR) {
+                break;  // Needs more input
+            }
+            if (ret != Z_OK && ret != Z_STREAM_END) {
+                throw std::system_error(make_error_code(error::protocol_error), "Failed to decompress data");
+            }
+            
+            out.append(buffer, room - stream_.avail_out);
+            produced += room - stream_.avail_out;
+            if (ret == Z_STREAM_END) {
+                done_ = true;
+                return size;
+            }
+            if (stream_.avail_in == 0 && stream_.avail_out != 0 && given == size) {
+                break;
+            }
+        }
+        return given - stream_.avail_in;
+    }
+    
+    // The last feed() stopped at its output limit
+    bool stalled() const {
+        return stalled_;
+    }
+    
+    bool done() const {
+        return done_;
+    }
+
+private:
+    z_stream stream_{};
+    bool done_{false};
+    bool stalled_{false};
+};
+
+// Incremental gzip/deflate compression. reset() starts a new body on the same
+// zlib state, which is much cheaper than setting up a fresh one.
+class Deflater {
+public:
+    enum class Format { gzip, deflate };
+    
+    Deflater(Format format, int level) : format_(format), level_(level) {
+        int window_bits = format == Format::gzip ? 16 + MAX_WBITS : MAX_WBITS;
+        if (deflateInit2(&stream_, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw std::runtime_error("Failed to initialize compression");
+        }
+    }
+    
+    ~Deflater() {
+        deflateEnd(&stream_);
+    }
+    
+    Deflater(const Deflater&) = delete;
+    Deflater& operator=(const Deflater&) = delete;
+    
+    // Compress `size` bytes, appending whatever output is ready to `out`
+    void feed(const char* data, size_t size, std::string& out) {
+        run(data, size, Z_NO_FLUSH, out);
+    }
+    
+    // End the compressed stream, appending the remaining output to `out`
+    void finish(std::string& out) {
+        run(nullptr, 0, Z_FINISH, out);
+    }
+    
+    void reset() {
+        deflateReset(&stream_);
+    }
+    
+    Format format() const { return format_; }
+    int level() const { return level_; }
+    
+    // Content-Encoding token for the format
+    const char* encoding() const {
+        return format_ == Format::gzip ? "gzip" : "deflate";
+    }
+
+private:
+    // zlib counts input in uInt, so a larger input goes in slices; only the last
+    // one carries `flush`
+    void run(const char* data, size_t size, int flush, std::string& out) {
+        char buffer[32768];
+        do {
+            uInt slice = static_cast<uInt>(std::min<size_t>(size, std::numeric_limits<uInt>::max()));
+            stream_.avail_in = slice;
+            stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+            data = slice > 0 ? data + slice : data;
+            size -= slice;
+            int slice_flush = size == 0 ? flush : Z_NO_FLUSH;
+            
+            int ret;
+            do {
+                stream_.avail_out = sizeof(buffer);
+                stream_.next_out = reinterpret_cast<Bytef*>(buffer);
+                ret = deflate(&stream_, slice_flush);
+                if (ret == Z_STREAM_ERROR) {
+                    throw std::runtime_error("Failed to compress data");
+                }
+                out.append(buffer, sizeof(buffer) - stream_.avail_out);
+            } while (stream_.avail_out == 0 || (slice_flush == Z_FINISH && ret != Z_STREAM_END));
+        } while (size > 0);
+    }
+    
+    z_stream stream_{};
+    Format format_;
+    int level_;
+};
+
+// Finished Deflaters kept for reuse across requests. A handle returns its
+// Deflater to the pool when dropped, even after the pool itself is gone (then
+// the Deflater is simply freed).
+class DeflaterPool {
+    struct Shelf {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Deflater>> idle;
+        size_t max_idle;
+    };
+
+public:
+    struct Returner {
+        std::weak_ptr<Shelf> shelf;
+        
+        void operator()(Deflater* deflater) const {
+            std::unique_ptr<Deflater> owned(deflater);
+            if (auto locked = shelf.lock()) {
+                std::lock_guard<std::mutex> lock(locked->mutex);
+                if (locked->idle.size() < locked->max_idle) {
+                    locked->idle.push_back(std::move(owned));
+                }
+            }
+        }
+    };
+    using Handle = std::unique_ptr<Deflater, Returner>;
+    
+    explicit DeflaterPool(size_t max_idle = 16) : shelf_(std::make_shared<Shelf>()) {
+        shelf_->max_idle = max_idle;
+    }
+    
+    // A reset Deflater with the given settings, reused when one is idle
+    Handle acquire(Deflater::Format format, int level) {
+        {
+            std::lock_guard<std::mutex> lock(shelf_->mutex);
+            auto& idle = shelf_->idle;
+            for (auto it = idle.begin(); it != idle.end(); ++it) {
+                if ((*it)->format() == format && (*it)->level() == level) {
+                    Deflater* deflater = it->release();
+                    idle.erase(it);
+                    deflater->reset();
+                    return Handle(deflater, Returner{shelf_});
+                }
+            }
+        }
+        return Handle(new Deflater(format, level), Returner{shelf_});
+    }
+    
+    size_t idle() const {
+        std::lock_guard<std::mutex> lock(shelf_->mutex);
+        return shelf_->idle.size();
+    }
+
+private:
+    std::shared_ptr<Shelf> shelf_;
+};
+
+// Compress a whole in-memory body
+inline std::string compress(const std::string& data, Deflater& deflater) {
+    std::string out;
+    out.reserve(data.size() / 4 + 64);
+    deflater.feed(data.data(), data.size(), out);
+    deflater.finish(out);
+    return out;
+}
+
+// Compresses another body source as it is read. The compressed size is not known
+// in advance, so such a body is sent chunked.
+class CompressedBodySource : public BodySource {
+public:
+    CompressedBodySource(std::shared_ptr<BodySource> source, DeflaterPool::Handle deflater)
+        : source_(std::move(source)), deflater_(std::move(deflater)) {}
+    
+    asio::awaitable<std::string_view> co_next() override {
+        out_.clear();
+        // zlib buffers input internally, so keep feeding until output appears
+        while (out_.empty() && !finished_) {
+            std::string_view piece = co_await source_->co_next();
+            if (piece.empty()) {
+                deflater_->finish(out_);
+                finished_ = true;
+            } else {
+                deflater_->feed(piece.data(), piece.size(), out_);
+            }
+        }
+        co_return std::string_view(out_);
+    }
+    
+    bool rewind() override {
+        if (!source_->rewind()) {
+            return false;
+        }
+        deflater_->reset();
+        finished_ = false;
+        return true;
+    }
+
+private:
+    std::shared_ptr<BodySource> source_;
+    DeflaterPool::Handle deflater_;
+    std::string out_;
+    bool finished_{false};
+};
+
 }
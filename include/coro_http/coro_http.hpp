@@ -1,7 +1,9 @@
 #pragma once
 
 #include "http_request.hpp"
+#include "cancellation.hpp"
 #include "http_response.hpp"
+#include "error.hpp"
 #include "coro_http_client.hpp"
 #include "client_config.hpp"
 #include "auth.hpp"
@@ -9,3 +11,4 @@
 #include "cookie_jar.hpp"
 #include "interceptor.hpp"
 #include "sse_event.hpp"
+#include "sse_stream.hpp"
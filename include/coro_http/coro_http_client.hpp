@@ -8,18 +8,44 @@
 #include "proxy_handler.hpp"
 #include "connection_pool.hpp"
 #include "rate_limiter.hpp"
+#include "host_limiter.hpp"
+#include "circuit_breaker.hpp"
+#include "error.hpp"
 #include "retry_policy.hpp"
+#include "retry_after.hpp"
 #include "cookie_jar.hpp"
 #include "sse_event.hpp"
+#include "sse_stream.hpp"
+#include "response_stream.hpp"
+#include "file_body.hpp"
+#include "segmented_download.hpp"
+#include "compression.hpp"
+#include "latency_tracker.hpp"
+#include "token_budget.hpp"
+#include "http_cache.hpp"
 #include <asio.hpp>
 #include <asio/ssl.hpp>
 #include <asio/co_spawn.hpp>
 #include <asio/detached.hpp>
 #include <asio/use_awaitable.hpp>
 #include <asio/steady_timer.hpp>
+#include <asio/thread_pool.hpp>
+#include <asio/experimental/awaitable_operators.hpp>
 #include <sstream>
 #include <type_traits>
 #include <functional>
+#include <optional>
+#include <atomic>
+#include <array>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <cstdio>
+
+#if defined(__linux__)
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
 
 namespace coro_http {
 
@@ -35,13 +61,23 @@ public:
           proxy_info_(parse_proxy_url(config.proxy_url)),
           connection_pool_(config.max_connections_per_host, config.connection_idle_timeout),
           rate_limiter_(config.enable_rate_limit ? config.rate_limit_requests : 0, config.rate_limit_window),
+          host_limiter_(config.host_limit_idle_timeout),
+          circuit_breakers_(make_circuit_breaker_options(config)),
           retry_policy_(config.max_retries,
                        config.initial_retry_delay,
                        config.retry_backoff_factor,
                        config.max_retry_delay,
                        config.retry_on_timeout,
                        config.retry_on_connection_error,
-                       config.retry_on_5xx) {
+                       config.retry_on_5xx),
+          retry_budget_(config.retry_budget_ratio, config.retry_budget_burst, config.retry_budget_burst),
+          hedge_budget_(config.hedge_budget_ratio, 10.0, 0.0),
+          cache_(config.cache_max_bytes, config.cache_shards,
+                 config.enable_cache && !config.cache_directory.empty()
+                     ? std::make_unique<DiskCache>(config.cache_directory, config.cache_disk_max_bytes,
+                                                   config.cache_segment_size)
+                     : nullptr),
+          disk_writer_(cache_.has_disk() ? std::make_unique<asio::thread_pool>(1) : nullptr) {
         ssl_context_.set_default_verify_paths();
         
         if (config_.verify_ssl) {
@@ -60,108 +96,323 @@ public:
             proxy_info_.username = config_.proxy_username;
             proxy_info_.password = config_.proxy_password;
         }
+        
+        if (config_.enable_adaptive_concurrency) {
+            AdaptiveLimit adaptive;
+            adaptive.initial_limit = config_.adaptive_initial_limit;
+            adaptive.min_limit = config_.adaptive_min_limit;
+            adaptive.max_limit = config_.adaptive_max_limit;
+            host_limiter_.set_adaptive_limit(adaptive);
+        }
     }
 
     asio::awaitable<HttpResponse> co_execute(const HttpRequest& request) {
+        // Compressed once up front, so retries and redirects resend the same bytes
+        if (should_compress_body(request)) {
+            co_return co_await co_execute(compress_body(request));
+        }
+        
+        auto deadline = request_deadline(request);
+        if (!deadline && !request.cancellation_token()) {
+            co_return co_await co_execute_coalesced(request);
+        }
+        
+        // Racing the whole retry loop means cancellation reaches both the in-flight
+        // socket operation and the retry sleep timer.
+        co_return co_await co_with_cancellation(co_execute_coalesced(request), deadline,
+                                                request.cancellation_token());
+    }
+
+private:
+    // The earlier of the request's deadline and its timeout from now, if either is set
+    static std::optional<std::chrono::steady_clock::time_point> request_deadline(const HttpRequest& request) {
+        std::optional<std::chrono::steady_clock::time_point> deadline = request.deadline();
+        if (request.timeout()) {
+            auto timeout_deadline = std::chrono::steady_clock::now() + *request.timeout();
+            if (!deadline || timeout_deadline < *deadline) {
+                deadline = timeout_deadline;
+            }
+        }
+        return deadline;
+    }
+    
+    // `request` with the deadline of one attempt: request_timeout from now, or its own
+    // deadline if that comes first. The exchange sees either one expire as its operation
+    // being aborted; the deadline tells that apart from a cancelled caller.
+    HttpRequest with_attempt_deadline(const HttpRequest& request) const {
+        HttpRequest bounded = request;
+        if (config_.request_timeout.count() > 0) {
+            auto deadline = std::chrono::steady_clock::now() + config_.request_timeout;
+            if (!request.deadline() || deadline < *request.deadline()) {
+                bounded.set_deadline(deadline);
+            }
+        }
+        return bounded;
+    }
+    
+    // An exchange aborted after its deadline has passed timed out
+    static bool is_timeout(const HttpRequest& request, const std::error_code& ec) {
+        return ec == asio::error::timed_out ||
+               (ec == asio::error::operation_aborted && request.deadline() &&
+                std::chrono::steady_clock::now() >= *request.deadline());
+    }
+    
+    // An exchange that identical concurrent requests share; see co_execute_coalesced
+    struct Flight {
+        explicit Flight(asio::io_context& io_context)
+            : done(io_context, asio::steady_timer::time_point::max()) {}
+        
+        asio::steady_timer done;       // Expires once the result is in
+        bool finished{false};
+        std::optional<HttpResponse> response;
+        std::exception_ptr error;
+    };
+    
+    static bool is_coalescable(const HttpRequest& request) {
+        return (request.method() == HttpMethod::GET || request.method() == HttpMethod::HEAD) &&
+               request.body().empty() && !request.body_source();
+    }
+    
+    // Requests are identical when method, URL, headers and response limits match
+    static std::string flight_key(const HttpRequest& request) {
+        std::string key = method_to_string(request.method()) + " " + request.url() + "\n";
+        for (const auto& [name, value] : request.headers()) {
+            key += name + ": " + value + "\n";
+        }
+        key += std::to_string(request.max_response_header_size().value_or(0)) + " " +
+               std::to_string(request.max_response_body_size().value_or(0)) + " " +
+               std::to_string(request.response_spill_threshold().value_or(0));
+        return key;
+    }
+    
+    // With coalesce_requests, a GET or HEAD identical to one already in flight does
+    // not go out again: it waits for that exchange and gets a copy of its response.
+    // The copies share one immutable body buffer. The exchange runs on its own and is
+    // bounded only by request_timeout, not by the first caller's deadline or token, so
+    // a caller that times out or is cancelled stops waiting without failing the others.
+    asio::awaitable<HttpResponse> co_execute_coalesced(const HttpRequest& request) {
+        if (!config_.coalesce_requests || !is_coalescable(request)) {
+            co_return co_await co_execute_with_retry(request);
+        }
+        
+        std::string key = flight_key(request);
+        std::shared_ptr<Flight> flight;
+        bool leader = false;
+        {
+            std::lock_guard<std::mutex> lock(flights_mutex_);
+            auto& slot = flights_[key];
+            if (!slot) {
+                slot = std::make_shared<Flight>(io_context_);
+                leader = true;
+            }
+            flight = slot;
+        }
+        if (leader) {
+            asio::co_spawn(io_context_, co_fly(std::move(key), flight, HttpRequest(request).clear_cancellation()),
+                           asio::detached);
+        } else {
+            ++requests_coalesced_;
+        }
+        
+        co_await flight->done.async_wait(asio::as_tuple(asio::use_awaitable));
+        if (!flight->finished) {
+            throw std::system_error(asio::error::operation_aborted);
+        }
+        if (flight->error) {
+            std::rethrow_exception(flight->error);
+        }
+        co_return *flight->response;
+    }
+    
+    asio::awaitable<void> co_fly(std::string key, std::shared_ptr<Flight> flight, HttpRequest request) {
+        try {
+            flight->response = co_await co_execute_with_retry(request);
+        } catch (...) {
+            flight->error = std::current_exception();
+        }
+        {
+            // Requests from now on start a new exchange
+            std::lock_guard<std::mutex> lock(flights_mutex_);
+            flights_.erase(key);
+        }
+        flight->finished = true;
+        flight->done.expires_at(asio::steady_timer::time_point::min());
+    }
+    
+    asio::awaitable<HttpResponse> co_execute_with_retry(const HttpRequest& request) {
         if (!config_.enable_retry) {
-            co_return co_await co_execute_with_redirects(request, 0);
+            co_return co_await co_execute_attempt(request);
         }
         
-        // Retry logic with exponential backoff
-        retry_policy_.reset();
+        // Retry logic with exponential backoff. Progress is tracked per request;
+        // the policy is shared by all concurrent requests.
+        RetryState retry_state;
+        retry_budget_.deposit();
         
         while (true) {
             std::exception_ptr eptr;
             HttpResponse response;
-            bool success = false;
-            bool should_retry_on_status = false;
-            bool should_retry_on_error = false;
-            std::chrono::milliseconds delay{0};
+            std::optional<std::chrono::milliseconds> delay;
             
             // Try to execute request
             try {
-                response = co_await co_execute_with_redirects(request, 0);
-                success = true;
+                response = co_await co_execute_attempt(request);
                 
-                // Check if we should retry based on status code  
-                if (retry_policy_.current_attempt() < retry_policy_.max_retries() &&
-                    config_.retry_on_5xx && 
-                    response.status_code() >= 500 && 
-                    response.status_code() < 600) {
-                    should_retry_on_status = true;
-                    retry_policy_.increment_attempt();
-                    delay = retry_policy_.get_delay();
+                // Check if we should retry based on status code. A server-supplied
+                // Retry-After replaces our own backoff; one asking for more than
+                // max_retry_after is answered with the response instead. A status
+                // means the request reached the server, so the same idempotency
+                // rule as for errors after sending applies.
+                if (retry_policy_.can_retry(retry_state) && is_retryable_status(response.status_code()) &&
+                    (request.is_idempotent() || config_.retry_non_idempotent)) {
+                    std::optional<std::chrono::milliseconds> server_delay;
+                    if (config_.honor_retry_after) {
+                        server_delay = get_server_backoff(response);
+                    }
+                    if (!server_delay || *server_delay <= config_.max_retry_after) {
+                        delay = server_delay ? *server_delay : retry_policy_.get_delay(retry_state);
+                    }
+                }
+            } catch (const std::exception& e) {
+                if (!retry_policy_.should_retry(e, retry_state,
+                                                request.is_idempotent() || config_.retry_non_idempotent)) {
+                    throw;  // No more retries
                 }
-            } catch (...) {
                 eptr = std::current_exception();
+                delay = retry_policy_.get_delay(retry_state);
             }
             
-            // If successful and no retry needed, return response
-            if (success && !should_retry_on_status) {
+            // If successful and no retry needed, return response. The same goes
+            // for a streamed body that cannot be produced a second time.
+            if (!delay || !rewind_body(request)) {
+                if (eptr) {
+                    std::rethrow_exception(eptr);
+                }
                 co_return response;
             }
             
-            // Handle retry on status code
-            if (should_retry_on_status) {
-                asio::steady_timer timer(io_context_);
-                timer.expires_after(delay);
-                co_await timer.async_wait(asio::use_awaitable);
-                continue;
-            }
-            
-            // Handle exception - check if should retry
-            if (eptr) {
-                try {
+            // Out of retry budget: report this attempt's outcome as is
+            if (config_.enable_retry_budget && !retry_budget_.try_withdraw()) {
+                ++retries_denied_;
+                if (eptr) {
                     std::rethrow_exception(eptr);
-                } catch (const std::exception& e) {
-                    if (config_.enable_retry && retry_policy_.should_retry(e, 0)) {
-                        should_retry_on_error = true;
-                        retry_policy_.increment_attempt();
-                        delay = retry_policy_.get_delay();
-                    } else {
-                        throw;  // No more retries
-                    }
-                }
-                
-                if (should_retry_on_error) {
-                    asio::steady_timer timer(io_context_);
-                    timer.expires_after(delay);
-                    co_await timer.async_wait(asio::use_awaitable);
-                    continue;
                 }
+                co_return response;
             }
+            ++retries_;
+            ++retry_state.attempt;
+            
+            asio::steady_timer timer(io_context_);
+            timer.expires_after(*delay);
+            co_await timer.async_wait(asio::use_awaitable);
         }
     }
 
-private:
-    asio::awaitable<HttpResponse> co_execute_with_redirects(const HttpRequest& request, int redirect_count) {
+    bool is_retryable_status(int status_code) const {
+        if (retry_policy_.should_retry_status(status_code)) {
+            return true;
+        }
+        return config_.retry_on_rate_limit && (status_code == 429 || status_code == 503);
+    }
+    
+    // A single attempt bounded by request_timeout, hedged when enabled
+    asio::awaitable<HttpResponse> co_execute_attempt(const HttpRequest& request) {
+        if (!config_.enable_hedging || !is_hedgeable(request)) {
+            co_return co_await co_execute_bounded(request);
+        }
+        co_return co_await co_execute_hedged(request);
+    }
+    
+    asio::awaitable<HttpResponse> co_execute_bounded(const HttpRequest& request) {
+        HttpRequest bounded = with_attempt_deadline(request);
+        co_return co_await co_with_timeout(co_execute_with_redirects(bounded, 0), config_.request_timeout);
+    }
+    
+    static bool is_hedgeable(const HttpRequest& request) {
+        return (request.method() == HttpMethod::GET || request.method() == HttpMethod::HEAD) &&
+               request.body().empty() && !request.body_source();
+    }
+    
+    struct HedgeRace {
+        std::atomic<bool> hedge_sent{false};
+        std::atomic<int> failures{0};
+        std::exception_ptr primary_error;
+        std::exception_ptr hedge_error;
+    };
+    
+    // Send the request and, if it has not answered within the host's latency percentile,
+    // a second copy. The first response wins and the loser is cancelled, which closes its
+    // connection. Hedges are only sent while the hedge budget has tokens.
+    asio::awaitable<HttpResponse> co_execute_hedged(const HttpRequest& request) {
         auto url_info = parse_url(request.url());
+        std::string host_key = url_info.host + ":" + url_info.port;
+        hedge_budget_.deposit();
         
-        // Add cookies to request if enabled
-        HttpRequest req_with_cookies = request;
-        if (config_.enable_cookies) {
-            std::string cookies = cookie_jar_.get_cookies_for_request(
-                url_info.host, url_info.path, url_info.is_https);
-            if (!cookies.empty()) {
-                req_with_cookies.add_header("Cookie", cookies);
+        auto threshold = latency_tracker_.percentile(host_key, config_.hedge_percentile,
+                                                     static_cast<size_t>(std::max(config_.hedge_min_samples, 1)));
+        if (!threshold) {
+            co_return co_await co_execute_bounded(request);
+        }
+        auto delay = std::max(config_.hedge_min_delay,
+                              std::chrono::ceil<std::chrono::milliseconds>(*threshold));
+        
+        using namespace asio::experimental::awaitable_operators;
+        
+        auto race = std::make_shared<HedgeRace>();
+        auto result = co_await (co_hedge_branch(request, race, false, delay) ||
+                                co_hedge_branch(request, race, true, delay));
+        
+        auto& winner = result.index() == 0 ? std::get<0>(result) : std::get<1>(result);
+        if (winner) {
+            if (result.index() == 1) {
+                ++hedges_won_;
+            }
+            co_return std::move(*winner);
+        }
+        std::rethrow_exception(race->primary_error ? race->primary_error : race->hedge_error);
+    }
+    
+    asio::awaitable<std::optional<HttpResponse>> co_hedge_branch(const HttpRequest& request,
+                                                                 std::shared_ptr<HedgeRace> race,
+                                                                 bool is_hedge,
+                                                                 std::chrono::milliseconds delay) {
+        if (is_hedge) {
+            asio::steady_timer timer(io_context_);
+            timer.expires_after(delay);
+            co_await timer.async_wait(asio::use_awaitable);
+            
+            if (!hedge_budget_.try_withdraw()) {
+                co_await co_wait_forever();
             }
+            race->hedge_sent = true;
+            ++hedges_sent_;
         }
         
-        HttpResponse response;
-        if (url_info.is_https) {
-            response = co_await co_execute_https(req_with_cookies, url_info);
-        } else {
-            response = co_await co_execute_http(req_with_cookies, url_info);
+        std::exception_ptr& error = is_hedge ? race->hedge_error : race->primary_error;
+        auto response = co_await co_capture(co_execute_bounded(request), error);
+        if (response) {
+            co_return response;
         }
         
-        // Extract cookies from response if enabled
-        if (config_.enable_cookies) {
-            for (const auto& [key, value] : response.headers()) {
-                if (strcasecmp_parser(key, "Set-Cookie")) {
-                    cookie_jar_.parse_set_cookie(value, url_info.host);
-                }
-            }
+        // A failed copy only decides the race once the other copy can no longer answer
+        bool other_in_flight = is_hedge || race->hedge_sent;
+        if (++race->failures < 2 && other_in_flight) {
+            co_await co_wait_forever();
         }
+        co_return std::nullopt;
+    }
+    
+    // Suspend until cancelled
+    asio::awaitable<void> co_wait_forever() {
+        asio::steady_timer timer(io_context_);
+        timer.expires_at(asio::steady_timer::time_point::max());
+        co_await timer.async_wait(asio::use_awaitable);
+    }
+    
+    asio::awaitable<HttpResponse> co_execute_with_redirects(const HttpRequest& request, int redirect_count) {
+        HttpResponse response = config_.enable_cache ? co_await co_execute_cached(request)
+                                                     : co_await co_execute_once(request);
+        auto url_info = parse_url(request.url());
         
         if (config_.follow_redirects && 
             redirect_count < config_.max_redirects &&
@@ -181,6 +432,9 @@ private:
                 for (const auto& [key, value] : request.headers()) {
                     redirect_req.add_header(key, value);
                 }
+                if (request.deadline()) {
+                    redirect_req.set_deadline(*request.deadline());
+                }
                 
                 auto redirect_resp = co_await co_execute_with_redirects(redirect_req, redirect_count + 1);
                 for (const auto& url : response.redirect_chain()) {
@@ -193,51 +447,299 @@ private:
         co_return response;
     }
 
-    asio::awaitable<HttpResponse> co_execute_http(const HttpRequest& request, const UrlInfo& url_info) {
-        // Apply rate limiting (synchronous for now)
-        rate_limiter_.acquire();
+    // The in-memory cache in front of one exchange (RFC 9111). Fresh entries are served
+    // without any I/O. Stale ones are revalidated with If-None-Match/If-Modified-Since,
+    // and a 304 answer reuses the stored body. Within stale-while-revalidate the stale
+    // entry is served at once while a single background request revalidates it.
+    asio::awaitable<HttpResponse> co_execute_cached(const HttpRequest& request) {
+        if (!HttpCache::is_cacheable_request(request)) {
+            HttpResponse response = co_await co_execute_once(request);
+            // Unsafe methods invalidate what is stored for the target (RFC 9111 section 4.4)
+            if (request.method() != HttpMethod::GET && request.method() != HttpMethod::HEAD &&
+                request.method() != HttpMethod::OPTIONS && response.status_code() < 400) {
+                co_await co_write_cache([&] { cache_.erase(request.url()); });
+            }
+            co_return response;
+        }
+        
+        auto now = std::chrono::steady_clock::now();
+        auto entry = cache_.lookup(request);
+        if (entry && entry->fresh(now)) {
+            cache_.record_hit();
+            co_return entry->response;
+        }
+        if (entry && entry->serve_while_revalidating(now)) {
+            cache_.record_stale_hit();
+            if (!entry->revalidating.exchange(true)) {
+                asio::co_spawn(io_context_, co_revalidate(request, entry), asio::detached);
+            }
+            co_return entry->response;
+        }
+        cache_.record_miss();
+        co_return co_await co_fetch_and_store(request, entry);
+    }
+    
+    // Fetch `request`, made conditional when a validatable entry is stored, and update
+    // the cache with the answer
+    asio::awaitable<HttpResponse> co_fetch_and_store(const HttpRequest& request,
+                                                     std::shared_ptr<const CachedResponse> entry) {
+        HttpRequest conditional = request;
+        if (entry && entry->validatable()) {
+            std::string etag = entry->response.get_header("ETag");
+            std::string last_modified = entry->response.get_header("Last-Modified");
+            if (!etag.empty()) {
+                conditional.add_header("If-None-Match", etag);
+            }
+            if (!last_modified.empty()) {
+                conditional.add_header("If-Modified-Since", last_modified);
+            }
+        } else {
+            entry.reset();
+        }
+        
+        auto request_time = std::chrono::steady_clock::now();
+        HttpResponse response = co_await co_execute_once(conditional);
+        auto response_time = std::chrono::steady_clock::now();
+        
+        if (entry && response.status_code() == 304) {
+            auto refreshed = co_await co_write_cache([&] {
+                return cache_.refresh(request, *entry, response, request_time, response_time);
+            });
+            if (refreshed) {
+                co_return refreshed->response;
+            }
+            co_return entry->response;
+        }
+        co_await co_write_cache([&] { return cache_.store(request, response, request_time, response_time); });
+        co_return response;
+    }
+    
+    // Run a cache update that writes through to the disk tier on disk_writer_, so its
+    // writes and segment fsyncs do not stall the io thread; the caller resumes on its
+    // own executor once it is done. Without a disk tier it runs inline.
+    template<typename Update>
+    asio::awaitable<std::invoke_result_t<Update&>> co_write_cache(Update update) {
+        if (!disk_writer_) {
+            co_return update();
+        }
+        co_return co_await asio::co_spawn(disk_writer_->get_executor(),
+            [&]() -> asio::awaitable<std::invoke_result_t<Update&>> { co_return update(); },
+            asio::use_awaitable);
+    }
+    
+    asio::awaitable<void> co_revalidate(HttpRequest request, std::shared_ptr<const CachedResponse> entry) {
+        try {
+            request = with_attempt_deadline(request);
+            co_await co_with_timeout(co_fetch_and_store(request, entry), config_.request_timeout);
+        } catch (const std::exception&) {
+            // The stale entry stays until the next request revalidates it
+        }
+        entry->revalidating = false;
+    }
+    
+    // A request cleared to go out: the jar's cookies added, a global rate limiter
+    // token spent and a slot with the host's limiter held
+    struct Admitted {
+        HttpRequest request;
+        HostLimiterRegistry::Permit host_permit;
+    };
+    
+    // What every exchange goes through before it connects. Rate limiting comes first
+    // and suspends this coroutine only, never the io thread; waiting for a global
+    // token while holding a host slot would idle the slot.
+    asio::awaitable<Admitted> co_admit(const HttpRequest& request, const UrlInfo& url_info) {
+        HttpRequest req_with_cookies = request;
+        if (config_.enable_cookies) {
+            std::string cookies = cookie_jar_.get_cookies_for_request(
+                url_info.host, url_info.path, url_info.is_https);
+            if (!cookies.empty()) {
+                req_with_cookies.add_header("Cookie", cookies);
+            }
+        }
+        
+        co_await rate_limiter_.async_acquire(request.rate_limit_cost());
+        auto host_permit = co_await host_limiter_.co_acquire(url_info.host, url_info.path, request.rate_limit_cost());
+        co_return Admitted{std::move(req_with_cookies), std::move(host_permit)};
+    }
+    
+    // A single exchange with the server, without redirects or the cache
+    asio::awaitable<HttpResponse> co_execute_once(const HttpRequest& request) {
+        auto url_info = parse_url(request.url());
+        
+        // The host permit's outcome feeds the host's adaptive concurrency limit: 429 and
+        // 5xx responses and timeouts (including the request_timeout cancelling us) back off.
+        auto admitted = co_await co_admit(request, url_info);
+        const HttpRequest& req_with_cookies = admitted.request;
+        auto& host_permit = admitted.host_permit;
+        
+        auto started = std::chrono::steady_clock::now();
+        HttpResponse response;
+        try {
+            if (url_info.is_https) {
+                response = co_await co_execute_https(req_with_cookies, url_info);
+            } else {
+                response = co_await co_execute_http(req_with_cookies, url_info);
+            }
+        } catch (const std::system_error& e) {
+            if (is_timeout(request, e.code())) {
+                host_permit.record_outcome(true);
+            }
+            throw;
+        }
+        host_permit.record_outcome(response.status_code() >= 500 || response.status_code() == 429);
+        host_permit.release();
+        
+        // Hedging waits for the host's latency percentile, so only exchanges that went to
+        // the network are sampled; a cache hit never gets here
+        if (config_.enable_hedging && is_hedgeable(request)) {
+            latency_tracker_.record(url_info.host + ":" + url_info.port,
+                                    std::chrono::duration_cast<std::chrono::microseconds>(
+                                        std::chrono::steady_clock::now() - started));
+        }
         
+        // Server-requested backoff holds back every request to this host, not just this one
+        if (config_.honor_retry_after) {
+            if (auto backoff = get_server_backoff(response); backoff && backoff->count() > 0) {
+                host_limiter_.pause(url_info.host, std::chrono::steady_clock::now() +
+                                                   std::min(*backoff, config_.max_retry_after));
+            }
+        }
+        
+        // Extract cookies from response if enabled
+        if (config_.enable_cookies) {
+            for (const auto& [key, value] : response.headers()) {
+                if (strcasecmp_parser(key, "Set-Cookie")) {
+                    cookie_jar_.parse_set_cookie(value, url_info.host);
+                }
+            }
+        }
+        
+        co_return response;
+    }
+
+    asio::awaitable<HttpResponse> co_execute_http(const HttpRequest& request, const UrlInfo& url_info) {
         // Use connection pool if enabled
         if (config_.enable_connection_pool && proxy_info_.type == ProxyType::NONE) {
-            co_return co_await co_execute_http_pooled(request, url_info);
+            co_return co_await co_execute_pooled(request, url_info, [&] { return co_execute_http_pooled(request, url_info); });
         }
         
         // Non-pooled connection for proxy requests
         asio::ip::tcp::socket socket(io_context_);
-        co_await co_connect_socket(socket, url_info);
-        
-        std::string request_str;
-        if (proxy_info_.type == ProxyType::HTTP) {
-            request_str = build_proxy_request(request, url_info, config_.enable_compression);
-        } else {
-            request_str = build_request(request, url_info, config_.enable_compression);
+        bool written = false;
+        try {
+            co_await co_connect_socket(socket, url_info);
+            
+            std::string request_str;
+            if (proxy_info_.type == ProxyType::HTTP) {
+                request_str = build_proxy_request(request, url_info, config_.enable_compression);
+            } else {
+                request_str = build_request(request, url_info, config_.enable_compression);
+            }
+            
+            co_await co_write_request(socket, request_str, request);
+            written = true;
+            co_return co_await co_read_response(socket, request);
+        } catch (...) {
+            rethrow_request_error(false, written, request.is_idempotent());
+        }
+    }
+    
+    // Pooled execution for both schemes. The host's circuit breaker sits in front of the
+    // pool: while it is open, requests fail with error::circuit_open before taking a
+    // connection. A keep-alive connection the server closed while idle fails before the
+    // request reaches it; such requests are replayed on another connection. Stale
+    // connections leave the pool, so this ends at the latest on a newly opened one.
+    // A streamed body that cannot be rewound is not replayed.
+    template<typename Attempt, typename Result = typename std::invoke_result_t<Attempt>::value_type>
+    asio::awaitable<Result> co_execute_pooled(const HttpRequest& request, const UrlInfo& url_info, Attempt attempt) {
+        std::optional<CircuitBreakerRegistry::Ticket> ticket;
+        if (config_.enable_circuit_breaker) {
+            ticket = circuit_breakers_.try_acquire(url_info.host + ":" + url_info.port);
+            if (!ticket) {
+                throw HttpError(error::circuit_open, false);
+            }
         }
         
-        co_await asio::async_write(socket, asio::buffer(request_str), asio::use_awaitable);
-        std::string response_data = co_await co_read_response(socket, request.method());
-        
-        co_return parse_response(response_data);
+        while (true) {
+            try {
+                Result response = co_await attempt();
+                if (ticket) {
+                    if (response.status_code() >= 500) {
+                        ticket->failure();
+                    } else {
+                        ticket->success();
+                    }
+                }
+                co_return std::move(response);
+            } catch (const HttpError& e) {
+                // The request_timeout or deadline aborting the exchange is the host being slow
+                if (is_timeout(request, e.code())) {
+                    if (ticket) {
+                        ticket->failure();
+                    }
+                    throw HttpError(asio::error::timed_out, e.request_sent());
+                }
+                if (e.code() != error::stale_connection || !rewind_body(request)) {
+                    // Cancellation and protocol errors say nothing about the host's health
+                    if (ticket && is_upstream_failure(e.code())) {
+                        ticket->failure();
+                    }
+                    throw;
+                }
+            }
+            ++stale_replays_;
+        }
+    }
+    
+    // Failures that say the host is down or overloaded. A rejected certificate or
+    // a name that does not exist is a configuration problem: the host may be fine,
+    // and opening its circuit would only hide the real error.
+    static bool is_upstream_failure(const std::error_code& ec) {
+        switch (classify_error(ec)) {
+            case ErrorKind::connect_refused:
+            case ErrorKind::connection_reset:
+            case ErrorKind::eof_before_headers:
+            case ErrorKind::tls:
+            case ErrorKind::dns:
+            case ErrorKind::timeout:
+                return true;
+            case ErrorKind::tls_handshake:
+            case ErrorKind::dns_not_found:
+            default:
+                return false;
+        }
+    }
+    
+    static CircuitBreakerOptions make_circuit_breaker_options(const ClientConfig& config) {
+        CircuitBreakerOptions options;
+        options.failure_threshold = config.circuit_failure_threshold;
+        options.failure_rate_threshold = config.circuit_failure_rate;
+        options.minimum_requests = config.circuit_minimum_requests;
+        options.window = config.circuit_window;
+        options.open_duration = config.circuit_open_duration;
+        options.half_open_probes = config.circuit_half_open_probes;
+        return options;
     }
     
     asio::awaitable<HttpResponse> co_execute_http_pooled(const HttpRequest& request, const UrlInfo& url_info) {
         auto socket = connection_pool_.get_connection(io_context_, url_info.host, url_info.port);
-        
-        // Check if we need to connect
-        if (!socket->is_open()) {
-            asio::ip::tcp::resolver resolver(io_context_);
-            auto endpoints = co_await resolver.async_resolve(
-                url_info.host, url_info.port, asio::use_awaitable);
-            co_await asio::async_connect(*socket, endpoints, asio::use_awaitable);
-        }
+        bool reused = socket->is_open();
+        bool written = false;
         
         std::string request_str = build_request(request, url_info, config_.enable_compression, true);
         
         try {
-            co_await asio::async_write(*socket, asio::buffer(request_str), asio::use_awaitable);
-            std::string response_data = co_await co_read_response(*socket, request.method());
+            // Check if we need to connect
+            if (!reused) {
+                co_await co_with_timeout(co_resolve_and_connect(*socket, url_info.host, url_info.port),
+                                         config_.connect_timeout);
+            }
+            
+            co_await co_write_request(*socket, request_str, request);
+            written = true;
+            auto response = co_await co_read_response(*socket, request);
             
-            // Parse response and check Connection header
-            auto response = parse_response(response_data);
+            // Check Connection header
             
             // Check if server wants to close the connection
             std::string connection_header = response.get_header("Connection");
@@ -257,71 +759,75 @@ private:
             
             co_return response;
         } catch (...) {
-            // Don't return broken connection to pool
+            // Don't return broken or timed-out connection to pool
             asio::error_code ec;
             socket->shutdown(asio::ip::tcp::socket::shutdown_both, ec);
             socket->close(ec);
-            throw;
+            connection_pool_.release_connection(socket, url_info.host, url_info.port, false);
+            rethrow_request_error(reused, written, request.is_idempotent());
         }
     }
 
     asio::awaitable<HttpResponse> co_execute_https(const HttpRequest& request, const UrlInfo& url_info) {
-        // Apply rate limiting (synchronous for now)
-        rate_limiter_.acquire();
-        
         // Use SSL connection pool if enabled
         if (config_.enable_connection_pool && proxy_info_.type == ProxyType::NONE) {
-            co_return co_await co_execute_https_pooled(request, url_info);
+            co_return co_await co_execute_pooled(request, url_info, [&] { return co_execute_https_pooled(request, url_info); });
         }
         
         // Non-pooled connection for proxy requests
         asio::ssl::stream<asio::ip::tcp::socket> ssl_socket(io_context_, ssl_context_);
-        
-        co_await co_connect_socket(ssl_socket.next_layer(), url_info);
-        
-        if (proxy_info_.type != ProxyType::NONE) {
-            co_await co_establish_tunnel(ssl_socket.next_layer(), url_info);
-        }
-        
-        if (config_.verify_ssl) {
-            SSL_set_tlsext_host_name(ssl_socket.native_handle(), url_info.host.c_str());
-        }
-        
-        co_await ssl_socket.async_handshake(asio::ssl::stream_base::client, asio::use_awaitable);
-        
-        std::string request_str = build_request(request, url_info, config_.enable_compression);
-        co_await asio::async_write(ssl_socket, asio::buffer(request_str), asio::use_awaitable);
-        
-        std::string response_data = co_await co_read_response(ssl_socket, request.method());
-        
-        co_return parse_response(response_data);
-    }
-    
-    asio::awaitable<HttpResponse> co_execute_https_pooled(const HttpRequest& request, const UrlInfo& url_info) {
-        auto ssl_stream = connection_pool_.get_ssl_connection(io_context_, ssl_context_, url_info.host, url_info.port);
-        
-        // Check if we need to connect
-        if (!ssl_stream->lowest_layer().is_open()) {
-            asio::ip::tcp::resolver resolver(io_context_);
-            auto endpoints = co_await resolver.async_resolve(
-                url_info.host, url_info.port, asio::use_awaitable);
-            co_await asio::async_connect(ssl_stream->lowest_layer(), endpoints, asio::use_awaitable);
+        bool written = false;
+        try {
+            co_await co_connect_socket(ssl_socket.next_layer(), url_info);
+            
+            if (proxy_info_.type != ProxyType::NONE) {
+                co_await co_with_timeout(co_establish_tunnel(ssl_socket.next_layer(), url_info),
+                                         config_.connect_timeout);
+            }
             
             if (config_.verify_ssl) {
-                SSL_set_tlsext_host_name(ssl_stream->native_handle(), url_info.host.c_str());
+                SSL_set_tlsext_host_name(ssl_socket.native_handle(), url_info.host.c_str());
             }
             
-            co_await ssl_stream->async_handshake(asio::ssl::stream_base::client, asio::use_awaitable);
+            co_await co_with_timeout(ssl_socket.async_handshake(asio::ssl::stream_base::client, asio::use_awaitable),
+                                     config_.connect_timeout);
+            
+            std::string request_str = build_request(request, url_info, config_.enable_compression);
+            co_await co_write_request(ssl_socket, request_str, request);
+            written = true;
+            
+            co_return co_await co_read_response(ssl_socket, request);
+        } catch (...) {
+            rethrow_request_error(false, written, request.is_idempotent());
         }
+    }
+    
+    asio::awaitable<HttpResponse> co_execute_https_pooled(const HttpRequest& request, const UrlInfo& url_info) {
+        auto ssl_stream = connection_pool_.get_ssl_connection(io_context_, ssl_context_, url_info.host, url_info.port);
+        bool reused = ssl_stream->lowest_layer().is_open();
+        bool written = false;
         
         std::string request_str = build_request(request, url_info, config_.enable_compression, true);
         
         try {
-            co_await asio::async_write(*ssl_stream, asio::buffer(request_str), asio::use_awaitable);
-            std::string response_data = co_await co_read_response(*ssl_stream, request.method());
+            // Check if we need to connect
+            if (!reused) {
+                co_await co_with_timeout(co_resolve_and_connect(ssl_stream->next_layer(), url_info.host, url_info.port),
+                                         config_.connect_timeout);
+                
+                if (config_.verify_ssl) {
+                    SSL_set_tlsext_host_name(ssl_stream->native_handle(), url_info.host.c_str());
+                }
+                
+                co_await co_with_timeout(ssl_stream->async_handshake(asio::ssl::stream_base::client, asio::use_awaitable),
+                                         config_.connect_timeout);
+            }
             
-            // Parse response and check Connection header
-            auto response = parse_response(response_data);
+            co_await co_write_request(*ssl_stream, request_str, request);
+            written = true;
+            auto response = co_await co_read_response(*ssl_stream, request);
+            
+            // Check Connection header
             
             // Check if server wants to close the connection
             std::string connection_header = response.get_header("Connection");
@@ -332,46 +838,489 @@ private:
             // Return connection to pool only if keep-alive
             connection_pool_.release_ssl_connection(ssl_stream, url_info.host, url_info.port, should_keep_alive);
             
-            // Close SSL connection if server requested close
+            // Close SSL connection if server requested close. A peer that never
+            // answers close_notify must not hold on to an already complete response.
             if (!should_keep_alive) {
                 asio::error_code ec;
-                co_await ssl_stream->async_shutdown(asio::use_awaitable);
+                try {
+                    co_await co_with_timeout(ssl_stream->async_shutdown(asio::as_tuple(asio::use_awaitable)),
+                                             config_.read_timeout);
+                } catch (const std::system_error&) {}
                 ssl_stream->lowest_layer().close(ec);
             }
             
             co_return response;
         } catch (...) {
-            // Don't return broken connection to pool
+            // Don't return broken or timed-out connection to pool
             asio::error_code ec;
             ssl_stream->lowest_layer().close(ec);
+            connection_pool_.release_ssl_connection(ssl_stream, url_info.host, url_info.port, false);
+            rethrow_request_error(reused, written, request.is_idempotent());
+        }
+    }
+    
+    // Rethrow the exception being handled as an HttpError that records whether the
+    // request may have reached the server. On a reused keep-alive connection, a
+    // failure before the request was written, or a close without a single response
+    // byte, means the server dropped the idle connection: error::stale_connection.
+    // A non-idempotent request is only called stale if it was never written.
+    [[noreturn]] static void rethrow_request_error(bool reused, bool written, bool idempotent) {
+        try {
             throw;
+        } catch (const HttpError&) {
+            throw;
+        } catch (const std::system_error& e) {
+            if (reused) {
+                ErrorKind kind = classify_error(e.code());
+                bool dropped = !written && kind != ErrorKind::timeout && kind != ErrorKind::cancelled;
+                bool unanswered = idempotent && e.code() == error::empty_response;
+                if (dropped || unanswered) {
+                    throw HttpError(error::stale_connection, false);
+                }
+            }
+            throw HttpError(e.code(), written, e.what());
         }
     }
 
-    asio::awaitable<void> co_connect_socket(asio::ip::tcp::socket& socket, const UrlInfo& url_info) {
-        asio::ip::tcp::resolver resolver(io_context_);
-        
-        std::string connect_host;
-        std::string connect_port;
-        
-        if (proxy_info_.type != ProxyType::NONE) {
-            connect_host = proxy_info_.host;
+    // Kept from one connection of a reconnecting event stream to the next, so a
+    // reconnect skips the DNS lookup and resumes the TLS session
+    struct ReconnectCache {
+        asio::ip::tcp::resolver::results_type endpoints;
+        std::shared_ptr<SSL_SESSION> tls_session;
+    };
+    
+    // Send the request of a co_execute_stream() and read its response head
+    asio::awaitable<HttpResponseStream> co_open_stream(const HttpRequest& request) {
+        auto url_info = parse_url(request.url());
+        auto admitted = co_await co_admit(request, url_info);
+        const HttpRequest& req_with_cookies = admitted.request;
+        auto& host_permit = admitted.host_permit;
+        
+        bool pooled = config_.enable_connection_pool && proxy_info_.type == ProxyType::NONE;
+        auto open = [&] {
+            return url_info.is_https ? co_open_https_stream(req_with_cookies, url_info, pooled)
+                                     : co_open_http_stream(req_with_cookies, url_info, pooled);
+        };
+        HttpResponseStream stream = pooled ? co_await co_execute_pooled(request, url_info, open) : co_await open();
+        
+        // Sampled at the head: the body's transfer time says nothing about the host's latency
+        host_permit.record_outcome(stream.status_code() >= 500 || stream.status_code() == 429);
+        stream.hold_permit(std::move(host_permit));
+        if (config_.enable_cookies) {
+            for (const auto& [key, value] : stream.headers()) {
+                if (strcasecmp_parser(key, "Set-Cookie")) {
+                    cookie_jar_.parse_set_cookie(value, url_info.host);
+                }
+            }
+        }
+        co_return std::move(stream);
+    }
+    
+    // Body reads are bounded by `body_timeout`, read_timeout by default; 0 lets an
+    // idle body (an event stream) wait indefinitely. `reconnect` only applies to
+    // unpooled connections.
+    asio::awaitable<HttpResponseStream> co_open_http_stream(const HttpRequest& request, const UrlInfo& url_info,
+                                                            bool pooled,
+                                                            std::optional<std::chrono::milliseconds> body_timeout = std::nullopt,
+                                                            ReconnectCache* reconnect = nullptr) {
+        auto socket = pooled ? connection_pool_.get_connection(io_context_, url_info.host, url_info.port)
+                             : std::make_shared<asio::ip::tcp::socket>(io_context_);
+        bool reused = socket->is_open();
+        bool written = false;
+        
+        ConnectionLease lease([this, socket, pooled, host = url_info.host, port = url_info.port](bool reusable) {
+            if (!reusable) {
+                asio::error_code ec;
+                socket->shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+                socket->close(ec);
+            }
+            if (pooled) {
+                connection_pool_.release_connection(socket, host, port, reusable);
+            }
+        });
+        
+        try {
+            if (!reused) {
+                if (pooled) {
+                    co_await co_with_timeout(co_resolve_and_connect(*socket, url_info.host, url_info.port),
+                                             config_.connect_timeout);
+                } else {
+                    co_await co_connect_socket(*socket, url_info, reconnect ? &reconnect->endpoints : nullptr);
+                }
+            }
+            
+            std::string request_str = proxy_info_.type == ProxyType::HTTP
+                ? build_proxy_request(request, url_info, config_.enable_compression)
+                : build_request(request, url_info, config_.enable_compression, pooled);
+            co_await co_write_request(*socket, request_str, request);
+            written = true;
+            
+            auto [head, buffered] = co_await co_read_head(
+                *socket, request.max_response_header_size().value_or(config_.max_response_header_size));
+            HttpResponseStream stream(
+                parse_response_head(head), std::move(buffered), request.method(),
+                [this, socket, timeout = body_timeout.value_or(config_.read_timeout)](asio::mutable_buffer buffer) {
+                    return co_read_body_some(*socket, buffer, timeout);
+                },
+                std::move(lease));
+            if (FileSink::supports_splice()) {
+                stream.set_splice([this, socket](FileSink& sink, uint64_t max) {
+                    return co_splice_body(*socket, sink, max);
+                });
+            }
+            co_return std::move(stream);
+        } catch (...) {
+            lease.finish(false);
+            rethrow_request_error(reused, written, request.is_idempotent());
+        }
+    }
+    
+    asio::awaitable<HttpResponseStream> co_open_https_stream(const HttpRequest& request, const UrlInfo& url_info,
+                                                             bool pooled,
+                                                             std::optional<std::chrono::milliseconds> body_timeout = std::nullopt,
+                                                             ReconnectCache* reconnect = nullptr) {
+        auto ssl_stream = pooled
+            ? connection_pool_.get_ssl_connection(io_context_, ssl_context_, url_info.host, url_info.port)
+            : std::make_shared<asio::ssl::stream<asio::ip::tcp::socket>>(io_context_, ssl_context_);
+        bool reused = ssl_stream->lowest_layer().is_open();
+        bool written = false;
+        
+        ConnectionLease lease([this, ssl_stream, pooled, reconnect, host = url_info.host, port = url_info.port](bool reusable) {
+            // Taken when the connection is done rather than after the handshake: a
+            // TLS 1.3 server sends its session tickets only once the handshake is over
+            if (reconnect) {
+                remember_tls_session(ssl_stream->native_handle(), *reconnect);
+            }
+            if (!reusable) {
+                asio::error_code ec;
+                ssl_stream->lowest_layer().close(ec);
+            }
+            if (pooled) {
+                connection_pool_.release_ssl_connection(ssl_stream, host, port, reusable);
+            }
+        });
+        
+        try {
+            if (!reused) {
+                if (pooled) {
+                    co_await co_with_timeout(co_resolve_and_connect(ssl_stream->next_layer(), url_info.host, url_info.port),
+                                             config_.connect_timeout);
+                } else {
+                    co_await co_connect_socket(ssl_stream->next_layer(), url_info,
+                                               reconnect ? &reconnect->endpoints : nullptr);
+                    if (proxy_info_.type != ProxyType::NONE) {
+                        co_await co_with_timeout(co_establish_tunnel(ssl_stream->next_layer(), url_info),
+                                                 config_.connect_timeout);
+                    }
+                }
+                
+                if (config_.verify_ssl) {
+                    SSL_set_tlsext_host_name(ssl_stream->native_handle(), url_info.host.c_str());
+                }
+                if (reconnect && reconnect->tls_session) {
+                    SSL_set_session(ssl_stream->native_handle(), reconnect->tls_session.get());
+                }
+                
+                co_await co_with_timeout(ssl_stream->async_handshake(asio::ssl::stream_base::client, asio::use_awaitable),
+                                         config_.connect_timeout);
+            }
+            
+            std::string request_str = build_request(request, url_info, config_.enable_compression, pooled);
+            co_await co_write_request(*ssl_stream, request_str, request);
+            written = true;
+            
+            auto [head, buffered] = co_await co_read_head(
+                *ssl_stream, request.max_response_header_size().value_or(config_.max_response_header_size));
+            co_return HttpResponseStream(
+                parse_response_head(head), std::move(buffered), request.method(),
+                [this, ssl_stream, timeout = body_timeout.value_or(config_.read_timeout)](asio::mutable_buffer buffer) {
+                    return co_read_body_some(*ssl_stream, buffer, timeout);
+                },
+                std::move(lease));
+        } catch (...) {
+            lease.finish(false);
+            rethrow_request_error(reused, written, request.is_idempotent());
+        }
+    }
+    
+    // Read up to the end of the response headers. Returns the head and whatever body
+    // bytes arrived along with it. Headers beyond `max_size` (0 for no limit) fail
+    // with error::response_too_large.
+    template<typename AsyncReadStream>
+    asio::awaitable<std::pair<std::string, std::string>> co_read_head(AsyncReadStream& stream, size_t max_size) {
+        std::string data;
+        std::array<char, 8192> buffer;
+        
+        while (true) {
+            auto [ec, len] = co_await co_with_timeout(
+                stream.async_read_some(asio::buffer(buffer), asio::as_tuple(asio::use_awaitable)),
+                config_.read_timeout
+            );
+            data.append(buffer.data(), len);
+            
+            size_t header_end = data.find("\r\n\r\n");
+            size_t head_size = header_end == std::string::npos ? data.size() : header_end + 4;
+            if (max_size > 0 && head_size > max_size) {
+                throw std::system_error(make_error_code(error::response_too_large), "Response headers too large");
+            }
+            if (header_end != std::string::npos) {
+                co_return std::make_pair(data.substr(0, header_end + 4), data.substr(header_end + 4));
+            }
+            
+            if (ec == asio::error::eof || ec == asio::ssl::error::stream_truncated) {
+                throw std::system_error(make_error_code(
+                    data.empty() ? error::empty_response : error::eof_before_headers));
+            } else if (ec) {
+                if (data.empty() && classify_error(ec) == ErrorKind::connection_reset) {
+                    throw std::system_error(make_error_code(error::empty_response));
+                }
+                throw std::system_error(ec);
+            }
+        }
+    }
+    
+    // One bounded read of response body bytes; 0 once the peer has closed
+    template<typename AsyncReadStream>
+    asio::awaitable<size_t> co_read_body_some(AsyncReadStream& stream, asio::mutable_buffer buffer,
+                                              std::chrono::milliseconds timeout) {
+        auto [ec, len] = co_await co_with_timeout(
+            stream.async_read_some(buffer, asio::as_tuple(asio::use_awaitable)),
+            timeout
+        );
+        if (ec && ec != asio::error::eof && ec != asio::ssl::error::stream_truncated) {
+            throw std::system_error(ec);
+        }
+        co_return len;
+    }
+    
+    // State shared by the workers of one segmented co_download()
+    struct SegmentedJob {
+        SegmentedJob(asio::io_context& io_context, HttpRequest range_request, const std::string& path)
+            : request(std::move(range_request)), path(path), state_path(path + ".part"),
+              finished(io_context, asio::steady_timer::time_point::max()) {}
+        
+        // Cancel every segment still in flight and start no more
+        void stop() {
+            stopped = true;
+            for (auto& signal : signals) {
+                signal->emit(asio::cancellation_type::terminal);
+            }
+        }
+        
+        HttpRequest request;                  // GET for the object, without the Range
+        std::string path;
+        std::string state_path;
+        DownloadState state;
+        size_t next_segment{0};
+        int running{0};
+        bool stopped{false};
+        bool discard_progress{false};         // The object changed; start over next time
+        std::exception_ptr error;
+        std::optional<HttpResponse> response; // Error response that ended the download
+        std::vector<std::unique_ptr<asio::cancellation_signal>> signals;
+        asio::steady_timer finished;          // Cancelled once the last worker is done
+    };
+    
+    // One connection's worth of a segmented download: take the next unfinished segment
+    // until none are left
+    asio::awaitable<void> co_download_segments(std::shared_ptr<SegmentedJob> job) {
+        auto& segments = job->state.segments;
+        while (!job->stopped) {
+            while (job->next_segment < segments.size() && segments[job->next_segment].complete()) {
+                ++job->next_segment;
+            }
+            if (job->next_segment == segments.size()) {
+                co_return;
+            }
+            co_await co_download_segment(job, job->next_segment++);
+            job->state.save(job->state_path);
+        }
+    }
+    
+    // Fetch what is missing of one segment. Each attempt asks for the range after the
+    // bytes already written, and one that made progress starts the retry count over.
+    // Retries pass the same gate as co_execute_with_retry: enable_retry, then the
+    // client-wide retry budget, which also bounds a segment that keeps inching forward.
+    asio::awaitable<void> co_download_segment(std::shared_ptr<SegmentedJob> job, size_t index) {
+        DownloadSegment& segment = job->state.segments[index];
+        RetryState retry_state;
+        if (config_.enable_retry) {
+            retry_budget_.deposit();
+        }
+        auto take_retry = [this] {
+            if (!config_.enable_retry) {
+                return false;
+            }
+            if (config_.enable_retry_budget && !retry_budget_.try_withdraw()) {
+                ++retries_denied_;
+                return false;
+            }
+            return true;
+        };
+        
+        while (true) {
+            uint64_t offset = segment.start + segment.done;
+            HttpRequest request = job->request;
+            request.add_header("Range", "bytes=" + std::to_string(offset) + "-" + std::to_string(segment.end - 1));
+            
+            FileSink sink(io_context_.get_executor(), job->path, offset);
+            std::exception_ptr failure;
+            std::optional<std::chrono::milliseconds> delay;
+            try {
+                auto stream = co_await co_execute_stream(request);
+                int status = stream.status_code();
+                if (status == 206) {
+                    std::string expected = "bytes " + std::to_string(offset) + "-" + std::to_string(segment.end - 1) +
+                                           "/" + std::to_string(job->state.size);
+                    if (stream.get_header("Content-Range") != expected) {
+                        throw HttpError(make_error_code(error::protocol_error), true, "Unexpected Content-Range");
+                    }
+                    co_await stream.co_read_to(sink);
+                } else if (status == 200) {
+                    // The server ignored the Range, or If-Range found a different object
+                    job->discard_progress = true;
+                    throw HttpError(make_error_code(error::protocol_error), true,
+                                    "Server did not honor the Range request");
+                } else {
+                    // Same status handling as co_execute_with_retry
+                    std::optional<std::chrono::milliseconds> server_delay;
+                    if (config_.honor_retry_after) {
+                        server_delay = get_server_backoff(stream.head());
+                    }
+                    if (is_retryable_status(status) && retry_policy_.can_retry(retry_state) &&
+                        (!server_delay || *server_delay <= config_.max_retry_after) && take_retry()) {
+                        delay = server_delay ? *server_delay : retry_policy_.get_delay(retry_state);
+                        stream.close();
+                    } else {
+                        // Any other answer ends the download and is returned as is
+                        HttpResponse response = stream.head();
+                        response.set_body(co_await stream.co_read_all());
+                        if (!job->response) {
+                            job->response = std::move(response);
+                        }
+                        job->stop();
+                        co_return;
+                    }
+                }
+            } catch (...) {
+                failure = std::current_exception();
+            }
+            
+            segment.done += sink.written();
+            if (!failure && !delay) {
+                if (segment.complete()) {
+                    co_return;
+                }
+                failure = std::make_exception_ptr(HttpError(make_error_code(error::incomplete_body), true));
+            }
+            if (job->stopped) {
+                if (failure) {
+                    std::rethrow_exception(failure);
+                }
+                co_return;
+            }
+            
+            if (sink.written() > 0) {
+                retry_state.attempt = 0;
+            }
+            if (failure) {
+                bool retry = false;
+                try {
+                    std::rethrow_exception(failure);
+                } catch (const std::exception& e) {
+                    retry = retry_policy_.should_retry(e, retry_state);
+                }
+                if (!retry || !take_retry()) {
+                    std::rethrow_exception(failure);
+                }
+                delay = retry_policy_.get_delay(retry_state);
+            }
+            ++retries_;
+            ++retry_state.attempt;
+            
+            asio::steady_timer timer(io_context_);
+            timer.expires_after(*delay);
+            co_await timer.async_wait(asio::use_awaitable);
+        }
+    }
+    
+    // Splice up to `max` body bytes from the socket into `sink`, waiting (bounded by
+    // read_timeout) until the socket has data; 0 once the peer has closed
+    asio::awaitable<size_t> co_splice_body(asio::ip::tcp::socket& socket, FileSink& sink, uint64_t max) {
+        NonBlockingScope non_blocking(socket);
+        while (true) {
+            std::error_code ec;
+            size_t len = sink.splice_from(socket.native_handle(), max, ec);
+            if (!ec) {
+                co_return len;
+            }
+            if (ec == std::errc::resource_unavailable_try_again || ec == std::errc::operation_would_block) {
+                co_await co_with_timeout(socket.async_wait(asio::ip::tcp::socket::wait_read, asio::use_awaitable),
+                                         config_.read_timeout);
+            } else if (ec != std::errc::interrupted) {
+                throw std::system_error(ec, "splice failed");
+            }
+        }
+    }
+    
+    // Keep the connection's TLS session for the next handshake, if it can be resumed
+    static void remember_tls_session(SSL* ssl, ReconnectCache& reconnect) {
+        SSL_SESSION* session = SSL_get1_session(ssl);
+        if (!session) {
+            return;
+        }
+        if (SSL_SESSION_is_resumable(session)) {
+            reconnect.tls_session.reset(session, SSL_SESSION_free);
+        } else {
+            SSL_SESSION_free(session);
+        }
+    }
+    
+    // With `cached`, the endpoints of an earlier lookup are tried first, and the
+    // host is only resolved again if none of them answers
+    asio::awaitable<void> co_resolve_and_connect(asio::ip::tcp::socket& socket,
+                                                 const std::string& host,
+                                                 const std::string& port,
+                                                 asio::ip::tcp::resolver::results_type* cached = nullptr) {
+        if (cached && !cached->empty()) {
+            auto endpoints = std::exchange(*cached, {});
+            auto [ec, endpoint] = co_await asio::async_connect(socket, endpoints, asio::as_tuple(asio::use_awaitable));
+            if (!ec) {
+                *cached = std::move(endpoints);
+                co_return;
+            }
+            if (ec == asio::error::operation_aborted) {
+                throw std::system_error(ec);
+            }
+        }
+        
+        asio::ip::tcp::resolver resolver(io_context_);
+        auto endpoints = co_await resolver.async_resolve(host, port, asio::use_awaitable);
+        if (cached) {
+            *cached = endpoints;
+        }
+        co_await asio::async_connect(socket, endpoints, asio::use_awaitable);
+    }
+    
+    asio::awaitable<void> co_connect_socket(asio::ip::tcp::socket& socket, const UrlInfo& url_info,
+                                            asio::ip::tcp::resolver::results_type* cached = nullptr) {
+        std::string connect_host;
+        std::string connect_port;
+        
+        if (proxy_info_.type != ProxyType::NONE) {
+            connect_host = proxy_info_.host;
             connect_port = proxy_info_.port;
         } else {
             connect_host = url_info.host;
             connect_port = url_info.port;
         }
         
-        auto endpoints = co_await resolver.async_resolve(
-            connect_host, 
-            connect_port, 
-            asio::use_awaitable
-        );
-        
-        co_await asio::async_connect(socket, endpoints, asio::use_awaitable);
+        co_await co_with_timeout(co_resolve_and_connect(socket, connect_host, connect_port, cached),
+                                 config_.connect_timeout);
         
         if (proxy_info_.type == ProxyType::SOCKS5) {
-            co_await co_perform_socks5_handshake(socket, url_info);
+            co_await co_with_timeout(co_perform_socks5_handshake(socket, url_info),
+                                     config_.connect_timeout);
         }
     }
 
@@ -395,7 +1344,7 @@ private:
         
         std::string response(buffer.data(), len);
         if (!parse_connect_response(response)) {
-            throw std::runtime_error("Proxy CONNECT failed");
+            throw std::system_error(make_error_code(error::protocol_error), "Proxy CONNECT failed");
         }
     }
 
@@ -408,7 +1357,7 @@ private:
         co_await asio::async_read(socket, asio::buffer(response1), asio::use_awaitable);
         
         if (response1[0] != 0x05) {
-            throw std::runtime_error("Invalid SOCKS5 response");
+            throw std::system_error(make_error_code(error::protocol_error), "Invalid SOCKS5 response");
         }
         
         if (response1[1] == 0x02) {
@@ -419,10 +1368,10 @@ private:
             co_await asio::async_read(socket, asio::buffer(auth_response), asio::use_awaitable);
             
             if (auth_response[1] != 0x00) {
-                throw std::runtime_error("SOCKS5 authentication failed");
+                throw std::system_error(make_error_code(error::protocol_error), "SOCKS5 authentication failed");
             }
         } else if (response1[1] != 0x00) {
-            throw std::runtime_error("SOCKS5 method not accepted");
+            throw std::system_error(make_error_code(error::protocol_error), "SOCKS5 method not accepted");
         }
         
         std::string connect_req = build_socks5_connect(url_info.host, url_info.port);
@@ -432,7 +1381,7 @@ private:
         co_await asio::async_read(socket, asio::buffer(connect_response), asio::use_awaitable);
         
         if (connect_response[1] != 0x00) {
-            throw std::runtime_error("SOCKS5 connection failed");
+            throw std::system_error(make_error_code(error::protocol_error), "SOCKS5 connection failed");
         }
     }
 
@@ -460,20 +1409,55 @@ private:
             req << "Accept-Encoding: gzip, deflate\r\n";
         }
         
-        if (!request.body().empty()) {
+        if (const auto& source = request.body_source()) {
+            if (auto size = source->size()) {
+                req << "Content-Length: " << *size << "\r\n";
+            } else {
+                req << "Transfer-Encoding: chunked\r\n";
+            }
+        } else if (!request.body().empty()) {
             req << "Content-Length: " << request.body().size() << "\r\n";
         }
         
         req << "Connection: close\r\n";
         req << "\r\n";
         
-        if (!request.body().empty()) {
+        // A streamed body follows the head separately, see co_write_body
+        if (!request.body_source() && !request.body().empty()) {
             req << request.body();
         }
         
         return req.str();
     }
 
+    // Race `op` against a timer. When the timer wins, `op` is cancelled through its
+    // cancellation slot (closing out the pending socket operation) and asio::error::timed_out
+    // is thrown. A zero or negative timeout waits indefinitely.
+    template<typename T>
+    asio::awaitable<T> co_with_timeout(asio::awaitable<T> op, std::chrono::milliseconds timeout) {
+        if (timeout.count() <= 0) {
+            co_return co_await std::move(op);
+        }
+        
+        using namespace asio::experimental::awaitable_operators;
+        
+        std::exception_ptr error;
+        asio::steady_timer timer(io_context_);
+        timer.expires_after(timeout);
+        
+        auto result = co_await (co_capture(std::move(op), error) || timer.async_wait(asio::use_awaitable));
+        
+        if (result.index() == 1) {
+            throw std::system_error(asio::error::make_error_code(asio::error::timed_out));
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        if constexpr (!std::is_void_v<T>) {
+            co_return std::move(*std::get<0>(result));
+        }
+    }
+    
     template<typename AsyncReadStream>
     struct has_lowest_layer_impl {
         template<typename T>
@@ -493,92 +1477,333 @@ private:
         }
     }
 
+    // Send the request head, then the body when it comes from a BodySource. Each
+    // write is bounded by read_timeout, so a stalled upload fails like a stalled read.
+    template<typename AsyncWriteStream>
+    asio::awaitable<void> co_write_request(AsyncWriteStream& stream, const std::string& head,
+                                           const HttpRequest& request) {
+        co_await co_with_timeout(asio::async_write(stream, asio::buffer(head), asio::use_awaitable),
+                                 config_.read_timeout);
+        if (const auto& source = request.body_source()) {
+            co_await co_write_body(stream, *source);
+        }
+    }
+    
+    // Streams a source body with the framing build_request() announced: raw bytes
+    // checked against a known size, otherwise one chunk per piece. Pieces go out
+    // as they are produced, so memory use does not grow with the body.
+    template<typename AsyncWriteStream>
+    asio::awaitable<void> co_write_body(AsyncWriteStream& stream, BodySource& source) {
+        std::optional<uint64_t> size = source.size();
+        
+        // With Content-Length framing, file parts can go out through sendfile() even
+        // inside a composite body (e.g. multipart form data)
+        if constexpr (std::is_same_v<AsyncWriteStream, asio::ip::tcp::socket>) {
+            if (FileBodySource::supports_sendfile() && size) {
+                if (auto* file = dynamic_cast<FileBodySource*>(&source)) {
+                    co_await co_sendfile(stream, *file);
+                    co_return;
+                }
+                if (auto* composite = dynamic_cast<CompositeBodySource*>(&source)) {
+                    // Corked, so small parts between files share segments instead of
+                    // each going out (and waiting for an ACK) on its own
+                    set_cork(stream, true);
+                    try {
+                        for (const auto& part : composite->parts()) {
+                            co_await co_write_body(stream, *part);
+                        }
+                    } catch (...) {
+                        set_cork(stream, false);
+                        throw;
+                    }
+                    set_cork(stream, false);
+                    co_return;
+                }
+            }
+        }
+        
+        uint64_t sent = 0;
+        
+        while (true) {
+            std::string_view piece = co_await source.co_next();
+            if (piece.empty()) {
+                break;
+            }
+            sent += piece.size();
+            
+            if (size) {
+                if (sent > *size) {
+                    throw std::runtime_error("Request body is longer than its declared size");
+                }
+                co_await co_with_timeout(asio::async_write(stream, asio::buffer(piece.data(), piece.size()),
+                                                           asio::use_awaitable),
+                                         config_.read_timeout);
+                continue;
+            }
+            
+            // Chunk size line, data and trailing CRLF in one gather write
+            char size_line[24];
+            int line_len = std::snprintf(size_line, sizeof(size_line), "%zx\r\n", piece.size());
+            std::array<asio::const_buffer, 3> chunk = {
+                asio::buffer(size_line, static_cast<size_t>(line_len)),
+                asio::buffer(piece.data(), piece.size()),
+                asio::buffer("\r\n", 2)
+            };
+            co_await co_with_timeout(asio::async_write(stream, chunk, asio::use_awaitable), config_.read_timeout);
+        }
+        
+        if (size) {
+            if (sent != *size) {
+                throw std::runtime_error("Request body is shorter than its declared size");
+            }
+        } else {
+            static constexpr char last_chunk[] = "0\r\n\r\n";
+            co_await co_with_timeout(asio::async_write(stream, asio::buffer(last_chunk, sizeof(last_chunk) - 1),
+                                                       asio::use_awaitable),
+                                     config_.read_timeout);
+        }
+    }
+    
+    // File upload over plain TCP: sendfile() moves the data from the page cache to
+    // the socket, and we only wait for writability whenever the socket buffer fills
+    asio::awaitable<void> co_sendfile(asio::ip::tcp::socket& socket, FileBodySource& file) {
+        NonBlockingScope non_blocking(socket);
+        while (file.remaining() > 0) {
+            std::error_code ec;
+            file.send_to(socket.native_handle(), ec);
+            if (ec == std::errc::resource_unavailable_try_again || ec == std::errc::operation_would_block) {
+                co_await co_with_timeout(socket.async_wait(asio::ip::tcp::socket::wait_write, asio::use_awaitable),
+                                         config_.read_timeout);
+            } else if (ec && ec != std::errc::interrupted) {
+                throw std::system_error(ec, "sendfile failed");
+            }
+        }
+    }
+    
+    // Native non-blocking mode for a loop of direct system calls on the socket. The
+    // previous mode comes back however the loop ends, so a pooled connection is
+    // handed on the way it was found.
+    class NonBlockingScope {
+    public:
+        explicit NonBlockingScope(asio::ip::tcp::socket& socket)
+            : socket_(socket), previous_(socket.native_non_blocking()) {
+            socket_.native_non_blocking(true);
+        }
+        
+        ~NonBlockingScope() {
+            std::error_code ec;
+            socket_.native_non_blocking(previous_, ec);
+        }
+        
+        NonBlockingScope(const NonBlockingScope&) = delete;
+        NonBlockingScope& operator=(const NonBlockingScope&) = delete;
+    
+    private:
+        asio::ip::tcp::socket& socket_;
+        bool previous_;
+    };
+    
+    static void set_cork(asio::ip::tcp::socket& socket, bool cork) {
+#if defined(__linux__)
+        int value = cork ? 1 : 0;
+        ::setsockopt(socket.native_handle(), IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+#else
+        (void)socket;
+        (void)cork;
+#endif
+    }
+    
+    // Request body compression applies when the request asks for it, or the client
+    // is configured for it (for all hosts or this one), and the body is big enough
+    bool should_compress_body(const HttpRequest& request) const {
+        if (request.body().empty() && !request.body_source()) {
+            return false;
+        }
+        for (const auto& [key, value] : request.headers()) {
+            if (strcasecmp_parser(key, "Content-Encoding")) {
+                return false;  // Already encoded by the caller
+            }
+        }
+        
+        bool wanted = request.compress_body().value_or(
+            config_.compress_requests ||
+            (!config_.compress_request_hosts.empty() &&
+             config_.compress_request_hosts.count(parse_url(request.url()).host) > 0));
+        if (!wanted) {
+            return false;
+        }
+        
+        std::optional<uint64_t> size = request.body_source() ? request.body_source()->size()
+                                                             : std::optional<uint64_t>(request.body().size());
+        return !size || *size >= config_.request_compression_min_size;
+    }
+    
+    // Copy of `request` with its body compressed: in memory bodies at once, body
+    // sources while they are sent. zlib state comes from a pool shared by all requests.
+    HttpRequest compress_body(const HttpRequest& request) {
+        auto format = config_.request_compression == "deflate" ? Deflater::Format::deflate : Deflater::Format::gzip;
+        auto deflater = deflater_pool_.acquire(format, config_.request_compression_level);
+        
+        HttpRequest compressed = request;
+        compressed.add_header("Content-Encoding", deflater->encoding());
+        if (request.body_source()) {
+            compressed.set_body_source(std::make_shared<CompressedBodySource>(request.body_source(),
+                                                                              std::move(deflater)));
+        } else {
+            compressed.set_body(compress(request.body(), *deflater));
+        }
+        return compressed;
+    }
+    
+    // A streamed body must be produced again before the request can be resent
+    static bool rewind_body(const HttpRequest& request) {
+        const auto& source = request.body_source();
+        return !source || source->rewind();
+    }
+    
+    // Read a whole response. The body is dechunked and decompressed as it arrives and
+    // collected in memory, or in a temporary file past the spill threshold. Headers
+    // or a body above the request's (or client's) limits fail with
+    // error::response_too_large before the rest is read.
     template<typename AsyncReadStream>
-    asio::awaitable<std::string> co_read_response(AsyncReadStream& stream, HttpMethod request_method = HttpMethod::GET) {
-        std::string response_data;
+    asio::awaitable<HttpResponse> co_read_response(AsyncReadStream& stream, const HttpRequest& request) {
+        size_t max_header_size = request.max_response_header_size().value_or(config_.max_response_header_size);
+        uint64_t max_body_size = request.max_response_body_size().value_or(config_.max_response_body_size);
+        BodyCollector body(max_body_size,
+                           request.response_spill_threshold().value_or(config_.response_spill_threshold),
+                           config_.response_spill_directory);
+        
+        std::string head;
         std::array<char, 8192> buffer;
         
+        HttpResponse response;
         bool headers_complete = false;
-        size_t content_length = 0;
+        bool body_complete = false;
         bool is_chunked = false;
-        size_t headers_end_pos = 0;
+        bool has_content_length = false;
+        unsigned long long remaining = 0;
+        ChunkedDecoder chunked;
+        std::unique_ptr<Inflater> inflater;
+        std::string decoded;
+        
+        auto decode = [&](const char* data, size_t size) {
+            if (inflater) {
+                // One bounded step at a time, so the size limit stops a
+                // decompression bomb before it has been expanded
+                size_t used = 0;
+                do {
+                    decoded.clear();
+                    used += inflater->feed(data + used, size - used, decoded, Inflater::output_step);
+                    body.append(decoded.data(), decoded.size());
+                } while (used < size || inflater->stalled());
+            } else {
+                body.append(data, size);
+            }
+        };
+        
+        auto consume = [&](const char* data, size_t size) {
+            if (is_chunked) {
+                std::string chunk_data;
+                chunked.feed(data, size, chunk_data);
+                decode(chunk_data.data(), chunk_data.size());
+                body_complete = chunked.done();
+            } else if (has_content_length) {
+                size_t take = static_cast<size_t>(std::min<unsigned long long>(size, remaining));
+                decode(data, take);
+                remaining -= take;
+                body_complete = remaining == 0;
+            } else {
+                decode(data, size);
+            }
+        };
         
         while (true) {
-            auto [ec, len] = co_await stream.async_read_some(
-                asio::buffer(buffer),
-                asio::as_tuple(asio::use_awaitable)
+            auto [ec, len] = co_await co_with_timeout(
+                stream.async_read_some(asio::buffer(buffer), asio::as_tuple(asio::use_awaitable)),
+                config_.read_timeout
             );
             
             if (len > 0) {
-                response_data.append(buffer.data(), len);
-                
-                // Check if headers are complete
-                if (!headers_complete) {
-                    size_t header_end = response_data.find("\r\n\r\n");
+                if (headers_complete) {
+                    consume(buffer.data(), len);
+                } else {
+                    head.append(buffer.data(), len);
+                    size_t header_end = head.find("\r\n\r\n");
+                    size_t head_size = header_end == std::string::npos ? head.size() : header_end + 4;
+                    if (max_header_size > 0 && head_size > max_header_size) {
+                        throw std::system_error(make_error_code(error::response_too_large), "Response headers too large");
+                    }
+                    
                     if (header_end != std::string::npos) {
                         headers_complete = true;
-                        headers_end_pos = header_end + 4;
-                        
-                        // Parse headers to find Content-Length or Transfer-Encoding
-                        std::string headers = response_data.substr(0, headers_end_pos);
+                        std::string rest = head.substr(head_size);
+                        head.resize(head_size);
+                        response = parse_response_head(head);
                         
-                        // Check for chunked encoding
-                        if (headers.find("Transfer-Encoding: chunked") != std::string::npos ||
-                            headers.find("transfer-encoding: chunked") != std::string::npos) {
-                            is_chunked = true;
+                        // Per RFC, responses to HEAD must not include a message body.
+                        // Don't wait for a body for HEAD requests — treat response as complete.
+                        // The same holds for 204 and 304 answers (RFC 9112 section 6.3).
+                        if (request.method() == HttpMethod::HEAD || response.status_code() == 204 ||
+                            response.status_code() == 304) {
+                            break;
                         }
                         
-                        // Try to find Content-Length
-                        size_t cl_pos = headers.find("Content-Length:");
-                        if (cl_pos == std::string::npos) {
-                            cl_pos = headers.find("content-length:");
+                        std::string transfer_encoding = response.get_header("Transfer-Encoding");
+                        std::transform(transfer_encoding.begin(), transfer_encoding.end(), transfer_encoding.begin(), ::tolower);
+                        std::string content_encoding = response.get_header("Content-Encoding");
+                        std::transform(content_encoding.begin(), content_encoding.end(), content_encoding.begin(), ::tolower);
+                        std::string content_length = response.get_header("Content-Length");
+                        
+                        if (content_encoding == "gzip") {
+                            inflater = std::make_unique<Inflater>(Inflater::Format::gzip);
+                        } else if (content_encoding == "deflate") {
+                            inflater = std::make_unique<Inflater>(Inflater::Format::deflate);
                         }
-                        if (cl_pos != std::string::npos) {
-                            size_t value_start = headers.find(':', cl_pos) + 1;
-                            size_t value_end = headers.find('\r', value_start);
-                            std::string cl_str = headers.substr(value_start, value_end - value_start);
-                            // Trim whitespace
-                            cl_str.erase(0, cl_str.find_first_not_of(" \t"));
-                            cl_str.erase(cl_str.find_last_not_of(" \t") + 1);
+                        
+                        if (transfer_encoding.find("chunked") != std::string::npos) {
+                            is_chunked = true;
+                        } else if (!content_length.empty()) {
                             try {
-                                content_length = std::stoull(cl_str);
-                            } catch (...) {}
+                                remaining = std::stoull(content_length);
+                            } catch (...) {
+                                throw std::system_error(make_error_code(error::protocol_error), "Invalid Content-Length");
+                            }
+                            // An identity body's size is known up front
+                            if (!inflater && max_body_size > 0 && remaining > max_body_size) {
+                                throw std::system_error(make_error_code(error::response_too_large), "Response body too large");
+                            }
+                            has_content_length = true;
+                            body_complete = remaining == 0;
+                        }
+                        
+                        if (!rest.empty() && !body_complete) {
+                            consume(rest.data(), rest.size());
                         }
                     }
                 }
                 
-                // Check if we have complete body
-                if (headers_complete) {
-                    // Per RFC, responses to HEAD must not include a message body.
-                    // Don't wait for a body for HEAD requests — treat response as complete.
-                    if (request_method == HttpMethod::HEAD) {
-                        break;
-                    }
-                    size_t body_size = response_data.size() - headers_end_pos;
-                    
-                    if (is_chunked) {
-                        // For chunked, check if we have the final chunk (0\r\n\r\n)
-                        if (response_data.find("0\r\n\r\n") != std::string::npos) {
-                            break;
-                        }
-                    } else if (content_length > 0) {
-                        // For content-length, check if we have all data
-                        if (body_size >= content_length) {
-                            break;
-                        }
-                    }
+                if (body_complete) {
+                    break;
                 }
             }
             
             if (ec == asio::error::eof || ec == asio::ssl::error::stream_truncated) {
+                // Only a response whose headers arrived may be delimited by the close
+                if (!headers_complete) {
+                    throw std::system_error(make_error_code(
+                        head.empty() ? error::empty_response : error::eof_before_headers));
+                }
                 break;
             } else if (ec) {
+                if (head.empty() && classify_error(ec) == ErrorKind::connection_reset) {
+                    throw std::system_error(make_error_code(error::empty_response));
+                }
                 throw std::system_error(ec);
             }
             
             // Safety: if we have headers but no content length and no chunked,
             // and we got some data, try a short wait and then check for available bytes
-            if (headers_complete && !is_chunked && content_length == 0 && len > 0) {
+            if (headers_complete && !is_chunked && !has_content_length && len > 0) {
                 asio::steady_timer timer(io_context_);
                 timer.expires_after(std::chrono::milliseconds(100));
                 co_await timer.async_wait(asio::use_awaitable);
@@ -597,13 +1822,13 @@ private:
                 }
 
                 if (available_bytes > 0) {
-                    auto [peek_ec, peek_len] = co_await stream.async_read_some(
-                        asio::buffer(buffer),
-                        asio::as_tuple(asio::use_awaitable)
+                    auto [peek_ec, peek_len] = co_await co_with_timeout(
+                        stream.async_read_some(asio::buffer(buffer), asio::as_tuple(asio::use_awaitable)),
+                        config_.read_timeout
                     );
 
                     if (peek_len > 0) {
-                        response_data.append(buffer.data(), peek_len);
+                        consume(buffer.data(), peek_len);
                     }
                 } else {
                     // No more data, response complete
@@ -612,7 +1837,12 @@ private:
             }
         }
         
-        co_return response_data;
+        if (body.file()) {
+            response.set_body_file(body.file());
+        } else {
+            response.set_body(body.take());
+        }
+        co_return response;
     }
 
 public:
@@ -645,194 +1875,196 @@ public:
         co_return co_await co_execute(HttpRequest(HttpMethod::OPTIONS, url));
     }
 
-    // SSE streaming support with callback
-    // EventCallback: void(const SseEvent& event)
-    using SseEventCallback = std::function<void(const SseEvent&)>;
+    // Send `request` and return as soon as the status line and headers have arrived.
+    // The body is then pulled through the returned HttpResponseStream, which must not
+    // outlive the client. Redirects, retries and hedging are not applied; read_timeout
+    // bounds each read, including those of the body, and request_timeout the wait
+    // for the headers. The request's deadline, timeout and cancellation token cover
+    // the body as well. The stream holds the host's concurrency slot until the body
+    // has been read or the stream is closed.
+    asio::awaitable<HttpResponseStream> co_execute_stream(const HttpRequest& request) {
+        if (should_compress_body(request)) {
+            co_return co_await co_execute_stream(compress_body(request));
+        }
+        
+        auto deadline = request_deadline(request);
+        auto token = request.cancellation_token();
+        HttpRequest bounded = with_attempt_deadline(request);
+        auto open = co_with_timeout(co_open_stream(bounded), config_.request_timeout);
+        HttpResponseStream stream = deadline || token
+            ? co_await co_with_cancellation(std::move(open), deadline, token)
+            : co_await std::move(open);
+        stream.set_cancellation(deadline, token);
+        co_return std::move(stream);
+    }
     
-    asio::awaitable<void> co_stream_events(const HttpRequest& request, 
-                                           SseEventCallback callback) {
-        auto url_info = parse_url(request.url());
+    // Download the response body straight into the file at `path`, which is created
+    // or truncated. The body never sits in memory as a whole: it is spliced from the
+    // socket to the file where possible and written piece by piece otherwise. The
+    // returned response carries status and headers with an empty body. A non-2xx
+    // response is returned with its body instead and no file is written.
+    asio::awaitable<HttpResponse> co_download(const HttpRequest& request, const std::string& path) {
+        auto stream = co_await co_execute_stream(request);
+        HttpResponse response = stream.head();
+        if (stream.status_code() < 200 || stream.status_code() >= 300) {
+            response.set_body(co_await stream.co_read_all());
+            co_return response;
+        }
         
-        HttpRequest req_with_cookies = request;
-        if (config_.enable_cookies) {
-            std::string cookies = cookie_jar_.get_cookies_for_request(
-                url_info.host, url_info.path, url_info.is_https);
-            if (!cookies.empty()) {
-                req_with_cookies.add_header("Cookie", cookies);
-            }
+        FileSink sink(io_context_.get_executor(), path);
+        // The stream has already validated Content-Length; it is the file size
+        // unless the body is compressed
+        std::string content_length = stream.get_header("Content-Length");
+        if (!content_length.empty() && stream.get_header("Content-Encoding").empty()) {
+            sink.preallocate(std::stoull(content_length));
         }
         
-        if (url_info.is_https) {
-            co_await co_stream_events_https(req_with_cookies, url_info, callback);
-        } else {
-            co_await co_stream_events_http(req_with_cookies, url_info, callback);
+        try {
+            co_await stream.co_read_to(sink);
+        } catch (...) {
+            sink.finish();
+            throw;
         }
-        co_return;
+        sink.finish();
+        co_return response;
     }
     
-    asio::awaitable<void> co_stream_events_http(const HttpRequest& request, 
-                                                 const UrlInfo& url_info,
-                                                 SseEventCallback callback) {
-        rate_limiter_.acquire();
-        
-        asio::ip::tcp::socket socket(io_context_);
-        co_await co_connect_socket(socket, url_info);
-        
-        std::string request_str = build_request(request, url_info, config_.enable_compression);
-        co_await asio::async_write(socket, asio::buffer(request_str), asio::use_awaitable);
-        
-        std::array<char, 8192> buffer;
-        std::string partial_event;
-        SseEvent current_event;
-        std::vector<std::string> data_lines;
+    // Download a large object over several connections at once. A HEAD request gives
+    // its size, then the body is fetched as byte ranges of options.segment_size,
+    // options.connections at a time, each written into `path` at its offset. A failed
+    // segment is retried on its own under the client's retry policy and budget,
+    // continuing after the bytes it already wrote. Progress is kept in "<path>.part", so calling this
+    // again after an interruption fetches only what is missing, as long as the object's
+    // ETag or Last-Modified has not changed. Objects that are small, of unknown size or
+    // served without range support are downloaded with a single co_download() instead.
+    // Redirects are not followed.
+    asio::awaitable<HttpResponse> co_download(const HttpRequest& request, const std::string& path,
+                                              const SegmentedDownloadOptions& options) {
+        HttpRequest head_request(HttpMethod::HEAD, request.url());
+        HttpRequest range_request(HttpMethod::GET, request.url());
+        for (const auto& [key, value] : request.headers()) {
+            head_request.add_header(key, value);
+            range_request.add_header(key, value);
+        }
+        // Ranges must address the stored bytes, not a compressed encoding of them
+        head_request.add_header("Accept-Encoding", "identity");
+        range_request.add_header("Accept-Encoding", "identity");
         
-        // Read response headers first
-        std::string headers;
-        bool headers_complete = false;
+        auto head = co_await co_execute(head_request);
+        uint64_t size = 0;
+        try {
+            size = std::stoull(head.get_header("Content-Length"));
+        } catch (...) {}
+        std::string accept_ranges = head.get_header("Accept-Ranges");
+        std::transform(accept_ranges.begin(), accept_ranges.end(), accept_ranges.begin(), ::tolower);
+        
+        uint64_t segment_size = std::max<uint64_t>(options.segment_size, 1);
+        if (head.status_code() != 200 || !head.redirect_chain().empty() || accept_ranges != "bytes" ||
+            size <= segment_size || options.connections < 2) {
+            co_return co_await co_download(request, path);
+        }
         
-        while (!headers_complete) {
-            auto [ec, len] = co_await socket.async_read_some(
-                asio::buffer(buffer),
-                asio::as_tuple(asio::use_awaitable)
-            );
-            
-            if (ec) throw std::system_error(ec);
-            if (len == 0) throw std::runtime_error("Connection closed while reading headers");
-            
-            headers.append(buffer.data(), len);
-            size_t header_end = headers.find("\r\n\r\n");
-            if (header_end != std::string::npos) {
-                headers_complete = true;
-                partial_event = headers.substr(header_end + 4);
-                headers = headers.substr(0, header_end);
-            }
+        // If-Range needs a strong validator
+        std::string validator = head.get_header("ETag");
+        if (validator.empty() || validator.rfind("W/", 0) == 0) {
+            validator = head.get_header("Last-Modified");
+        }
+        if (!validator.empty()) {
+            range_request.add_header("If-Range", validator);
         }
         
-        // Stream event lines
-        while (true) {
-            auto [ec, len] = co_await socket.async_read_some(
-                asio::buffer(buffer),
-                asio::as_tuple(asio::use_awaitable)
-            );
-            
-            if (len > 0) {
-                partial_event.append(buffer.data(), len);
-                
-                // Process complete lines
-                size_t pos = 0;
-                while ((pos = partial_event.find('\n')) != std::string::npos) {
-                    std::string line = partial_event.substr(0, pos);
-                    partial_event = partial_event.substr(pos + 1);
-                    
-                    std::vector<SseEvent> events;
-                    parse_sse_line(line, current_event, data_lines, events);
-                    
-                    for (const auto& event : events) {
-                        callback(event);
+        auto job = std::make_shared<SegmentedJob>(io_context_, std::move(range_request), path);
+        std::optional<DownloadState> saved;
+        if (options.resume && !validator.empty() && std::ifstream(path, std::ios::binary).good()) {
+            saved = DownloadState::load(job->state_path);
+        }
+        if (saved && saved->size == size && saved->validator == validator) {
+            job->state = std::move(*saved);
+        } else {
+            job->state = DownloadState::split(size, validator, segment_size);
+            FileSink file(io_context_.get_executor(), path);
+            file.preallocate(size);
+        }
+        job->state.save(job->state_path);
+        
+        size_t workers = std::min<size_t>(static_cast<size_t>(options.connections), job->state.segments.size());
+        job->running = static_cast<int>(workers);
+        for (size_t i = 0; i < workers; ++i) {
+            job->signals.push_back(std::make_unique<asio::cancellation_signal>());
+            asio::co_spawn(io_context_, co_download_segments(job),
+                asio::bind_cancellation_slot(job->signals.back()->slot(), [job](std::exception_ptr e) {
+                    // Segments cancelled by stop() fail too; only the first real failure counts
+                    if (e && !job->stopped) {
+                        job->error = e;
+                        job->stop();
                     }
-                }
-            }
-            
-            // Check for end of stream or error
-            if (len == 0 || ec == asio::error::eof || (ec && ec != asio::error::would_block)) {
-                // Process any remaining data
-                if (!partial_event.empty()) {
-                    std::vector<SseEvent> events;
-                    parse_sse_line(partial_event, current_event, data_lines, events);
-                    for (const auto& event : events) {
-                        callback(event);
+                    if (--job->running == 0) {
+                        if (job->state.complete() || job->discard_progress) {
+                            std::remove(job->state_path.c_str());
+                        } else {
+                            job->state.save(job->state_path);
+                        }
+                        job->finished.cancel();
                     }
-                }
-                break;
-            }
+                }));
+        }
+        
+        co_await job->finished.async_wait(asio::as_tuple(asio::use_awaitable));
+        if (job->running > 0) {
+            // Cancelled from outside; the segments stop and record their progress
+            job->stop();
+            throw std::system_error(make_error_code(asio::error::operation_aborted));
+        }
+        if (job->error) {
+            std::rethrow_exception(job->error);
         }
-        co_return;
+        if (job->response) {
+            co_return std::move(*job->response);
+        }
+        co_return head;
+    }
+    
+    // SSE streaming support with callback
+    // EventCallback: void(const SseEvent& event)
+    using SseEventCallback = std::function<void(const SseEvent&)>;
+    
+    // With config.sse_reconnect the stream is resumed after it ends or fails, see
+    // co_stream_events_reconnecting(); it then only returns once the server
+    // answers 204, or fails
+    asio::awaitable<void> co_stream_events(const HttpRequest& request, 
+                                           SseEventCallback callback) {
+        co_await co_stream_events_into(request, callback, nullptr);
+    }
+    
+    // The same stream, pulled with co_await stream.next() or next_batch() instead of
+    // pushed to a callback. Events wait in a queue of options.capacity; when it is
+    // full, options.overflow decides whether reading pauses (block, the default),
+    // the oldest event is dropped, or the event replaces a queued one of its type
+    // (coalesce). Reading starts right away, on the client's io_context.
+    SseEventStream open_event_stream(const HttpRequest& request, SseStreamOptions options = {}) {
+        auto queue = std::make_shared<SseEventQueue>(io_context_.get_executor(), options);
+        auto stop = std::make_shared<asio::cancellation_signal>();
+        asio::co_spawn(io_context_, co_fill_event_queue(request, queue),
+            asio::bind_cancellation_slot(stop->slot(), [queue, stop](std::exception_ptr e) {
+                queue->close(e);
+            }));
+        return SseEventStream(queue, stop);
+    }
+    
+    // Event streams get a dedicated connection, since they can hold one
+    // indefinitely. The body goes through the same dechunking and gzip/deflate
+    // decoding as any streamed response. Event streams may legitimately stay quiet
+    // for long periods, so read_timeout only guards the response headers.
+    asio::awaitable<void> co_stream_events_http(const HttpRequest& request, 
+                                                 const UrlInfo& url_info,
+                                                 SseEventCallback callback) {
+        co_await co_stream_events_once(request, url_info, false, callback, nullptr);
     }
     
     asio::awaitable<void> co_stream_events_https(const HttpRequest& request,
                                                   const UrlInfo& url_info,
                                                   SseEventCallback callback) {
-        rate_limiter_.acquire();
-        
-        asio::ssl::stream<asio::ip::tcp::socket> ssl_socket(io_context_, ssl_context_);
-        
-        co_await co_connect_socket(ssl_socket.next_layer(), url_info);
-        
-        if (config_.verify_ssl) {
-            SSL_set_tlsext_host_name(ssl_socket.native_handle(), url_info.host.c_str());
-        }
-        
-        co_await ssl_socket.async_handshake(asio::ssl::stream_base::client, asio::use_awaitable);
-        
-        std::string request_str = build_request(request, url_info, config_.enable_compression);
-        co_await asio::async_write(ssl_socket, asio::buffer(request_str), asio::use_awaitable);
-        
-        std::array<char, 8192> buffer;
-        std::string partial_event;
-        SseEvent current_event;
-        std::vector<std::string> data_lines;
-        
-        // Read response headers first
-        std::string headers;
-        bool headers_complete = false;
-        
-        while (!headers_complete) {
-            auto [ec, len] = co_await ssl_socket.async_read_some(
-                asio::buffer(buffer),
-                asio::as_tuple(asio::use_awaitable)
-            );
-            
-            if (ec) throw std::system_error(ec);
-            if (len == 0) throw std::runtime_error("Connection closed while reading headers");
-            
-            headers.append(buffer.data(), len);
-            size_t header_end = headers.find("\r\n\r\n");
-            if (header_end != std::string::npos) {
-                headers_complete = true;
-                partial_event = headers.substr(header_end + 4);
-                headers = headers.substr(0, header_end);
-            }
-        }
-        
-        // Stream event lines
-        while (true) {
-            auto [ec, len] = co_await ssl_socket.async_read_some(
-                asio::buffer(buffer),
-                asio::as_tuple(asio::use_awaitable)
-            );
-            
-            if (len > 0) {
-                partial_event.append(buffer.data(), len);
-                
-                // Process complete lines
-                size_t pos = 0;
-                while ((pos = partial_event.find('\n')) != std::string::npos) {
-                    std::string line = partial_event.substr(0, pos);
-                    partial_event = partial_event.substr(pos + 1);
-                    
-                    std::vector<SseEvent> events;
-                    parse_sse_line(line, current_event, data_lines, events);
-                    
-                    for (const auto& event : events) {
-                        callback(event);
-                    }
-                }
-            }
-            
-            // Check for end of stream or error
-            if (len == 0 || ec == asio::error::eof || (ec && ec != asio::error::would_block)) {
-                // Process any remaining data
-                if (!partial_event.empty()) {
-                    std::vector<SseEvent> events;
-                    parse_sse_line(partial_event, current_event, data_lines, events);
-                    for (const auto& event : events) {
-                        callback(event);
-                    }
-                }
-                break;
-            }
-        }
-        co_return;
+        co_await co_stream_events_once(request, url_info, true, callback, nullptr);
     }
 
     template<typename CoroFunc>
@@ -869,6 +2101,64 @@ public:
         rate_limiter_.reset();
     }
     
+    // Per-host and per-route rate and concurrency limits
+    HostLimiterRegistry& host_limits() {
+        return host_limiter_;
+    }
+    
+    // Limiter state for a host: in-flight and queued requests, current concurrency
+    // limit and, with adaptive concurrency enabled, the measured RTT
+    std::optional<HostLimiterRegistry::Stats> get_host_limit_stats(const std::string& host,
+                                                                   const std::string& path = "/") {
+        return host_limiter_.get_stats(host, path);
+    }
+    
+    // Retry statistics
+    struct RetryStats {
+        uint64_t retries{0};           // retries sent
+        uint64_t retries_denied{0};    // retries skipped because the retry budget was empty
+        uint64_t stale_replays{0};     // requests resent after a pooled connection turned out closed
+    };
+    
+    RetryStats get_retry_stats() const {
+        return RetryStats{retries_.load(), retries_denied_.load(), stale_replays_.load()};
+    }
+    
+    // Requests that joined an identical one in flight instead of being sent
+    uint64_t get_coalesced_count() const {
+        return requests_coalesced_.load();
+    }
+    
+    // Circuit breaker state and transition counts for a "host:port"
+    CircuitBreaker::Stats get_circuit_stats(const std::string& host_port) const {
+        return circuit_breakers_.get_stats(host_port);
+    }
+    
+    // Hedged request statistics
+    struct HedgeStats {
+        uint64_t hedges_sent{0};
+        uint64_t hedges_won{0};
+    };
+    
+    HedgeStats get_hedge_stats() const {
+        return HedgeStats{hedges_sent_.load(), hedges_won_.load()};
+    }
+    
+    // Observed latency of a host ("host:port") at quantile q, if enough samples exist
+    std::optional<std::chrono::microseconds> get_host_latency(const std::string& host_key, double q) const {
+        return latency_tracker_.percentile(host_key, q);
+    }
+    
+    // Response cache hits, misses and size
+    HttpCache::Stats get_cache_stats() const {
+        return cache_.stats();
+    }
+    
+    // Drop every cached response
+    void clear_cache() {
+        cache_.clear();
+    }
+    
     // Get cookie jar
     CookieJar& cookies() {
         return cookie_jar_;
@@ -880,14 +2170,225 @@ public:
     }
 
 private:
+    // Events go to `callback`; with a `queue`, reading also waits for it to have room.
+    // The request's deadline, timeout and cancellation token end the whole stream,
+    // reconnects included.
+    asio::awaitable<void> co_stream_events_into(const HttpRequest& request, SseEventCallback& callback,
+                                                SseEventQueue* queue) {
+        auto deadline = request_deadline(request);
+        if (!deadline && !request.cancellation_token()) {
+            co_await co_stream_events_routed(request, callback, queue);
+            co_return;
+        }
+        co_await co_with_cancellation(co_stream_events_routed(request, callback, queue), deadline,
+                                      request.cancellation_token());
+    }
+    
+    asio::awaitable<void> co_stream_events_routed(const HttpRequest& request, SseEventCallback& callback,
+                                                  SseEventQueue* queue) {
+        auto url_info = parse_url(request.url());
+        if (config_.sse_reconnect) {
+            co_await co_stream_events_reconnecting(request, url_info, callback, queue);
+            co_return;
+        }
+        co_await co_stream_events_once(request, url_info, url_info.is_https, callback, queue);
+    }
+    
+    // An event stream holds its host slot only until the response head: the slot
+    // bounds how many exchanges the host is working on, and an open stream that
+    // may idle for hours would otherwise starve every other request to the host.
+    asio::awaitable<void> co_stream_events_once(const HttpRequest& request, const UrlInfo& url_info, bool https,
+                                                SseEventCallback& callback, SseEventQueue* queue) {
+        auto admitted = co_await co_admit(request, url_info);
+        auto stream = https
+            ? co_await co_open_https_stream(admitted.request, url_info, false, std::chrono::milliseconds(0))
+            : co_await co_open_http_stream(admitted.request, url_info, false, std::chrono::milliseconds(0));
+        admitted.host_permit.record_outcome(stream.status_code() >= 500 || stream.status_code() == 429);
+        admitted.host_permit.release();
+        
+        SseParser parser;
+        co_await co_read_events(stream, parser, callback, nullptr, queue);
+    }
+    
+    // Producer of an open_event_stream(); the queue is closed with its outcome
+    asio::awaitable<void> co_fill_event_queue(HttpRequest request, std::shared_ptr<SseEventQueue> queue) {
+        SseEventCallback push = [queue](const SseEvent& event) { queue->push(event); };
+        co_await co_stream_events_into(request, push, queue.get());
+    }
+    
+    // Parse the decoded body into events as it arrives. With `read_error`, a
+    // connection failure worth reconnecting after ends the stream and is stored
+    // there instead of thrown; exceptions from the callback always propagate.
+    // With `queue`, the next read waits until the queue has room.
+    asio::awaitable<void> co_read_events(HttpResponseStream& stream, SseParser& parser, SseEventCallback& callback,
+                                         std::exception_ptr* read_error = nullptr, SseEventQueue* queue = nullptr) {
+        std::array<char, 8192> buffer;
+        while (true) {
+            if (queue) {
+                co_await queue->co_wait_room();
+            }
+            size_t len = 0;
+            try {
+                len = co_await stream.co_read_some(asio::buffer(buffer));
+            } catch (const std::system_error& e) {
+                if (!read_error || !is_reconnectable(e.code())) {
+                    throw;
+                }
+                *read_error = std::current_exception();
+                co_return;
+            }
+            if (len == 0) {
+                break;
+            }
+            parser.feed(std::string_view(buffer.data(), len), callback);
+        }
+        parser.finish(callback);
+    }
+    
+    // Failures an event stream reconnects after: the connection went away or
+    // could not be made. TLS, protocol and status errors are not retried.
+    static bool is_reconnectable(const std::error_code& ec) {
+        switch (classify_error(ec)) {
+            case ErrorKind::connect_refused:
+            case ErrorKind::connection_reset:
+            case ErrorKind::eof_before_headers:
+            case ErrorKind::dns:
+            case ErrorKind::timeout:
+                return true;
+            default:
+                return false;
+        }
+    }
+    
+    // State of a reconnecting event stream across its connections
+    struct EventStreamSession {
+        SseParser parser;      // Keeps the last event ID and retry interval
+        ReconnectCache cache;
+        int failures{0};       // Consecutive attempts that failed
+        bool finished{false};  // The server answered 204: do not reconnect
+    };
+    
+    // An event stream that outlives its connections (config.sse_reconnect). When
+    // the stream ends or its connection fails, it waits for the server's retry:
+    // interval (sse_retry_delay until one is sent), doubled with jitter for each
+    // further consecutive failure up to sse_max_retry_delay, and reconnects with
+    // Last-Event-ID set so the server can resume where it stopped. Reconnects reuse
+    // the first DNS lookup and resume the TLS session. A 204 response ends the
+    // stream; a TLS or protocol error, a status other than 2xx or 5xx, or more
+    // than sse_max_reconnect_attempts consecutive failures fail it.
+    asio::awaitable<void> co_stream_events_reconnecting(const HttpRequest& request, const UrlInfo& url_info,
+                                                        SseEventCallback& callback, SseEventQueue* queue) {
+        EventStreamSession session;
+        
+        while (true) {
+            HttpRequest attempt = request;
+            if (!session.parser.last_event_id().empty()) {
+                attempt.add_header("Last-Event-ID", session.parser.last_event_id());
+            }
+            
+            std::exception_ptr failure = co_await co_event_stream_attempt(attempt, url_info, session, callback, queue);
+            if (session.finished) {
+                co_return;
+            }
+            if (failure) {
+                ++session.failures;
+                if (config_.sse_max_reconnect_attempts > 0 && session.failures > config_.sse_max_reconnect_attempts) {
+                    std::rethrow_exception(failure);
+                }
+            }
+            
+            asio::steady_timer timer(io_context_);
+            timer.expires_after(sse_reconnect_delay(session));
+            co_await timer.async_wait(asio::use_awaitable);
+        }
+    }
+    
+    // One connection of a reconnecting event stream. Returns the failure to
+    // reconnect after, or nullptr if the stream ended normally; throws what
+    // should end the stream instead. Like co_stream_events_once(), it holds the
+    // host slot only until the response head.
+    asio::awaitable<std::exception_ptr> co_event_stream_attempt(const HttpRequest& request, const UrlInfo& url_info,
+                                                                EventStreamSession& session, SseEventCallback& callback,
+                                                                SseEventQueue* queue) {
+        auto admitted = co_await co_admit(request, url_info);
+        
+        std::optional<HttpResponseStream> stream;
+        try {
+            if (url_info.is_https) {
+                stream.emplace(co_await co_open_https_stream(admitted.request, url_info, false,
+                                                             std::chrono::milliseconds(0), &session.cache));
+            } else {
+                stream.emplace(co_await co_open_http_stream(admitted.request, url_info, false,
+                                                            std::chrono::milliseconds(0), &session.cache));
+            }
+        } catch (const std::system_error& e) {
+            if (!is_reconnectable(e.code())) {
+                throw;
+            }
+            co_return std::current_exception();
+        }
+        
+        int status = stream->status_code();
+        admitted.host_permit.record_outcome(status >= 500 || status == 429);
+        admitted.host_permit.release();
+        if (status == 204) {
+            session.finished = true;
+            co_return nullptr;
+        }
+        if (status < 200 || status >= 300) {
+            std::system_error failure(make_error_code(error::unexpected_status),
+                                      "Event stream responded with status " + std::to_string(status));
+            if (status >= 500) {
+                co_return std::make_exception_ptr(failure);
+            }
+            throw failure;
+        }
+        
+        session.failures = 0;
+        session.parser.reset();
+        std::exception_ptr read_error;
+        co_await co_read_events(*stream, session.parser, callback, &read_error, queue);
+        co_return read_error;
+    }
+    
+    // The server's retry interval, doubled for each consecutive failure after the
+    // first and then jittered down by up to half, so clients that lost the same
+    // server do not all come back at once
+    std::chrono::milliseconds sse_reconnect_delay(const EventStreamSession& session) const {
+        auto delay = session.parser.retry().value_or(config_.sse_retry_delay);
+        if (session.failures <= 1) {
+            return delay;
+        }
+        double scaled = static_cast<double>(delay.count()) * std::pow(2.0, session.failures - 1);
+        scaled = std::min(scaled, static_cast<double>(config_.sse_max_retry_delay.count()));
+        scaled *= 0.5 + 0.5 * detail::thread_local_uniform();
+        return std::max(delay, std::chrono::milliseconds(static_cast<int64_t>(scaled)));
+    }
+    
     asio::io_context& io_context_;
     asio::ssl::context ssl_context_;
     ClientConfig config_;
     ProxyInfo proxy_info_;
     ConnectionPool connection_pool_;
     RateLimiter rate_limiter_;
+    HostLimiterRegistry host_limiter_;
+    CircuitBreakerRegistry circuit_breakers_;
     RetryPolicy retry_policy_;
+    TokenBudget retry_budget_;
+    std::atomic<uint64_t> retries_{0};
+    std::atomic<uint64_t> retries_denied_{0};
+    std::atomic<uint64_t> stale_replays_{0};
     CookieJar cookie_jar_;
+    LatencyTracker latency_tracker_;
+    TokenBudget hedge_budget_;
+    std::atomic<uint64_t> hedges_sent_{0};
+    std::atomic<uint64_t> hedges_won_{0};
+    DeflaterPool deflater_pool_;
+    HttpCache cache_;
+    std::unique_ptr<asio::thread_pool> disk_writer_;  // Declared after cache_: joined before it goes
+    std::mutex flights_mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Flight>> flights_;
+    std::atomic<uint64_t> requests_coalesced_{0};
 };
 
 }
@@ -0,0 +1,548 @@
+#pragma once
+
+#include "cache_entry.hpp"
+#include <zlib.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace coro_http {
+
+#if defined(_WIN32)
+
+// The disk tier needs positional I/O and mmap; it is not available on Windows
+class DiskCache {
+public:
+    struct Stats {
+        size_t entries{0};
+        uint64_t bytes{0};
+    };
+
+    DiskCache(const std::string&, uint64_t, uint64_t) {
+        throw std::system_error(std::make_error_code(std::errc::operation_not_supported),
+                                "Disk cache is not supported on this platform");
+    }
+
+    std::shared_ptr<CachedResponse> load(const std::string&) { return nullptr; }
+    bool store(const std::string&, CachedResponse&) { return false; }
+    void erase(const std::string&) {}
+    void clear() {}
+    Stats stats() const { return {}; }
+};
+
+#else
+
+// Persistent tier of the HTTP cache, so cached responses survive a restart.
+//
+// Responses are appended to segment files ("0000000001.seg", ...) in one directory
+// and never modified in place. Each record is a fixed header, the key, the
+// response metadata and (usually) the body; the header carries CRC32s of the rest.
+// The index is a map from key to record location, kept in memory and rebuilt from
+// the record headers when the cache is opened, so there is no separate index file
+// to keep consistent. A segment is fsync'd when the next one is started; only the
+// newest segment can end in a torn write, and it is cut back to its last intact
+// record on open.
+//
+// Large bodies are served straight from the segment files through mmap. When the
+// cache outgrows its budget, whole segments are dropped, oldest first.
+//
+// Writes are serialized by a lock of their own and do their I/O, fsync included,
+// without holding the index lock, so load() is never held up by a large body being
+// written. They still block the calling thread; callers on an io thread should
+// run store() and erase() elsewhere.
+class DiskCache {
+public:
+    struct Stats {
+        size_t entries{0};
+        uint64_t bytes{0};
+    };
+
+    DiskCache(const std::string& directory, uint64_t max_bytes, uint64_t segment_size)
+        : directory_(directory),
+          max_bytes_(max_bytes),
+          // Several segments per budget, so eviction never drops most of the cache at once
+          segment_size_(std::max<uint64_t>(std::min(segment_size, max_bytes / 4), 1)) {
+        std::error_code ec;
+        std::filesystem::create_directories(directory_, ec);
+        if (ec) {
+            throw std::system_error(ec, "Failed to create cache directory " + directory_);
+        }
+
+        std::vector<uint64_t> ids;
+        for (const auto& file : std::filesystem::directory_iterator(directory_)) {
+            std::string stem = file.path().stem().string();
+            if (file.path().extension() == ".seg" && !stem.empty() &&
+                std::all_of(stem.begin(), stem.end(), [](unsigned char c) { return std::isdigit(c); })) {
+                ids.push_back(std::stoull(stem));
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+        for (size_t i = 0; i < ids.size(); ++i) {
+            scan(*open_segment(ids[i]), i + 1 == ids.size());
+        }
+        if (segments_.empty()) {
+            open_segment(1);
+        }
+        evict();
+    }
+
+    DiskCache(const DiskCache&) = delete;
+    DiskCache& operator=(const DiskCache&) = delete;
+
+    // Stored response for `key`, or null. Bodies up to 64 KiB are read into
+    // memory; larger ones are mapped from the segment file, not copied.
+    std::shared_ptr<CachedResponse> load(const std::string& key) {
+        Location location;
+        std::shared_ptr<Segment> segment;
+        std::shared_ptr<Segment> body_segment;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = index_.find(key);
+            if (it == index_.end()) {
+                return nullptr;
+            }
+            location = it->second;
+            segment = segments_.at(location.segment);
+            body_segment = segments_.at(location.body.segment);
+        }
+
+        try {
+            std::string record(header_size + location.key_size + location.meta_size, '\0');
+            if (!read_at(segment->fd, record.data(), record.size(), location.offset) ||
+                std::string_view(record).substr(header_size, location.key_size) != key) {
+                return nullptr;
+            }
+            auto entry = decode_meta(std::string_view(record).substr(header_size + location.key_size));
+            if (!entry) {
+                return nullptr;
+            }
+
+            if (location.body.size <= inline_body_limit) {
+                std::string body(static_cast<size_t>(location.body.size), '\0');
+                if (!read_at(body_segment->fd, body.data(), body.size(), location.body.offset)) {
+                    return nullptr;
+                }
+                entry->response.set_body(std::move(body));
+            } else {
+                entry->response.set_body_file(
+                    BodyFile::map(body_segment, body_segment->fd, location.body.offset, location.body.size));
+            }
+            entry->disk_body = location.body;
+            return entry;
+        } catch (const std::exception&) {
+            return nullptr;
+        }
+    }
+
+    // Append `entry` under `key`. A body that is already on disk (the entry was
+    // revalidated) is referenced instead of written again, and a body spilled to a
+    // temporary file is switched over to the stored copy. Returns false when the
+    // entry could not be written, e.g. on a full disk; the cache then lacks it.
+    bool store(const std::string& key, CachedResponse& entry) {
+        std::string meta = encode_meta(entry);
+
+        std::lock_guard<std::mutex> write_lock(write_mutex_);
+        bool reuse = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            reuse = entry.disk_body && segments_.count(entry.disk_body->segment);
+        }
+        std::string_view body = reuse ? std::string_view() : entry.response.body_view();
+        if (header_size + key.size() + meta.size() + body.size() > max_bytes_) {
+            return false;
+        }
+
+        auto location = append(put_record, key, meta, body, reuse ? entry.disk_body : std::nullopt);
+        if (!location) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        index_[key] = *location;
+        if (!reuse && entry.response.body_file()) {
+            auto& segment = segments_.at(location->body.segment);
+            entry.response.set_body_file(BodyFile::map(segment, segment->fd, location->body.offset, location->body.size));
+        }
+        entry.disk_body = location->body;
+        evict();
+        return true;
+    }
+
+    // Forget `key`, durably: a tombstone record keeps it from coming back on reopen
+    void erase(const std::string& key) {
+        std::lock_guard<std::mutex> write_lock(write_mutex_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (index_.erase(key) == 0) {
+                return;
+            }
+        }
+        append(erase_record, key, "", {}, std::nullopt);
+        std::lock_guard<std::mutex> lock(mutex_);
+        evict();
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> write_lock(write_mutex_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t next = segments_.rbegin()->first + 1;
+        for (const auto& [id, segment] : segments_) {
+            ::unlink(segment->path.c_str());
+        }
+        segments_.clear();
+        index_.clear();
+        total_bytes_ = 0;
+        open_segment(next);
+    }
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return {index_.size(), total_bytes_};
+    }
+
+private:
+    static constexpr uint32_t record_magic = 0x31434843;  // "CHC1"
+    static constexpr size_t header_size = 48;
+    static constexpr uint32_t put_record = 0;
+    static constexpr uint32_t erase_record = 1;
+    static constexpr uint64_t inline_body_limit = 64 * 1024;
+
+    struct Segment {
+        uint64_t id{0};
+        std::string path;
+        int fd{-1};
+        uint64_t size{0};
+
+        ~Segment() {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    };
+
+    struct Location {
+        uint64_t segment{0};       // Segment holding the record
+        uint64_t offset{0};        // Start of the record
+        uint32_t key_size{0};
+        uint32_t meta_size{0};
+        DiskBody body;
+    };
+
+    // Bounds-checked reader over encoded fields
+    struct Reader {
+        std::string_view data;
+        bool ok{true};
+
+        template <typename T>
+        T read() {
+            T value{};
+            if (data.size() < sizeof(T)) {
+                ok = false;
+                return value;
+            }
+            std::memcpy(&value, data.data(), sizeof(T));
+            data.remove_prefix(sizeof(T));
+            return value;
+        }
+
+        std::string string() {
+            uint32_t size = read<uint32_t>();
+            if (!ok || size > data.size()) {
+                ok = false;
+                return {};
+            }
+            std::string value(data.substr(0, size));
+            data.remove_prefix(size);
+            return value;
+        }
+    };
+
+    template <typename T>
+    static void put(std::string& out, T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    static void put_string(std::string& out, std::string_view value) {
+        put(out, static_cast<uint32_t>(value.size()));
+        out.append(value);
+    }
+
+    static uint32_t checksum(uint32_t crc, std::string_view data) {
+        while (!data.empty()) {
+            uInt size = static_cast<uInt>(std::min<size_t>(data.size(), 1u << 30));
+            crc = static_cast<uint32_t>(::crc32(crc, reinterpret_cast<const Bytef*>(data.data()), size));
+            data.remove_prefix(size);
+        }
+        return crc;
+    }
+
+    static bool read_at(int fd, char* data, size_t size, uint64_t offset) {
+        while (size > 0) {
+            ssize_t n = ::pread(fd, data, size, static_cast<off_t>(offset));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            data += n;
+            size -= static_cast<size_t>(n);
+            offset += static_cast<uint64_t>(n);
+        }
+        return true;
+    }
+
+    static bool write_at(int fd, std::string_view data, uint64_t offset) {
+        while (!data.empty()) {
+            ssize_t n = ::pwrite(fd, data.data(), data.size(), static_cast<off_t>(offset));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            data.remove_prefix(static_cast<size_t>(n));
+            offset += static_cast<uint64_t>(n);
+        }
+        return true;
+    }
+
+    // Freshness is kept in wall-clock time on disk, since steady_clock restarts with the process
+    static int64_t to_wall_clock(std::chrono::steady_clock::time_point time) {
+        auto wall = std::chrono::system_clock::now() -
+                    std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::steady_clock::now() - time);
+        return std::chrono::duration_cast<std::chrono::milliseconds>(wall.time_since_epoch()).count();
+    }
+
+    static std::chrono::steady_clock::time_point from_wall_clock(int64_t millis) {
+        auto elapsed = std::chrono::system_clock::now() -
+                       std::chrono::system_clock::time_point(std::chrono::milliseconds(millis));
+        return std::chrono::steady_clock::now() -
+               std::chrono::duration_cast<std::chrono::steady_clock::duration>(elapsed);
+    }
+
+    static std::string encode_meta(const CachedResponse& entry) {
+        std::string out;
+        put(out, static_cast<uint32_t>(entry.response.status_code()));
+        put_string(out, entry.response.reason());
+        put(out, static_cast<uint32_t>(entry.response.headers().size()));
+        for (const auto& [key, value] : entry.response.headers()) {
+            put_string(out, key);
+            put_string(out, value);
+        }
+        put(out, static_cast<uint32_t>(entry.vary.size()));
+        for (const auto& [name, value] : entry.vary) {
+            put_string(out, name);
+            put_string(out, value);
+        }
+        put(out, to_wall_clock(entry.response_time));
+        put(out, static_cast<int64_t>(entry.initial_age.count()));
+        put(out, static_cast<int64_t>(entry.freshness_lifetime.count()));
+        put(out, static_cast<int64_t>(entry.stale_while_revalidate.count()));
+        put(out, static_cast<uint8_t>(entry.no_cache));
+        return out;
+    }
+
+    static std::shared_ptr<CachedResponse> decode_meta(std::string_view meta) {
+        Reader reader{meta};
+        auto entry = std::make_shared<CachedResponse>();
+        entry->response.set_status_code(static_cast<int>(reader.read<uint32_t>()));
+        entry->response.set_reason(reader.string());
+        for (uint32_t count = reader.read<uint32_t>(); reader.ok && count > 0; --count) {
+            std::string key = reader.string();
+            entry->response.add_header(key, reader.string());
+        }
+        for (uint32_t count = reader.read<uint32_t>(); reader.ok && count > 0; --count) {
+            std::string name = reader.string();
+            entry->vary.emplace_back(name, reader.string());
+        }
+        entry->response_time = from_wall_clock(reader.read<int64_t>());
+        entry->initial_age = std::chrono::seconds(reader.read<int64_t>());
+        entry->freshness_lifetime = std::chrono::seconds(reader.read<int64_t>());
+        entry->stale_while_revalidate = std::chrono::seconds(reader.read<int64_t>());
+        entry->no_cache = reader.read<uint8_t>() != 0;
+        return reader.ok ? entry : nullptr;
+    }
+
+    std::string segment_path(uint64_t id) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%010llu.seg", static_cast<unsigned long long>(id));
+        return directory_ + "/" + name;
+    }
+
+    std::shared_ptr<Segment> open_segment(uint64_t id) {
+        auto segment = std::make_shared<Segment>();
+        segment->id = id;
+        segment->path = segment_path(id);
+        segment->fd = ::open(segment->path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        struct stat st;
+        if (segment->fd < 0 || ::fstat(segment->fd, &st) != 0) {
+            throw std::system_error(errno, std::generic_category(), "Failed to open cache segment " + segment->path);
+        }
+        segment->size = static_cast<uint64_t>(st.st_size);
+        segments_[id] = segment;
+        return segment;
+    }
+
+    // Append one record to the newest segment, starting a new segment when it is
+    // full. `body_ref` points at a body already stored instead of writing `body`.
+    // Called with write_mutex_ held and mutex_ not; the record only becomes
+    // visible once the caller indexes it.
+    std::optional<Location> append(uint32_t kind, const std::string& key, std::string_view meta,
+                                   std::string_view body, std::optional<DiskBody> body_ref) {
+        uint64_t record_size = header_size + key.size() + meta.size() + body.size();
+        std::shared_ptr<Segment> segment;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            segment = segments_.rbegin()->second;
+        }
+        if (segment->size > 0 && segment->size + record_size > segment_size_) {
+            ::fsync(segment->fd);
+            std::lock_guard<std::mutex> lock(mutex_);
+            segment = open_segment(segment->id + 1);
+        }
+
+        uint64_t offset = segment->size;
+        DiskBody location = body_ref ? *body_ref
+            : DiskBody{segment->id, offset + header_size + key.size() + meta.size(), body.size(), checksum(0, body)};
+
+        std::string record;
+        record.reserve(header_size + key.size() + meta.size());
+        put(record, record_magic);
+        put(record, uint32_t{0});  // Header checksum, filled in below
+        put(record, kind);
+        put(record, static_cast<uint32_t>(key.size()));
+        put(record, static_cast<uint32_t>(meta.size()));
+        put(record, location.crc);
+        put(record, location.size);
+        put(record, location.segment);
+        put(record, location.offset);
+        record += key;
+        record += meta;
+        uint32_t crc = checksum(0, std::string_view(record).substr(8));
+        std::memcpy(record.data() + 4, &crc, sizeof(crc));
+
+        if (!write_at(segment->fd, record, offset) || !write_at(segment->fd, body, offset + record.size())) {
+            // The next record overwrites what was written; if there is none, the
+            // scan on reopen cuts the partial record off
+            (void)::ftruncate(segment->fd, static_cast<off_t>(offset));
+            return std::nullopt;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        segment->size = offset + record_size;
+        total_bytes_ += record_size;
+        return Location{segment->id, offset, static_cast<uint32_t>(key.size()), static_cast<uint32_t>(meta.size()),
+                        location};
+    }
+
+    // Replay a segment's records into the index. In the newest segment, inline
+    // bodies are verified too, as a crash may have left them half written.
+    // Everything from the first bad record on is cut off.
+    void scan(Segment& segment, bool newest) {
+        uint64_t offset = 0;
+        std::vector<char> buffer(1024 * 1024);
+        while (offset + header_size <= segment.size) {
+            char header[header_size];
+            if (!read_at(segment.fd, header, header_size, offset)) {
+                break;
+            }
+            Reader reader{std::string_view(header, header_size)};
+            uint32_t magic = reader.read<uint32_t>();
+            uint32_t crc = reader.read<uint32_t>();
+            uint32_t kind = reader.read<uint32_t>();
+            Location location{segment.id, offset, reader.read<uint32_t>(), reader.read<uint32_t>(), {}};
+            location.body.crc = reader.read<uint32_t>();
+            location.body.size = reader.read<uint64_t>();
+            location.body.segment = reader.read<uint64_t>();
+            location.body.offset = reader.read<uint64_t>();
+
+            uint64_t body_start = offset + header_size + location.key_size + location.meta_size;
+            bool inline_body = location.body.segment == segment.id && location.body.offset == body_start;
+            uint64_t end = body_start + (inline_body ? location.body.size : 0);
+            if (magic != record_magic || end > segment.size) {
+                break;
+            }
+
+            std::string rest(location.key_size + location.meta_size, '\0');
+            if (!read_at(segment.fd, rest.data(), rest.size(), offset + header_size) ||
+                checksum(checksum(0, std::string_view(header + 8, header_size - 8)), rest) != crc) {
+                break;
+            }
+            if (newest && inline_body) {
+                uint32_t body_crc = 0;
+                for (uint64_t done = 0; done < location.body.size;) {
+                    size_t size = static_cast<size_t>(std::min<uint64_t>(buffer.size(), location.body.size - done));
+                    if (!read_at(segment.fd, buffer.data(), size, body_start + done)) {
+                        break;
+                    }
+                    body_crc = checksum(body_crc, std::string_view(buffer.data(), size));
+                    done += size;
+                }
+                if (body_crc != location.body.crc) {
+                    break;
+                }
+            }
+
+            std::string key = rest.substr(0, location.key_size);
+            auto body_segment = segments_.find(location.body.segment);
+            bool body_present = inline_body ||
+                (body_segment != segments_.end() &&
+                 location.body.offset + location.body.size <=
+                     (location.body.segment == segment.id ? offset : body_segment->second->size));
+            if (kind == put_record && body_present) {
+                index_[key] = location;
+            } else {
+                index_.erase(key);
+            }
+            offset = end;
+        }
+
+        if (offset < segment.size && ::ftruncate(segment.fd, static_cast<off_t>(offset)) == 0) {
+            segment.size = offset;
+        }
+        total_bytes_ += segment.size;
+    }
+
+    // Drop whole segments, oldest first, until the cache fits its budget. Entries
+    // stored in them go too; popular ones are stored again when next fetched.
+    void evict() {
+        while (total_bytes_ > max_bytes_ && segments_.size() > 1) {
+            auto oldest = segments_.begin();
+            uint64_t id = oldest->first;
+            for (auto it = index_.begin(); it != index_.end();) {
+                if (it->second.segment == id || it->second.body.segment == id) {
+                    it = index_.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            total_bytes_ -= oldest->second->size;
+            ::unlink(oldest->second->path.c_str());
+            segments_.erase(oldest);
+        }
+    }
+
+    std::string directory_;
+    uint64_t max_bytes_;
+    uint64_t segment_size_;
+    std::mutex write_mutex_;        // Serializes appends, segment rotation and eviction
+    mutable std::mutex mutex_;      // Guards the index, the segment map and sizes
+    std::map<uint64_t, std::shared_ptr<Segment>> segments_;  // By id; the last one is appended to
+    std::unordered_map<std::string, Location> index_;
+    uint64_t total_bytes_{0};
+};
+
+#endif
+
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <asio.hpp>
+#include <asio/ssl.hpp>
+#include <string>
+#include <system_error>
+
+namespace coro_http {
+
+// Errors raised by the client itself. Transport errors keep their asio codes.
+enum class error {
+    empty_response = 1,      // Connection closed before any response byte arrived
+    eof_before_headers,      // Connection closed in the middle of the response headers
+    protocol_error,          // Malformed response, proxy or SOCKS5 reply
+    stale_connection,        // Reused keep-alive connection had been closed by the server
+    circuit_open,            // Host's circuit breaker is open; the request was not sent
+    incomplete_body,         // Connection closed before the framed response body ended
+    response_too_large,      // Response headers or body exceeded the configured limit
+    unexpected_status,       // Event stream answered with a status other than 2xx
+};
+
+}
+
+template<>
+struct std::is_error_code_enum<coro_http::error> : std::true_type {};
+
+namespace coro_http {
+
+class error_category_impl : public std::error_category {
+public:
+    const char* name() const noexcept override {
+        return "coro_http";
+    }
+    
+    std::string message(int value) const override {
+        switch (static_cast<error>(value)) {
+            case error::empty_response: return "Connection closed before any response was received";
+            case error::eof_before_headers: return "Connection closed while reading response headers";
+            case error::protocol_error: return "Protocol error";
+            case error::stale_connection: return "Pooled connection was closed by the server";
+            case error::circuit_open: return "Circuit breaker open for host";
+            case error::incomplete_body: return "Connection closed before the response body was complete";
+            case error::response_too_large: return "Response exceeds the configured size limit";
+            case error::unexpected_status: return "Unexpected response status";
+        }
+        return "Unknown error";
+    }
+};
+
+inline const std::error_category& error_category() {
+    static error_category_impl instance;
+    return instance;
+}
+
+inline std::error_code make_error_code(error e) {
+    return std::error_code(static_cast<int>(e), error_category());
+}
+
+// Coarse classification used to decide whether a failure is worth retrying
+enum class ErrorKind {
+    connect_refused,
+    connection_reset,
+    eof_before_headers,
+    tls,               // TLS connection cut short
+    tls_handshake,     // Handshake or certificate verification failed; retrying won't help
+    dns,               // Name resolution failed for now
+    dns_not_found,     // The name or service does not exist
+    timeout,
+    protocol,
+    cancelled,
+    other,
+};
+
+inline ErrorKind classify_error(const std::error_code& ec) {
+    if (ec.category() == error_category()) {
+        switch (static_cast<error>(ec.value())) {
+            case error::empty_response:
+            case error::eof_before_headers: return ErrorKind::eof_before_headers;
+            case error::stale_connection:
+            case error::incomplete_body: return ErrorKind::connection_reset;
+            case error::protocol_error:
+            case error::response_too_large: return ErrorKind::protocol;
+            case error::circuit_open:
+            case error::unexpected_status: return ErrorKind::other;
+        }
+        return ErrorKind::other;
+    }
+    
+    if (ec == asio::error::timed_out) return ErrorKind::timeout;
+    if (ec == asio::error::operation_aborted) return ErrorKind::cancelled;
+    if (ec == asio::error::connection_refused) return ErrorKind::connect_refused;
+    if (ec == asio::error::connection_reset || ec == asio::error::connection_aborted ||
+        ec == asio::error::broken_pipe || ec == asio::error::not_connected ||
+        ec == asio::error::network_reset || ec == asio::error::network_down ||
+        ec == asio::error::network_unreachable || ec == asio::error::host_unreachable) {
+        return ErrorKind::connection_reset;
+    }
+    if (ec == asio::error::eof) return ErrorKind::eof_before_headers;
+    if (ec == asio::error::host_not_found || ec == asio::error::no_data ||
+        ec == asio::error::service_not_found) {
+        return ErrorKind::dns_not_found;
+    }
+    if (ec == asio::error::host_not_found_try_again || ec == asio::error::no_recovery ||
+        ec.category() == asio::error::get_netdb_category() ||
+        ec.category() == asio::error::get_addrinfo_category()) {
+        return ErrorKind::dns;
+    }
+    // OpenSSL's own errors are the peer or its certificate being rejected; the
+    // stream category covers a connection that went away mid-TLS
+    if (ec.category() == asio::error::get_ssl_category()) {
+        return ErrorKind::tls_handshake;
+    }
+    if (ec.category() == asio::ssl::error::get_stream_category()) {
+        return ErrorKind::tls;
+    }
+    return ErrorKind::other;
+}
+
+// Failure of a request, carrying whether it may have reached the server.
+// A request that was never sent is always safe to retry; one that was sent may
+// already have been processed, so only idempotent requests should be replayed.
+// code() keeps the underlying error, e.g. asio::error::timed_out.
+class HttpError : public std::system_error {
+public:
+    HttpError(std::error_code ec, bool request_sent)
+        : std::system_error(ec), request_sent_(request_sent), what_(std::system_error::what()) {}
+    
+    HttpError(std::error_code ec, bool request_sent, const std::string& what)
+        : std::system_error(ec), request_sent_(request_sent), what_(what) {}
+    
+    bool request_sent() const noexcept { return request_sent_; }
+    ErrorKind kind() const { return classify_error(code()); }
+    
+    const char* what() const noexcept override { return what_.c_str(); }
+
+private:
+    bool request_sent_;
+    std::string what_;
+};
+
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "body_source.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <cstdio>
+#include <vector>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+
+namespace coro_http {
+
+// Request body read from a file without copying it into a std::string.
+// Over plain TCP on Linux the client hands the file to sendfile(2), so the data
+// goes from the page cache to the socket without entering user space. Elsewhere
+// (TLS, other platforms) the file is mapped a window at a time and the mapped
+// pages are written directly; only one window is mapped at any moment, so
+// memory use stays flat however large the file is.
+class FileBodySource : public BodySource {
+public:
+    explicit FileBodySource(const std::string& path, size_t window = 4 * 1024 * 1024) {
+#if defined(_WIN32)
+        file_ = std::fopen(path.c_str(), "rb");
+        if (!file_) {
+            throw std::system_error(errno, std::generic_category(), "Failed to open " + path);
+        }
+        _fseeki64(file_, 0, SEEK_END);
+        size_ = static_cast<uint64_t>(_ftelli64(file_));
+        _fseeki64(file_, 0, SEEK_SET);
+        buffer_.resize(std::max<size_t>(window, 65536));
+#else
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "Failed to open " + path);
+        }
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) {
+            int err = errno;
+            ::close(fd_);
+            throw std::system_error(err, std::generic_category(), "Failed to stat " + path);
+        }
+        size_ = static_cast<uint64_t>(st.st_size);
+        
+        // Mapping offsets must be page aligned
+        size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        window_ = std::max<size_t>((window + page - 1) / page * page, page);
+#endif
+    }
+    
+    ~FileBodySource() override {
+#if defined(_WIN32)
+        std::fclose(file_);
+#else
+        unmap();
+        ::close(fd_);
+#endif
+    }
+    
+    FileBodySource(const FileBodySource&) = delete;
+    FileBodySource& operator=(const FileBodySource&) = delete;
+    
+    asio::awaitable<std::string_view> co_next() override {
+        co_return next_window();
+    }
+    
+    std::optional<uint64_t> size() const override { return size_; }
+    
+    bool rewind() override {
+#if defined(_WIN32)
+        _fseeki64(file_, 0, SEEK_SET);
+#else
+        unmap();
+#endif
+        offset_ = 0;
+        return true;
+    }
+    
+    // Bytes not yet handed out
+    uint64_t remaining() const { return size_ - offset_; }
+    
+    // Whether send_to() can move the file to a socket inside the kernel
+    static constexpr bool supports_sendfile() {
+#if defined(__linux__)
+        return true;
+#else
+        return false;
+#endif
+    }
+    
+    // Send as much of the rest of the file to a non-blocking socket as it takes
+    // right now. Sets `ec` (e.g. to would_block when the socket buffer is full)
+    // instead of throwing, so the caller can wait for writability and go on.
+    void send_to(asio::ip::tcp::socket::native_handle_type socket_fd, std::error_code& ec) {
+        ec.clear();
+#if defined(__linux__)
+        unmap();
+        off_t offset = static_cast<off_t>(offset_);
+        size_t count = static_cast<size_t>(std::min<uint64_t>(remaining(), 0x7ffff000));
+        ssize_t sent = ::sendfile(socket_fd, fd_, &offset, count);
+        if (sent < 0) {
+            ec = std::error_code(errno, std::system_category());
+            return;
+        }
+        if (sent == 0 && count > 0) {
+            throw std::runtime_error("File was truncated while being sent");
+        }
+        offset_ += static_cast<uint64_t>(sent);
+#else
+        (void)socket_fd;
+        ec = std::make_error_code(std::errc::operation_not_supported);
+#endif
+    }
+
+private:
+    std::string_view next_window() {
+        if (offset_ >= size_) {
+            return {};
+        }
+#if defined(_WIN32)
+        size_t len = std::fread(buffer_.data(), 1, static_cast<size_t>(std::min<uint64_t>(buffer_.size(), remaining())), file_);
+        if (len == 0) {
+            throw std::runtime_error("File was truncated while being sent");
+        }
+        offset_ += len;
+        return std::string_view(buffer_.data(), len);
+#else
+        unmap();
+        size_t len = static_cast<size_t>(std::min<uint64_t>(window_, remaining()));
+        void* data = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd_, static_cast<off_t>(offset_));
+        if (data == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "Failed to map upload file");
+        }
+        ::madvise(data, len, MADV_SEQUENTIAL);
+        mapped_ = data;
+        mapped_size_ = len;
+        offset_ += len;
+        return std::string_view(static_cast<const char*>(data), len);
+#endif
+    }
+
+#if !defined(_WIN32)
+    void unmap() {
+        if (mapped_) {
+            ::munmap(mapped_, mapped_size_);
+            mapped_ = nullptr;
+        }
+    }
+    
+    int fd_{-1};
+    size_t window_{0};
+    void* mapped_{nullptr};
+    size_t mapped_size_{0};
+#else
+    std::FILE* file_{nullptr};
+    std::vector<char> buffer_;
+#endif
+    uint64_t size_{0};
+    uint64_t offset_{0};
+};
+
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <asio.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <cstdio>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Files opened by path are POSIX descriptors; asio file objects are used on top of them
+#if defined(ASIO_HAS_FILE) && !defined(_WIN32)
+#define CORO_HTTP_ASIO_FILE 1
+#endif
+
+namespace coro_http {
+
+// Response body destination that writes straight to a file.
+// Writes go through asio::random_access_file when asio has file support (io_uring
+// on Linux with ASIO_HAS_IO_URING), and through plain positional writes otherwise.
+// On Linux a plain-TCP body can also be moved socket -> pipe -> file with
+// splice(2), so it never enters user space at all.
+class FileSink {
+public:
+    FileSink(const asio::any_io_executor& executor, const std::string& path)
+        : FileSink(executor, path, 0, true) {}
+    
+    // Write into an existing file (created if missing) starting at `offset`, leaving
+    // the rest of it alone; several sinks can fill different ranges of one file
+    FileSink(const asio::any_io_executor& executor, const std::string& path, uint64_t offset)
+        : FileSink(executor, path, offset, false) {}
+    
+    ~FileSink() {
+#if defined(_WIN32)
+        std::fclose(file_);
+#else
+#if defined(__linux__)
+        if (pipe_[0] >= 0) {
+            ::close(pipe_[0]);
+            ::close(pipe_[1]);
+        }
+#endif
+#if !defined(CORO_HTTP_ASIO_FILE)
+        ::close(fd_);
+#endif
+#endif
+    }
+    
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+    
+    // Reserve disk space for a body of known size, so the file is laid out in one
+    // piece and a full disk fails up front. Best effort: ignored where unsupported.
+    void preallocate(uint64_t size) {
+#if defined(__linux__)
+        if (size > 0 && ::fallocate(fd_, 0, 0, static_cast<off_t>(size)) == 0) {
+            preallocated_ = size;
+        }
+#else
+        (void)size;
+#endif
+    }
+    
+    asio::awaitable<void> co_write(const char* data, size_t size) {
+#if defined(CORO_HTTP_ASIO_FILE)
+        co_await asio::async_write_at(file_, offset_ + written_, asio::buffer(data, size), asio::use_awaitable);
+        written_ += size;
+#elif defined(_WIN32)
+        if (std::fwrite(data, 1, size, file_) != size) {
+            throw std::system_error(errno, std::generic_category(), "Failed to write download file");
+        }
+        written_ += size;
+#else
+        while (size > 0) {
+            ssize_t n = ::pwrite(fd_, data, size, static_cast<off_t>(offset_ + written_));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw std::system_error(errno, std::generic_category(), "Failed to write download file");
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+            written_ += static_cast<uint64_t>(n);
+        }
+#endif
+        co_return;
+    }
+    
+    // Whether splice_from() can move socket data to the file inside the kernel
+    static constexpr bool supports_splice() {
+#if defined(__linux__)
+        return true;
+#else
+        return false;
+#endif
+    }
+    
+    // Move up to `max` bytes from a non-blocking socket to the end of the file.
+    // Returns 0 at end of stream. Sets `ec` (would_block when nothing is ready
+    // yet) instead of throwing, so the caller can wait for readability.
+    size_t splice_from(asio::ip::tcp::socket::native_handle_type socket_fd, uint64_t max, std::error_code& ec) {
+        ec.clear();
+#if defined(__linux__)
+        if (pipe_[0] < 0 && ::pipe2(pipe_, O_NONBLOCK | O_CLOEXEC) != 0) {
+            ec = std::error_code(errno, std::system_category());
+            return 0;
+        }
+        
+        size_t count = static_cast<size_t>(std::min<uint64_t>(max, 1024 * 1024));
+        ssize_t in = ::splice(socket_fd, nullptr, pipe_[1], nullptr, count, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (in < 0) {
+            ec = std::error_code(errno, std::system_category());
+            return 0;
+        }
+        
+        // Drain the pipe completely so it is empty again for the next call
+        size_t pending = static_cast<size_t>(in);
+        while (pending > 0) {
+            loff_t offset = static_cast<loff_t>(offset_ + written_);
+            ssize_t out = ::splice(pipe_[0], nullptr, fd_, &offset, pending, SPLICE_F_MOVE);
+            if (out < 0) {
+                if (errno == EINTR) continue;
+                throw std::system_error(errno, std::generic_category(), "Failed to write download file");
+            }
+            pending -= static_cast<size_t>(out);
+            written_ += static_cast<uint64_t>(out);
+        }
+        return static_cast<size_t>(in);
+#else
+        (void)socket_fd;
+        (void)max;
+        ec = std::make_error_code(std::errc::operation_not_supported);
+        return 0;
+#endif
+    }
+    
+    // Bytes written so far, counted from the starting offset
+    uint64_t written() const { return written_; }
+    
+    // Drop preallocated space the body did not fill (a shorter decoded body, or
+    // an interrupted download)
+    void finish() {
+#if !defined(_WIN32)
+        if (preallocated_ > written_) {
+            if (::ftruncate(fd_, static_cast<off_t>(offset_ + written_)) != 0) {
+                throw std::system_error(errno, std::generic_category(), "Failed to truncate download file");
+            }
+            preallocated_ = written_;
+        }
+#else
+        std::fflush(file_);
+#endif
+    }
+
+private:
+    FileSink(const asio::any_io_executor& executor, const std::string& path, uint64_t offset, bool truncate)
+#if defined(CORO_HTTP_ASIO_FILE)
+        : file_(executor), offset_(offset)
+#else
+        : offset_(offset)
+#endif
+    {
+        (void)executor;
+#if defined(_WIN32)
+        file_ = std::fopen(path.c_str(), truncate ? "wb" : "r+b");
+        if (!file_ && !truncate) {
+            file_ = std::fopen(path.c_str(), "w+b");
+        }
+        if (!file_ || _fseeki64(file_, static_cast<long long>(offset), SEEK_SET) != 0) {
+            throw std::system_error(errno, std::generic_category(), "Failed to create " + path);
+        }
+#else
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : 0), 0644);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "Failed to create " + path);
+        }
+#if defined(CORO_HTTP_ASIO_FILE)
+        file_.assign(fd_);
+#endif
+#endif
+    }
+    
+#if defined(_WIN32)
+    std::FILE* file_{nullptr};
+#else
+#if defined(CORO_HTTP_ASIO_FILE)
+    asio::random_access_file file_;
+#endif
+    int fd_{-1};
+#if defined(__linux__)
+    int pipe_[2]{-1, -1};
+#endif
+#endif
+    uint64_t offset_{0};
+    uint64_t preallocated_{0};
+    uint64_t written_{0};
+};
+
+}
@@ -1,9 +1,16 @@
 #pragma once
 
+#include "body_source.hpp"
+#include "file_body.hpp"
+#include "http_request.hpp"
 #include <string>
+#include <string_view>
 #include <map>
+#include <memory>
+#include <random>
 #include <sstream>
 #include <iomanip>
+#include <vector>
 
 namespace coro_http {
 
@@ -85,4 +92,126 @@ private:
     std::map<std::string, std::string> fields_;
 };
 
+// Form data for multipart/form-data, encoded lazily. Text fields, caller-owned
+// buffers and files become a sequence of body sources with a precomputed total
+// size, so the form is sent with Content-Length and file contents are never
+// copied into memory; over plain HTTP they go out through sendfile().
+class MultipartFormData {
+public:
+    MultipartFormData() : boundary_(make_boundary()) {}
+    
+    // Add a text field
+    MultipartFormData& add(const std::string& name, const std::string& value) {
+        add_part(name, "", "", std::make_shared<MemoryBodySource>(value));
+        return *this;
+    }
+    
+    // Add a part whose data stays owned by the caller until the request is sent
+    MultipartFormData& add_buffer(const std::string& name, std::string_view data, const std::string& filename = "",
+                                  const std::string& content_type = "application/octet-stream") {
+        add_part(name, filename, content_type, std::make_shared<ViewBodySource>(data));
+        return *this;
+    }
+    
+    // Add a file part; the file is opened now and read while the request is sent
+    MultipartFormData& add_file(const std::string& name, const std::string& path, std::string filename = "",
+                                const std::string& content_type = "application/octet-stream") {
+        if (filename.empty()) {
+            filename = path.substr(path.find_last_of("/\\") + 1);
+        }
+        add_part(name, filename, content_type, std::make_shared<FileBodySource>(path));
+        return *this;
+    }
+    
+    // Content-Type header value, including the boundary
+    std::string content_type() const {
+        return "multipart/form-data; boundary=" + boundary_;
+    }
+    
+    const std::string& boundary() const { return boundary_; }
+    
+    // Exact size of the encoded body. Summed from the parts' sizes, so it does not
+    // disturb a body_source() that is being sent.
+    uint64_t content_length() const {
+        uint64_t total = closing_delimiter().size();
+        for (const auto& part : parts_) {
+            total += *part->size();
+        }
+        return total;
+    }
+    
+    // The encoded form as a body source, starting from the beginning. Parts are
+    // shared with the form, so only one request may send it at a time.
+    std::shared_ptr<BodySource> body_source() const {
+        std::vector<std::shared_ptr<BodySource>> parts = parts_;
+        parts.push_back(std::make_shared<MemoryBodySource>(closing_delimiter()));
+        auto source = std::make_shared<CompositeBodySource>(std::move(parts));
+        source->rewind();
+        return source;
+    }
+    
+    // Set the request's Content-Type and body source
+    void apply_to(HttpRequest& request) const {
+        request.add_header("Content-Type", content_type());
+        request.set_body_source(body_source());
+    }
+    
+    bool empty() const {
+        return parts_.empty();
+    }
+
+private:
+    static std::string make_boundary() {
+        static const char alphabet[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+        std::random_device device;
+        std::mt19937 generator(device());
+        std::uniform_int_distribution<size_t> pick(0, sizeof(alphabet) - 2);
+        
+        std::string boundary = "----CoroHttpFormBoundary";
+        for (int i = 0; i < 24; ++i) {
+            boundary += alphabet[pick(generator)];
+        }
+        return boundary;
+    }
+    
+    std::string closing_delimiter() const {
+        return "--" + boundary_ + "--\r\n";
+    }
+    
+    // Quotes and line breaks in names are percent-encoded, as browsers do
+    static std::string escape_quoted(const std::string& value) {
+        std::string escaped;
+        for (char c : value) {
+            switch (c) {
+                case '"': escaped += "%22"; break;
+                case '\r': escaped += "%0D"; break;
+                case '\n': escaped += "%0A"; break;
+                default: escaped += c; break;
+            }
+        }
+        return escaped;
+    }
+    
+    void add_part(const std::string& name, const std::string& filename, const std::string& content_type,
+                  std::shared_ptr<BodySource> data) {
+        std::string header = "--" + boundary_ + "\r\nContent-Disposition: form-data; name=\"" +
+                             escape_quoted(name) + "\"";
+        if (!filename.empty()) {
+            header += "; filename=\"" + escape_quoted(filename) + "\"";
+        }
+        header += "\r\n";
+        if (!content_type.empty()) {
+            header += "Content-Type: " + content_type + "\r\n";
+        }
+        header += "\r\n";
+        
+        parts_.push_back(std::make_shared<MemoryBodySource>(std::move(header)));
+        parts_.push_back(std::move(data));
+        parts_.push_back(std::make_shared<MemoryBodySource>("\r\n"));
+    }
+    
+    std::string boundary_;
+    std::vector<std::shared_ptr<BodySource>> parts_;
+};
+
 }
@@ -0,0 +1,426 @@
+#pragma once
+
+#include "rate_limiter.hpp"
+#include "adaptive_limiter.hpp"
+#include <asio.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace coro_http {
+
+// Limits applied to one host, or to one path prefix of a host
+struct HostLimit {
+    int max_requests{0};                        // requests per window, 0 = no rate limit
+    std::chrono::milliseconds window{1000};
+    int max_in_flight{0};                       // concurrent requests, 0 = unlimited
+};
+
+// Rate and concurrency limits keyed by host and, optionally, path prefix.
+// Every host (or host + route) gets its own limiter entry, created on first use and
+// dropped again once it has been idle for idle_timeout, so memory stays bounded no
+// matter how many hosts are contacted. Requests over the concurrency cap queue in
+// FIFO order without blocking the io thread. With an adaptive limit enabled, each
+// entry's cap additionally follows the upstream's latency and error signals.
+// A host can also be paused as a whole when it asks for backoff (429/Retry-After).
+class HostLimiterRegistry {
+    struct Waiter {
+        explicit Waiter(const asio::any_io_executor& executor) : timer(executor) {}
+        
+        asio::steady_timer timer;
+        bool granted{false};
+    };
+    
+    enum class Outcome { none, ok, overloaded };
+    
+    struct Entry {
+        Entry(const HostLimit& limit, const std::optional<AdaptiveLimit>& adaptive_limit)
+            : limit(limit),
+              rate(limit.max_requests, limit.window),
+              last_used(std::chrono::steady_clock::now()) {
+            if (adaptive_limit) {
+                adaptive.emplace(*adaptive_limit);
+            }
+        }
+        
+        // Current concurrency cap, 0 = unlimited. Caller holds the mutex.
+        int cap() const {
+            if (!adaptive) {
+                return limit.max_in_flight;
+            }
+            return limit.max_in_flight > 0 ? std::min(limit.max_in_flight, adaptive->limit())
+                                           : adaptive->limit();
+        }
+        
+        // Feed the adaptive limit, then hand freed slots to waiters in order
+        void release(Outcome outcome, std::chrono::microseconds rtt) {
+            std::vector<std::shared_ptr<Waiter>> woken;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                last_used = std::chrono::steady_clock::now();
+                if (adaptive && outcome != Outcome::none) {
+                    adaptive->on_sample(rtt, in_flight, outcome == Outcome::overloaded);
+                }
+                --in_flight;
+                
+                int max_in_flight = cap();
+                while (!waiters.empty() && (max_in_flight <= 0 || in_flight < max_in_flight)) {
+                    ++in_flight;
+                    waiters.front()->granted = true;
+                    woken.push_back(std::move(waiters.front()));
+                    waiters.pop_front();
+                }
+            }
+            for (auto& waiter : woken) {
+                asio::post(waiter->timer.get_executor(), [waiter]() { waiter->timer.cancel(); });
+            }
+        }
+        
+        bool idle_since(std::chrono::steady_clock::time_point cutoff) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return in_flight == 0 && waiters.empty() && last_used < cutoff;
+        }
+        
+        HostLimit limit;
+        RateLimiter rate;
+        std::mutex mutex;
+        int in_flight{0};
+        std::deque<std::shared_ptr<Waiter>> waiters;
+        std::chrono::steady_clock::time_point last_used;
+        std::optional<AdaptiveLimiter> adaptive;
+    };
+
+public:
+    // Holds a concurrency slot until destroyed. An empty permit holds nothing.
+    class Permit {
+    public:
+        Permit() = default;
+        Permit(Permit&& other) noexcept
+            : entry_(std::move(other.entry_)), started_(other.started_), outcome_(other.outcome_), rtt_(other.rtt_) {}
+        
+        Permit& operator=(Permit&& other) noexcept {
+            if (this != &other) {
+                release();
+                entry_ = std::move(other.entry_);
+                started_ = other.started_;
+                outcome_ = other.outcome_;
+                rtt_ = other.rtt_;
+            }
+            return *this;
+        }
+        
+        Permit(const Permit&) = delete;
+        Permit& operator=(const Permit&) = delete;
+        
+        ~Permit() { release(); }
+        
+        // Report how the request went; the adaptive limit learns from it on release.
+        // The time until now is the sample's RTT, so a streamed response can report at
+        // its head and keep the slot while the body is read. Requests released
+        // without an outcome (e.g. cancelled) are not sampled.
+        void record_outcome(bool overloaded) {
+            outcome_ = overloaded ? Outcome::overloaded : Outcome::ok;
+            rtt_ = std::chrono::duration_cast<std::chrono::microseconds>(elapsed());
+        }
+        
+        // Time since the slot was granted
+        std::chrono::steady_clock::duration elapsed() const {
+            return std::chrono::steady_clock::now() - started_;
+        }
+        
+        void release() {
+            if (entry_) {
+                entry_->release(outcome_, rtt_);
+                entry_.reset();
+            }
+        }
+    
+    private:
+        friend class HostLimiterRegistry;
+        explicit Permit(std::shared_ptr<Entry> entry)
+            : entry_(std::move(entry)), started_(std::chrono::steady_clock::now()) {}
+        
+        std::shared_ptr<Entry> entry_;
+        std::chrono::steady_clock::time_point started_;
+        Outcome outcome_{Outcome::none};
+        std::chrono::microseconds rtt_{0};
+    };
+    
+    struct Stats {
+        int in_flight{0};
+        size_t queued{0};
+        int limit{0};                            // current concurrency cap, 0 = unlimited
+        std::chrono::microseconds rtt{0};        // recent RTT (adaptive only)
+        std::chrono::microseconds baseline_rtt{0};
+    };
+    
+    explicit HostLimiterRegistry(std::chrono::seconds idle_timeout = std::chrono::seconds(300))
+        : idle_timeout_(idle_timeout),
+          last_sweep_(std::chrono::steady_clock::now()) {}
+    
+    // Limit a whole host
+    void set_limit(const std::string& host, const HostLimit& limit) {
+        set_route_limit(host, "", limit);
+    }
+    
+    // Limit requests to `host` whose path starts with `path_prefix`. The longest
+    // matching prefix wins; paths matching no route fall back to the host limit.
+    void set_route_limit(const std::string& host, const std::string& path_prefix, const HostLimit& limit) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& routes = rules_[host];
+        auto it = std::find_if(routes.begin(), routes.end(),
+                               [&](const auto& route) { return route.first == path_prefix; });
+        if (it != routes.end()) {
+            it->second = limit;
+        } else {
+            routes.emplace_back(path_prefix, limit);
+            std::sort(routes.begin(), routes.end(), [](const auto& a, const auto& b) {
+                return a.first.size() > b.first.size();
+            });
+        }
+        
+        // Requests already holding a slot keep their old entry
+        entries_.erase(entry_key(host, path_prefix));
+        configured_ = true;
+    }
+    
+    // Limit applied separately to every host without a rule of its own
+    void set_default_limit(const HostLimit& limit) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        default_limit_ = limit;
+        has_default_ = true;
+        for (auto it = entries_.begin(); it != entries_.end(); ) {
+            it = it->second.from_default ? entries_.erase(it) : std::next(it);
+        }
+        configured_ = true;
+    }
+    
+    // Let every entry's concurrency cap adapt to the upstream. Applies to all hosts,
+    // on top of any static max_in_flight, which then acts as an upper bound.
+    void set_adaptive_limit(const AdaptiveLimit& adaptive_limit) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        adaptive_limit_ = adaptive_limit;
+        entries_.clear();
+        configured_ = true;
+    }
+    
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rules_.clear();
+        entries_.clear();
+        pauses_.clear();
+        has_pauses_ = false;
+        has_default_ = false;
+        adaptive_limit_.reset();
+        configured_ = false;
+    }
+    
+    // Hold back every request to `host` until `until`. Pauses only ever extend.
+    void pause(const std::string& host, std::chrono::steady_clock::time_point until) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& paused_until = pauses_[host];
+        paused_until = std::max(paused_until, until);
+        has_pauses_ = true;
+    }
+    
+    std::optional<std::chrono::steady_clock::time_point> paused_until(const std::string& host) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = pauses_.find(host);
+        if (it == pauses_.end() || it->second <= std::chrono::steady_clock::now()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+    
+    // Wait out any pause on the host, then for the rate limit and a concurrency
+    // slot of the matching entry. Returns an empty permit immediately when no limit applies.
+    asio::awaitable<Permit> co_acquire(const std::string& host, const std::string& path, int cost = 1) {
+        if (has_pauses_) {
+            co_await co_wait_pause(host);
+        }
+        if (!configured_) {
+            co_return Permit{};
+        }
+        
+        auto entry = find_entry(host, path, true);
+        if (!entry) {
+            co_return Permit{};
+        }
+        
+        co_await entry->rate.async_acquire(cost);
+        
+        auto executor = co_await asio::this_coro::executor;
+        std::shared_ptr<Waiter> waiter;
+        {
+            std::lock_guard<std::mutex> lock(entry->mutex);
+            entry->last_used = std::chrono::steady_clock::now();
+            int max_in_flight = entry->cap();
+            if (max_in_flight <= 0 || entry->in_flight < max_in_flight) {
+                ++entry->in_flight;
+            } else {
+                waiter = std::make_shared<Waiter>(executor);
+                waiter->timer.expires_at(asio::steady_timer::time_point::max());
+                entry->waiters.push_back(waiter);
+            }
+        }
+        
+        if (waiter) {
+            // Woken either by release() handing over its slot or by cancellation
+            co_await waiter->timer.async_wait(asio::as_tuple(asio::use_awaitable));
+            
+            std::lock_guard<std::mutex> lock(entry->mutex);
+            if (!waiter->granted) {
+                entry->waiters.erase(std::find(entry->waiters.begin(), entry->waiters.end(), waiter));
+                throw std::system_error(asio::error::make_error_code(asio::error::operation_aborted));
+            }
+        }
+        
+        co_return Permit(std::move(entry));
+    }
+    
+    // Snapshot of the entry that a request to host + path would use, if one exists
+    std::optional<Stats> get_stats(const std::string& host, const std::string& path = "/") {
+        auto entry = find_entry(host, path, false);
+        if (!entry) {
+            return std::nullopt;
+        }
+        
+        std::lock_guard<std::mutex> lock(entry->mutex);
+        Stats stats;
+        stats.in_flight = entry->in_flight;
+        stats.queued = entry->waiters.size();
+        stats.limit = entry->cap();
+        if (entry->adaptive) {
+            stats.rtt = entry->adaptive->rtt();
+            stats.baseline_rtt = entry->adaptive->baseline_rtt();
+        }
+        return stats;
+    }
+    
+    // Number of live limiter entries
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+    
+    // Drop entries with nothing in flight that were last used before idle_timeout.
+    // Runs automatically while acquiring; exposed for callers that want it sooner.
+    void expire_idle() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        expire_idle_locked(std::chrono::steady_clock::now());
+    }
+
+private:
+    struct Slot {
+        std::shared_ptr<Entry> entry;
+        bool from_default{false};
+    };
+    
+    asio::awaitable<void> co_wait_pause(const std::string& host) {
+        // Loop because the pause may be extended while we wait
+        while (true) {
+            std::chrono::steady_clock::time_point until;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = pauses_.find(host);
+                if (it == pauses_.end()) {
+                    co_return;
+                }
+                if (it->second <= std::chrono::steady_clock::now()) {
+                    pauses_.erase(it);
+                    has_pauses_ = !pauses_.empty();
+                    co_return;
+                }
+                until = it->second;
+            }
+            
+            asio::steady_timer timer(co_await asio::this_coro::executor);
+            timer.expires_at(until);
+            co_await timer.async_wait(asio::use_awaitable);
+        }
+    }
+    
+    static std::string entry_key(const std::string& host, const std::string& prefix) {
+        return host + " " + prefix;
+    }
+    
+    std::shared_ptr<Entry> find_entry(const std::string& host, const std::string& path, bool create) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_sweep_ > idle_timeout_) {
+            expire_idle_locked(now);
+        }
+        
+        const HostLimit* limit = nullptr;
+        std::string prefix;
+        bool from_default = false;
+        
+        auto rule = rules_.find(host);
+        if (rule != rules_.end()) {
+            // Routes are sorted longest prefix first
+            for (const auto& [route_prefix, route_limit] : rule->second) {
+                if (path.compare(0, route_prefix.size(), route_prefix) == 0) {
+                    limit = &route_limit;
+                    prefix = route_prefix;
+                    break;
+                }
+            }
+        }
+        if (!limit && (has_default_ || adaptive_limit_)) {
+            // With only an adaptive limit, the default is an unlimited static limit
+            limit = &default_limit_;
+            from_default = true;
+        }
+        if (!limit) {
+            return nullptr;
+        }
+        
+        auto key = entry_key(host, prefix);
+        if (!create) {
+            auto it = entries_.find(key);
+            return it == entries_.end() ? nullptr : it->second.entry;
+        }
+        
+        auto& slot = entries_[key];
+        if (!slot.entry) {
+            slot.entry = std::make_shared<Entry>(*limit, adaptive_limit_);
+            slot.from_default = from_default;
+        }
+        return slot.entry;
+    }
+    
+    void expire_idle_locked(std::chrono::steady_clock::time_point now) {
+        last_sweep_ = now;
+        auto cutoff = now - idle_timeout_;
+        for (auto it = entries_.begin(); it != entries_.end(); ) {
+            it = it->second.entry->idle_since(cutoff) ? entries_.erase(it) : std::next(it);
+        }
+        for (auto it = pauses_.begin(); it != pauses_.end(); ) {
+            it = it->second <= now ? pauses_.erase(it) : std::next(it);
+        }
+        has_pauses_ = !pauses_.empty();
+    }
+    
+    std::chrono::steady_clock::duration idle_timeout_;
+    std::chrono::steady_clock::time_point last_sweep_;
+    std::map<std::string, std::vector<std::pair<std::string, HostLimit>>> rules_;
+    std::unordered_map<std::string, Slot> entries_;
+    HostLimit default_limit_;
+    bool has_default_{false};
+    std::optional<AdaptiveLimit> adaptive_limit_;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> pauses_;
+    std::atomic<bool> has_pauses_{false};
+    std::atomic<bool> configured_{false};
+    mutable std::mutex mutex_;
+};
+
+}
@@ -0,0 +1,419 @@
+#pragma once
+
+#include "cache_entry.hpp"
+#include "disk_cache.hpp"
+#include "http_request.hpp"
+#include "retry_after.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace coro_http {
+
+// Approximate, recency-biased access counts for TinyLFU admission: a count-min
+// sketch whose counters are halved every few thousand increments
+class FrequencySketch {
+public:
+    explicit FrequencySketch(size_t width = 1024)
+        : width_(width), counters_(depth * width), sample_size_(10 * width) {}
+
+    void increment(size_t hash) {
+        for (size_t i = 0; i < depth; ++i) {
+            uint8_t& counter = counters_[i * width_ + slot(hash, i)];
+            if (counter < 15) {
+                ++counter;
+            }
+        }
+        if (++additions_ >= sample_size_) {
+            for (auto& counter : counters_) {
+                counter /= 2;
+            }
+            additions_ /= 2;
+        }
+    }
+
+    int estimate(size_t hash) const {
+        int count = 15;
+        for (size_t i = 0; i < depth; ++i) {
+            count = std::min<int>(count, counters_[i * width_ + slot(hash, i)]);
+        }
+        return count;
+    }
+
+private:
+    static constexpr size_t depth = 4;
+
+    size_t slot(size_t hash, size_t row) const {
+        static constexpr uint64_t seeds[depth] = {0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full,
+                                                  0x165667B19E3779F9ull, 0xD6E8FEB86659FD93ull};
+        uint64_t h = (static_cast<uint64_t>(hash) + row) * seeds[row];
+        return static_cast<size_t>((h ^ (h >> 32)) % width_);
+    }
+
+    size_t width_;
+    std::vector<uint8_t> counters_;
+    size_t additions_{0};
+    size_t sample_size_;
+};
+
+// In-memory private HTTP cache for GET responses (RFC 9111). Entries are keyed by
+// URL, with one variant per URL checked against the response's Vary header. The
+// cache is split into shards, each with its own lock, byte budget and LRU list.
+// When a shard is full, a new entry is admitted only if it has been requested
+// more often than the entries it would evict (TinyLFU), so a burst of one-off
+// URLs cannot flush the popular ones.
+//
+// An optional DiskCache sits behind the memory tier: every stored entry is also
+// written to disk, and a memory miss falls back to it. Bodies spilled to temporary
+// files, which the memory tier alone cannot keep, are cached there too.
+class HttpCache {
+public:
+    struct Stats {
+        uint64_t hits{0};            // served fresh, without any I/O
+        uint64_t stale_hits{0};      // served stale while revalidating in the background
+        uint64_t revalidated{0};     // 304 Not Modified answers that reused the stored body
+        uint64_t misses{0};
+        size_t entries{0};
+        size_t bytes{0};
+        size_t disk_entries{0};
+        uint64_t disk_bytes{0};
+    };
+
+    HttpCache(size_t max_bytes, size_t shards, std::unique_ptr<DiskCache> disk = nullptr)
+        : shards_(std::max<size_t>(shards, 1)),
+          shard_budget_(max_bytes / std::max<size_t>(shards, 1)),
+          disk_(std::move(disk)) {}
+
+    static bool is_cacheable_request(const HttpRequest& request) {
+        if (request.method() != HttpMethod::GET || !request.body().empty() || request.body_source()) {
+            return false;
+        }
+        // Responses to credentials may differ per caller; this cache does not tell them apart
+        return find_header(request.headers(), "authorization").empty() &&
+               !CacheControl::parse(find_header(request.headers(), "cache-control")).no_store;
+    }
+
+    // Stored response for `request`, fresh or not, if its Vary headers match.
+    // A request with Cache-Control: no-cache never gets a stored response.
+    std::shared_ptr<const CachedResponse> lookup(const HttpRequest& request) {
+        const std::string& key = request.url();
+        size_t hash = std::hash<std::string>{}(key);
+        Shard& shard = shard_for(hash);
+
+        std::shared_ptr<const CachedResponse> entry;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.sketch.increment(hash);
+            auto it = shard.index.find(key);
+            if (it != shard.index.end()) {
+                shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+                entry = it->second->second;
+            }
+        }
+        if (!entry && disk_) {
+            if (auto loaded = disk_->load(key)) {
+                loaded->size = entry_size(key, *loaded);
+                insert(key, loaded);
+                entry = std::move(loaded);
+            }
+        }
+
+        if (!entry || CacheControl::parse(find_header(request.headers(), "cache-control")).no_cache) {
+            return nullptr;
+        }
+        for (const auto& [name, value] : entry->vary) {
+            if (find_header(request.headers(), name) != value) {
+                return nullptr;
+            }
+        }
+        return entry;
+    }
+
+    // Store `response` if the protocol allows it. `request_time` and `response_time`
+    // bracket the exchange that produced it. Returns the new entry, or null.
+    std::shared_ptr<const CachedResponse> store(const HttpRequest& request, const HttpResponse& response,
+                                                std::chrono::steady_clock::time_point request_time,
+                                                std::chrono::steady_clock::time_point response_time) {
+        auto entry = make_entry(request, response, request_time, response_time);
+        if (!entry || !persist(request.url(), *entry)) {
+            return nullptr;
+        }
+        entry->size = entry_size(request.url(), *entry);
+        insert(request.url(), entry);
+        return entry;
+    }
+
+    // Apply a 304 answer to a stored entry: its headers replace the stored ones
+    // (RFC 9111 section 4.3.4) and the stored body is kept
+    std::shared_ptr<const CachedResponse> refresh(const HttpRequest& request, const CachedResponse& stored,
+                                                  const HttpResponse& not_modified,
+                                                  std::chrono::steady_clock::time_point request_time,
+                                                  std::chrono::steady_clock::time_point response_time) {
+        HttpResponse merged = stored.response;
+        for (const auto& [key, value] : not_modified.headers()) {
+            if (!strcasecmp_impl(key, "Content-Length") && !strcasecmp_impl(key, "Transfer-Encoding")) {
+                for (const auto& [old_key, old_value] : stored.response.headers()) {
+                    if (old_key != key && strcasecmp_impl(old_key, key)) {
+                        merged.remove_header(old_key);
+                    }
+                }
+                merged.add_header(key, value);
+            }
+        }
+        ++revalidated_;
+        auto entry = make_entry(request, merged, request_time, response_time);
+        if (entry) {
+            entry->disk_body = stored.disk_body;
+        }
+        if (!entry || !persist(request.url(), *entry)) {
+            erase(request.url());
+            return nullptr;
+        }
+        entry->size = entry_size(request.url(), *entry);
+        insert(request.url(), entry);
+        return entry;
+    }
+
+    // Drop the stored response for `url`, e.g. after an unsafe request to it
+    // (RFC 9111 section 4.4)
+    void erase(const std::string& url) {
+        {
+            Shard& shard = shard_for(std::hash<std::string>{}(url));
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.index.find(url);
+            if (it != shard.index.end()) {
+                shard.bytes -= it->second->second->size;
+                shard.lru.erase(it->second);
+                shard.index.erase(it);
+            }
+        }
+        if (disk_) {
+            disk_->erase(url);
+        }
+    }
+
+    void clear() {
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.lru.clear();
+            shard.index.clear();
+            shard.bytes = 0;
+        }
+        if (disk_) {
+            disk_->clear();
+        }
+    }
+
+    // Whether stores and erasures write to disk and may block on it
+    bool has_disk() const { return disk_ != nullptr; }
+
+    void record_hit() { ++hits_; }
+    void record_stale_hit() { ++stale_hits_; }
+    void record_miss() { ++misses_; }
+
+    Stats stats() const {
+        Stats stats{hits_.load(), stale_hits_.load(), revalidated_.load(), misses_.load(), 0, 0};
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            stats.entries += shard.index.size();
+            stats.bytes += shard.bytes;
+        }
+        if (disk_) {
+            auto disk = disk_->stats();
+            stats.disk_entries = disk.entries;
+            stats.disk_bytes = disk.bytes;
+        }
+        return stats;
+    }
+
+private:
+    using Lru = std::list<std::pair<std::string, std::shared_ptr<const CachedResponse>>>;
+
+    static constexpr size_t mapped_body_cost = 4096;
+
+    struct Shard {
+        mutable std::mutex mutex;
+        Lru lru;                                              // Most recently used first
+        std::unordered_map<std::string, Lru::iterator> index;
+        size_t bytes{0};
+        FrequencySketch sketch;
+    };
+
+    static std::string find_header(const std::map<std::string, std::string>& headers, const std::string& name) {
+        for (const auto& [key, value] : headers) {
+            if (strcasecmp_impl(key, name)) {
+                return value;
+            }
+        }
+        return "";
+    }
+
+    Shard& shard_for(size_t hash) {
+        return shards_[hash % shards_.size()];
+    }
+
+    static bool heuristically_cacheable(int status) {
+        switch (status) {
+            case 200: case 203: case 204: case 300: case 301: case 308:
+            case 404: case 405: case 410: case 414: case 501:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    std::shared_ptr<CachedResponse> make_entry(const HttpRequest& request, const HttpResponse& response,
+                                               std::chrono::steady_clock::time_point request_time,
+                                               std::chrono::steady_clock::time_point response_time) const {
+        int status = response.status_code();
+        CacheControl cc = CacheControl::parse(response.get_header("Cache-Control"));
+        std::string expires = response.get_header("Expires");
+        bool explicit_lifetime = cc.max_age || !expires.empty();
+
+        if (cc.no_store || status < 200 || status == 206 || status == 304 ||
+            (!heuristically_cacheable(status) && !explicit_lifetime)) {
+            return nullptr;
+        }
+
+        auto entry = std::make_shared<CachedResponse>();
+        std::string vary = response.get_header("Vary");
+        size_t pos = 0;
+        while (pos < vary.size()) {
+            size_t end = std::min(vary.find(',', pos), vary.size());
+            std::string name = vary.substr(pos, end - pos);
+            pos = end + 1;
+            name.erase(0, name.find_first_not_of(" \t"));
+            name.erase(name.find_last_not_of(" \t") + 1);
+            std::transform(name.begin(), name.end(), name.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            if (name == "*") {
+                return nullptr;
+            }
+            if (!name.empty()) {
+                entry->vary.emplace_back(name, find_header(request.headers(), name));
+            }
+        }
+
+        // Age calculation (RFC 9111 section 4.2.3); Date is the origin's clock
+        auto now = std::chrono::system_clock::now();
+        auto date = parse_http_date(response.get_header("Date")).value_or(now);
+        auto apparent_age = std::max(std::chrono::seconds(0), std::chrono::duration_cast<std::chrono::seconds>(now - date));
+        auto response_delay = std::chrono::duration_cast<std::chrono::seconds>(response_time - request_time);
+        long long age_value = 0;
+        try {
+            std::string age = response.get_header("Age");
+            age_value = age.empty() ? 0 : std::max(0LL, std::stoll(age));
+        } catch (...) {}
+        entry->initial_age = std::max(apparent_age, std::chrono::seconds(age_value) + response_delay);
+
+        // Freshness lifetime (RFC 9111 section 4.2.1), or 10% of the time since
+        // Last-Modified, at most a day, when the origin gave none
+        if (cc.max_age) {
+            entry->freshness_lifetime = std::chrono::seconds(*cc.max_age);
+        } else if (!expires.empty()) {
+            auto expires_at = parse_http_date(expires);
+            if (expires_at && *expires_at > date) {
+                entry->freshness_lifetime = std::chrono::duration_cast<std::chrono::seconds>(*expires_at - date);
+            }
+        } else if (auto last_modified = parse_http_date(response.get_header("Last-Modified"));
+                   last_modified && *last_modified < date) {
+            entry->freshness_lifetime = std::min<std::chrono::seconds>(
+                std::chrono::duration_cast<std::chrono::seconds>(date - *last_modified) / 10, std::chrono::hours(24));
+        }
+
+        if (cc.stale_while_revalidate && !cc.must_revalidate) {
+            entry->stale_while_revalidate = std::chrono::seconds(*cc.stale_while_revalidate);
+        }
+        entry->no_cache = cc.no_cache;
+        entry->response = response;
+        entry->response_time = response_time;
+
+        // Nothing would ever be served from an entry that can neither be used fresh nor revalidated
+        if (entry->freshness_lifetime.count() == 0 && entry->stale_while_revalidate.count() == 0 &&
+            !entry->validatable()) {
+            return nullptr;
+        }
+        return entry;
+    }
+
+    // Bytes an entry is charged against the budget: its key, headers and in-memory
+    // body. A body mapped from the disk tier lives in the page cache, so only its
+    // mapping is charged, as one page; that also bounds how many mappings the
+    // memory tier can pin.
+    static size_t entry_size(const std::string& key, const CachedResponse& entry) {
+        const HttpResponse& response = entry.response;
+        size_t size = key.size() + response.reason().size();
+        for (const auto& [name, value] : response.headers()) {
+            size += name.size() + value.size();
+        }
+        for (const auto& [name, value] : entry.vary) {
+            size += name.size() + value.size();
+        }
+        return size + (response.body_file() ? mapped_body_cost : response.body().size());
+    }
+
+    // Write `entry` through to the disk tier. Without one, only entries with the body
+    // in memory can be kept; a spilled body's temporary file is not worth pinning.
+    bool persist(const std::string& key, CachedResponse& entry) {
+        if (disk_) {
+            return disk_->store(key, entry) || !entry.response.body_file();
+        }
+        return !entry.response.body_file();
+    }
+
+    void insert(const std::string& key, std::shared_ptr<const CachedResponse> entry) {
+        size_t hash = std::hash<std::string>{}(key);
+        Shard& shard = shard_for(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (entry->size > shard_budget_) {
+            return;
+        }
+
+        auto existing = shard.index.find(key);
+        if (existing != shard.index.end()) {
+            shard.bytes -= existing->second->second->size;
+            shard.lru.erase(existing->second);
+            shard.index.erase(existing);
+        } else if (shard.bytes + entry->size > shard_budget_) {
+            // TinyLFU admission: only displace entries that are less popular
+            int frequency = shard.sketch.estimate(hash);
+            size_t freed = 0;
+            for (auto it = shard.lru.rbegin(); it != shard.lru.rend() && shard.bytes - freed + entry->size > shard_budget_; ++it) {
+                if (shard.sketch.estimate(std::hash<std::string>{}(it->first)) >= frequency) {
+                    return;
+                }
+                freed += it->second->size;
+            }
+        }
+
+        while (!shard.lru.empty() && shard.bytes + entry->size > shard_budget_) {
+            shard.bytes -= shard.lru.back().second->size;
+            shard.index.erase(shard.lru.back().first);
+            shard.lru.pop_back();
+        }
+        shard.lru.emplace_front(key, std::move(entry));
+        shard.index[key] = shard.lru.begin();
+        shard.bytes += shard.lru.front().second->size;
+    }
+
+    std::vector<Shard> shards_;
+    size_t shard_budget_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> stale_hits_{0};
+    std::atomic<uint64_t> revalidated_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::unique_ptr<DiskCache> disk_;
+};
+
+}
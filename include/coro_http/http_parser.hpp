@@ -17,17 +17,18 @@ inline bool strcasecmp_parser(const std::string& a, const char* b) {
         [](char ca, char cb) { return std::tolower(ca) == std::tolower(cb); });
 }
 
-inline HttpResponse parse_response(const std::string& response_data) {
-    HttpResponse response;
-    std::istringstream stream(response_data);
-    std::string line;
+namespace detail {
 
+// Status line and header fields, up to and including the empty line
+inline void parse_head(std::istream& stream, HttpResponse& response) {
+    std::string line;
+    
     if (std::getline(stream, line)) {
-        if (line.back() == '\r') line.pop_back();
+        if (!line.empty() && line.back() == '\r') line.pop_back();
         
         std::istringstream status_line(line);
         std::string http_version;
-        int status_code;
+        int status_code = 0;
         std::string reason;
         
         status_line >> http_version >> status_code;
@@ -39,7 +40,7 @@ inline HttpResponse parse_response(const std::string& response_data) {
     }
 
     while (std::getline(stream, line) && line != "\r") {
-        if (line.back() == '\r') line.pop_back();
+        if (!line.empty() && line.back() == '\r') line.pop_back();
         
         auto colon_pos = line.find(':');
         if (colon_pos != std::string::npos) {
@@ -52,6 +53,22 @@ inline HttpResponse parse_response(const std::string& response_data) {
             response.add_header(key, value);
         }
     }
+}
+
+}
+
+// Parse only the status line and headers; the body is left to a streaming reader
+inline HttpResponse parse_response_head(const std::string& head) {
+    HttpResponse response;
+    std::istringstream stream(head);
+    detail::parse_head(stream, response);
+    return response;
+}
+
+inline HttpResponse parse_response(const std::string& response_data) {
+    HttpResponse response;
+    std::istringstream stream(response_data);
+    detail::parse_head(stream, response);
 
     std::string body;
     std::string remaining((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
@@ -99,7 +116,13 @@ inline std::string build_request(const HttpRequest& request, const UrlInfo& url_
         req << "Accept-Encoding: gzip, deflate\r\n";
     }
     
-    if (!request.body().empty()) {
+    if (const auto& source = request.body_source()) {
+        if (auto size = source->size()) {
+            req << "Content-Length: " << *size << "\r\n";
+        } else {
+            req << "Transfer-Encoding: chunked\r\n";
+        }
+    } else if (!request.body().empty()) {
         req << "Content-Length: " << request.body().size() << "\r\n";
     }
     
@@ -109,7 +132,8 @@ inline std::string build_request(const HttpRequest& request, const UrlInfo& url_
     
     req << "\r\n";
     
-    if (!request.body().empty()) {
+    // A streamed body is written after the head as it is produced
+    if (!request.body_source() && !request.body().empty()) {
         req << request.body();
     }
     
@@ -1,7 +1,16 @@
 #pragma once
 
+#include "body_source.hpp"
+#include "cancellation.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <string>
 #include <map>
+#include <memory>
 
 namespace coro_http {
 
@@ -29,17 +38,120 @@ public:
         body_ = body;
         return *this;
     }
+    
+    // Stream the body from `source` while sending; replaces any set_body() content.
+    // Copies of the request share the source.
+    HttpRequest& set_body_source(std::shared_ptr<BodySource> source) {
+        body_source_ = std::move(source);
+        return *this;
+    }
+    
+    // Compress (or never compress) this request's body, overriding the client's
+    // request compression settings
+    HttpRequest& set_compress_body(bool compress) {
+        compress_body_ = compress;
+        return *this;
+    }
+
+    // Response size limits and spill threshold for this request, overriding the
+    // client's (0 for no limit, or to keep the body in memory)
+    HttpRequest& set_max_response_header_size(size_t size) {
+        max_response_header_size_ = size;
+        return *this;
+    }
+    
+    HttpRequest& set_max_response_body_size(uint64_t size) {
+        max_response_body_size_ = size;
+        return *this;
+    }
+    
+    HttpRequest& set_response_spill_threshold(uint64_t size) {
+        response_spill_threshold_ = size;
+        return *this;
+    }
 
+    // Absolute deadline for the whole request, retries included
+    HttpRequest& set_deadline(std::chrono::steady_clock::time_point deadline) {
+        deadline_ = deadline;
+        return *this;
+    }
+    
+    // Time budget for the whole request, counted from when it is executed
+    HttpRequest& set_timeout(std::chrono::milliseconds timeout) {
+        timeout_ = timeout;
+        return *this;
+    }
+    
+    // Number of rate limiter permits this request consumes (weighted requests)
+    HttpRequest& set_rate_limit_cost(int cost) {
+        rate_limit_cost_ = cost;
+        return *this;
+    }
+    
+    // Cancel the request from elsewhere by calling token.cancel()
+    HttpRequest& set_cancellation_token(const CancellationToken& token) {
+        cancellation_token_ = token;
+        return *this;
+    }
+    
+    // Drop the deadline, timeout and cancellation token
+    HttpRequest& clear_cancellation() {
+        deadline_.reset();
+        timeout_.reset();
+        cancellation_token_.reset();
+        return *this;
+    }
+    
     HttpMethod method() const { return method_; }
     const std::string& url() const { return url_; }
     const std::map<std::string, std::string>& headers() const { return headers_; }
     const std::string& body() const { return body_; }
+    const std::shared_ptr<BodySource>& body_source() const { return body_source_; }
+    const std::optional<bool>& compress_body() const { return compress_body_; }
+    const std::optional<size_t>& max_response_header_size() const { return max_response_header_size_; }
+    const std::optional<uint64_t>& max_response_body_size() const { return max_response_body_size_; }
+    const std::optional<uint64_t>& response_spill_threshold() const { return response_spill_threshold_; }
+    const std::optional<std::chrono::steady_clock::time_point>& deadline() const { return deadline_; }
+    const std::optional<std::chrono::milliseconds>& timeout() const { return timeout_; }
+    const std::optional<CancellationToken>& cancellation_token() const { return cancellation_token_; }
+    int rate_limit_cost() const { return rate_limit_cost_; }
+    
+    // Whether sending the request twice has the same effect as sending it once
+    // (RFC 9110 section 9.2.2), or the caller made it so with an Idempotency-Key
+    bool is_idempotent() const {
+        switch (method_) {
+            case HttpMethod::GET:
+            case HttpMethod::HEAD:
+            case HttpMethod::PUT:
+            case HttpMethod::DEL:
+            case HttpMethod::OPTIONS:
+                return true;
+            default:
+                break;
+        }
+        for (const auto& [key, value] : headers_) {
+            if (key.size() == 15 && std::equal(key.begin(), key.end(), "idempotency-key",
+                    [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == b; })) {
+                return true;
+            }
+        }
+        return false;
+    }
 
 private:
     HttpMethod method_;
     std::string url_;
     std::map<std::string, std::string> headers_;
     std::string body_;
+    std::shared_ptr<BodySource> body_source_;
+    std::optional<bool> compress_body_;
+    std::optional<size_t> max_response_header_size_;
+    std::optional<uint64_t> max_response_body_size_;
+    std::optional<uint64_t> response_spill_threshold_;
+    std::optional<std::chrono::steady_clock::time_point> deadline_;
+    std::optional<std::chrono::milliseconds> timeout_;
+    std::optional<CancellationToken> cancellation_token_;
+    int rate_limit_cost_{1};
 };
 
 }
@@ -1,9 +1,13 @@
 #pragma once
 
+#include "body_file.hpp"
+#include <memory>
 #include <string>
+#include <string_view>
 #include <map>
 #include <vector>
 #include <algorithm>
+#include <utility>
 
 namespace coro_http {
 
@@ -21,13 +25,28 @@ public:
     void add_header(const std::string& key, const std::string& value) {
         headers_[key] = value;
     }
-    void set_body(const std::string& body) { body_ = body; }
+    void remove_header(const std::string& key) { headers_.erase(key); }
+    void set_body(std::string body) { body_ = std::make_shared<const std::string>(std::move(body)); }
+    void set_shared_body(std::shared_ptr<const std::string> body) { body_ = std::move(body); }
+    void set_body_file(std::shared_ptr<BodyFile> file) { body_file_ = std::move(file); }
     void add_redirect(const std::string& url) { redirect_chain_.push_back(url); }
 
     int status_code() const { return status_code_; }
     const std::string& reason() const { return reason_; }
     const std::map<std::string, std::string>& headers() const { return headers_; }
-    const std::string& body() const { return body_; }
+    const std::string& body() const {
+        static const std::string empty;
+        return body_ ? *body_ : empty;
+    }
+    
+    // The body buffer is immutable and shared by copies of a response, so copying
+    // one (e.g. for each caller of a coalesced request) does not copy the body
+    const std::shared_ptr<const std::string>& shared_body() const { return body_; }
+    
+    // Bodies above the client's spill threshold are kept in body_file() and body()
+    // is empty; body_view() returns the body wherever it is stored
+    const std::shared_ptr<BodyFile>& body_file() const { return body_file_; }
+    std::string_view body_view() const { return body_file_ ? body_file_->view() : std::string_view(body()); }
     const std::vector<std::string>& redirect_chain() const { return redirect_chain_; }
 
     std::string get_header(const std::string& key) const {
@@ -43,7 +62,8 @@ private:
     int status_code_;
     std::string reason_;
     std::map<std::string, std::string> headers_;
-    std::string body_;
+    std::shared_ptr<const std::string> body_;
+    std::shared_ptr<BodyFile> body_file_;
     std::vector<std::string> redirect_chain_;
 };
 
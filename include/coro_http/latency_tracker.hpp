@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace coro_http {
+
+// Per-host latency samples kept in a fixed-size ring buffer.
+// Memory is bounded by max_samples per host and max_hosts hosts.
+class LatencyTracker {
+public:
+    explicit LatencyTracker(size_t max_samples = 256, size_t max_hosts = 1024)
+        : max_samples_(max_samples), max_hosts_(max_hosts) {}
+    
+    void record(const std::string& host, std::chrono::microseconds latency) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        auto it = hosts_.find(host);
+        if (it == hosts_.end()) {
+            if (hosts_.size() >= max_hosts_) {
+                evict_least_recent();
+            }
+            it = hosts_.emplace(host, Samples{}).first;
+            it->second.values.reserve(max_samples_);
+        }
+        
+        auto& samples = it->second;
+        if (samples.values.size() < max_samples_) {
+            samples.values.push_back(latency.count());
+        } else {
+            samples.values[samples.next] = latency.count();
+        }
+        samples.next = (samples.next + 1) % max_samples_;
+        samples.last_update = std::chrono::steady_clock::now();
+    }
+    
+    // Latency at quantile q (0.0 - 1.0), or nullopt with fewer than min_samples samples
+    std::optional<std::chrono::microseconds> percentile(const std::string& host,
+                                                        double q,
+                                                        size_t min_samples = 1) const {
+        std::vector<long long> values;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = hosts_.find(host);
+            if (it == hosts_.end() || it->second.values.size() < std::max<size_t>(min_samples, 1)) {
+                return std::nullopt;
+            }
+            values = it->second.values;
+        }
+        
+        q = std::clamp(q, 0.0, 1.0);
+        size_t index = static_cast<size_t>(q * (values.size() - 1));
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return std::chrono::microseconds(values[index]);
+    }
+    
+    size_t sample_count(const std::string& host) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = hosts_.find(host);
+        return it == hosts_.end() ? 0 : it->second.values.size();
+    }
+    
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        hosts_.clear();
+    }
+
+private:
+    struct Samples {
+        std::vector<long long> values;
+        size_t next{0};
+        std::chrono::steady_clock::time_point last_update;
+    };
+    
+    void evict_least_recent() {
+        auto oldest = hosts_.begin();
+        for (auto it = hosts_.begin(); it != hosts_.end(); ++it) {
+            if (it->second.last_update < oldest->second.last_update) {
+                oldest = it;
+            }
+        }
+        if (oldest != hosts_.end()) {
+            hosts_.erase(oldest);
+        }
+    }
+    
+    size_t max_samples_;
+    size_t max_hosts_;
+    std::map<std::string, Samples> hosts_;
+    mutable std::mutex mutex_;
+};
+
+}
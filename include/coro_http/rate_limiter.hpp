@@ -1,109 +1,128 @@
 #pragma once
 
+#include <asio.hpp>
+#include <algorithm>
 #include <chrono>
-#include <deque>
 #include <mutex>
-#include <condition_variable>
+#include <thread>
 
 namespace coro_http {
 
-// Token bucket rate limiter
+// GCRA (generic cell rate algorithm) rate limiter.
+// Equivalent to a token bucket of max_requests tokens refilled at max_requests per
+// window, but tracked by a single "theoretical arrival time", so memory is O(1)
+// regardless of the rate. Acquiring reserves permits up front, which keeps waiters
+// in FIFO order without any retry loop.
 class RateLimiter {
 public:
+    using clock = std::chrono::steady_clock;
+    
     RateLimiter(int max_requests, std::chrono::milliseconds window)
         : max_requests_(max_requests),
           window_(window),
-          enabled_(max_requests > 0) {
+          enabled_(max_requests > 0 && window.count() > 0),
+          emission_interval_(enabled_ ? std::chrono::duration_cast<clock::duration>(window) / max_requests
+                                      : clock::duration::zero()),
+          tat_(clock::time_point::min()) {
     }
     
-    // Synchronous wait until rate limit allows request
-    void acquire() {
-        if (!enabled_) return;
-        
-        std::unique_lock<std::mutex> lock(mutex_);
+    // Suspend the calling coroutine until `permits` are available. Never blocks the
+    // io thread. If the wait is cancelled the reservation is handed back.
+    asio::awaitable<void> async_acquire(int permits = 1) {
+        if (!enabled_) co_return;
         
-        auto now = std::chrono::steady_clock::now();
+        auto wait = reserve(permits);
+        if (wait <= clock::duration::zero()) co_return;
         
-        // Remove expired timestamps
-        while (!timestamps_.empty() && 
-               now - timestamps_.front() > window_) {
-            timestamps_.pop_front();
+        asio::steady_timer timer(co_await asio::this_coro::executor);
+        timer.expires_after(wait);
+        try {
+            co_await timer.async_wait(asio::use_awaitable);
+        } catch (...) {
+            refund(permits);
+            throw;
         }
+    }
+    
+    // Synchronous wait until rate limit allows request. Blocks the calling thread;
+    // coroutines should use async_acquire() instead.
+    void acquire(int permits = 1) {
+        if (!enabled_) return;
         
-        // Wait if rate limit exceeded
-        while (timestamps_.size() >= static_cast<size_t>(max_requests_)) {
-            auto oldest = timestamps_.front();
-            auto wait_until = oldest + window_;
-            
-            cv_.wait_until(lock, wait_until);
-            
-            now = std::chrono::steady_clock::now();
-            while (!timestamps_.empty() && 
-                   now - timestamps_.front() > window_) {
-                timestamps_.pop_front();
-            }
+        auto wait = reserve(permits);
+        if (wait > clock::duration::zero()) {
+            std::this_thread::sleep_for(wait);
         }
-        
-        // Add current request
-        timestamps_.push_back(now);
     }
     
     // Try to acquire without blocking
-    bool try_acquire() {
+    bool try_acquire(int permits = 1) {
         if (!enabled_) return true;
         
         std::lock_guard<std::mutex> lock(mutex_);
         
-        auto now = std::chrono::steady_clock::now();
-        
-        // Remove expired timestamps
-        while (!timestamps_.empty() && 
-               now - timestamps_.front() > window_) {
-            timestamps_.pop_front();
-        }
-        
-        // Check if we can add request
-        if (timestamps_.size() >= static_cast<size_t>(max_requests_)) {
+        auto now = clock::now();
+        auto new_tat = std::max(tat_, now) + emission_interval_ * permits;
+        if (new_tat - now > window_) {
             return false;
         }
         
-        timestamps_.push_back(now);
+        tat_ = new_tat;
         return true;
     }
     
+    // Reserve `permits` and return how long the caller must wait before using them
+    clock::duration reserve(int permits = 1) {
+        if (!enabled_) return clock::duration::zero();
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        auto now = clock::now();
+        tat_ = std::max(tat_, now) + emission_interval_ * permits;
+        
+        auto allow_at = tat_ - window_;
+        return allow_at > now ? allow_at - now : clock::duration::zero();
+    }
+    
+    // Hand back permits reserved but never used
+    void refund(int permits = 1) {
+        if (!enabled_) return;
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        tat_ = std::max(clock::now(), tat_ - emission_interval_ * permits);
+    }
+    
     // Get remaining capacity
     int remaining() const {
         if (!enabled_) return max_requests_;
         
         std::lock_guard<std::mutex> lock(mutex_);
         
-        auto now = std::chrono::steady_clock::now();
-        
-        // Count valid timestamps
-        int valid_count = 0;
-        for (const auto& ts : timestamps_) {
-            if (now - ts <= window_) {
-                valid_count++;
-            }
+        auto now = clock::now();
+        if (tat_ <= now) {
+            return max_requests_;
         }
         
-        return max_requests_ - valid_count;
+        auto headroom = window_ - (tat_ - now);
+        if (headroom <= clock::duration::zero()) {
+            return 0;
+        }
+        return std::min(max_requests_, static_cast<int>(headroom / emission_interval_));
     }
     
     // Reset the rate limiter
     void reset() {
         std::lock_guard<std::mutex> lock(mutex_);
-        timestamps_.clear();
-        cv_.notify_all();
+        tat_ = clock::time_point::min();
     }
 
 private:
     int max_requests_;
-    std::chrono::milliseconds window_;
+    clock::duration window_;
     bool enabled_;
-    std::deque<std::chrono::steady_clock::time_point> timestamps_;
+    clock::duration emission_interval_;
+    clock::time_point tat_;  // theoretical arrival time of the next request
     mutable std::mutex mutex_;
-    std::condition_variable cv_;
 };
 
 }
@@ -0,0 +1,382 @@
+#pragma once
+
+#include "http_request.hpp"
+#include "host_limiter.hpp"
+#include "http_response.hpp"
+#include "chunked_decoder.hpp"
+#include "compression.hpp"
+#include "error.hpp"
+#include "file_sink.hpp"
+#include <asio.hpp>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace coro_http {
+
+// Hands a connection back exactly once: to the pool when the response was read
+// to its end on a keep-alive connection, closed otherwise. Dropping the lease
+// without finishing counts as abandoning the connection.
+class ConnectionLease {
+public:
+    using Release = std::function<void(bool reusable)>;
+    
+    ConnectionLease() = default;
+    explicit ConnectionLease(Release release) : release_(std::move(release)) {}
+    
+    ConnectionLease(ConnectionLease&& other) noexcept
+        : release_(std::exchange(other.release_, nullptr)) {}
+    
+    ConnectionLease& operator=(ConnectionLease&& other) noexcept {
+        if (this != &other) {
+            finish(false);
+            release_ = std::exchange(other.release_, nullptr);
+        }
+        return *this;
+    }
+    
+    ConnectionLease(const ConnectionLease&) = delete;
+    ConnectionLease& operator=(const ConnectionLease&) = delete;
+    
+    ~ConnectionLease() {
+        finish(false);
+    }
+    
+    void finish(bool reusable) {
+        if (auto release = std::exchange(release_, nullptr)) {
+            release(reusable);
+        }
+    }
+
+private:
+    Release release_;
+};
+
+// A response whose status line and headers have arrived and whose body is
+// pulled on demand. Dechunking and gzip/deflate decoding happen as the body is
+// read. Nothing is read from the connection until the caller asks for more, so
+// a slow consumer holds back the server through TCP flow control instead of
+// the body piling up in memory. The connection goes back to the pool once the
+// body has been read to its end; destroying the stream earlier closes it.
+class HttpResponseStream {
+public:
+    // Reads raw bytes from the connection; 0 at end of stream
+    using ReadSome = std::function<asio::awaitable<size_t>(asio::mutable_buffer)>;
+    
+    // Moves up to `max` raw bytes from the connection into a file; 0 at end of stream
+    using SpliceTo = std::function<asio::awaitable<size_t>(FileSink&, uint64_t max)>;
+    
+    HttpResponseStream(HttpResponse head, std::string buffered, HttpMethod request_method,
+                       ReadSome read_some, ConnectionLease lease)
+        : head_(std::move(head)),
+          buffered_(std::move(buffered)),
+          read_some_(std::move(read_some)),
+          lease_(std::move(lease)) {
+        int status = head_.status_code();
+        std::string transfer_encoding = lowercase(head_.get_header("Transfer-Encoding"));
+        std::string content_length = head_.get_header("Content-Length");
+        
+        if (request_method == HttpMethod::HEAD || (status >= 100 && status < 200) ||
+            status == 204 || status == 304) {
+            framing_ = Framing::none;
+        } else if (transfer_encoding.find("chunked") != std::string::npos) {
+            framing_ = Framing::chunked;
+        } else if (!content_length.empty()) {
+            framing_ = Framing::length;
+            try {
+                remaining_ = std::stoull(content_length);
+            } catch (...) {
+                throw std::system_error(make_error_code(error::protocol_error), "Invalid Content-Length");
+            }
+        } else {
+            framing_ = Framing::until_close;
+        }
+        
+        reusable_ = framing_ != Framing::until_close && lowercase(head_.get_header("Connection")) != "close";
+        
+        std::string content_encoding = lowercase(head_.get_header("Content-Encoding"));
+        if (content_encoding == "gzip") {
+            inflater_ = std::make_unique<Inflater>(Inflater::Format::gzip);
+        } else if (content_encoding == "deflate") {
+            inflater_ = std::make_unique<Inflater>(Inflater::Format::deflate);
+        }
+        
+        if (framing_ == Framing::none || (framing_ == Framing::length && remaining_ == 0)) {
+            complete();
+        }
+    }
+    
+    HttpResponseStream(HttpResponseStream&&) = default;
+    HttpResponseStream& operator=(HttpResponseStream&&) = default;
+    
+    // Status line and headers; the body is empty
+    const HttpResponse& head() const { return head_; }
+    int status_code() const { return head_.status_code(); }
+    const std::map<std::string, std::string>& headers() const { return head_.headers(); }
+    std::string get_header(const std::string& key) const { return head_.get_header(key); }
+    
+    // Copy up to buffer.size() decoded body bytes into `buffer`. Returns 0 once
+    // the body has been read completely.
+    asio::awaitable<size_t> co_read_some(asio::mutable_buffer buffer) {
+        if (!co_await co_fill()) {
+            co_return 0;
+        }
+        size_t n = std::min(buffer.size(), decoded_.size() - decoded_pos_);
+        std::memcpy(buffer.data(), decoded_.data() + decoded_pos_, n);
+        decoded_pos_ += n;
+        co_return n;
+    }
+    
+    // Write the rest of the body to `sink` and return the number of bytes written.
+    // An identity-encoded body with a Content-Length is spliced from the socket to
+    // the file when the connection supports it; anything else is decoded into the
+    // stream's own buffer and written from there.
+    asio::awaitable<uint64_t> co_read_to(FileSink& sink) {
+        uint64_t total = 0;
+        
+        if (splice_ && framing_ == Framing::length && !inflater_ && !body_complete_ &&
+            decoded_pos_ == decoded_.size()) {
+            try {
+                // Body bytes that arrived with the headers
+                if (!buffered_.empty()) {
+                    size_t take = static_cast<size_t>(std::min<unsigned long long>(buffered_.size(), remaining_));
+                    co_await sink.co_write(buffered_.data(), take);
+                    buffered_.clear();
+                    remaining_ -= take;
+                    total += take;
+                }
+                while (remaining_ > 0) {
+                    size_t n = co_await co_guarded(splice_(sink, remaining_));
+                    if (n == 0) {
+                        throw std::system_error(make_error_code(error::incomplete_body));
+                    }
+                    remaining_ -= n;
+                    total += n;
+                }
+            } catch (...) {
+                finish(false);
+                throw;
+            }
+            complete();
+            co_return total;
+        }
+        
+        while (co_await co_fill()) {
+            co_await sink.co_write(decoded_.data() + decoded_pos_, decoded_.size() - decoded_pos_);
+            total += decoded_.size() - decoded_pos_;
+            decoded_pos_ = decoded_.size();
+        }
+        co_return total;
+    }
+    
+    // Let co_read_to() bypass user space; set by the client for plain TCP connections
+    void set_splice(SpliceTo splice) {
+        splice_ = std::move(splice);
+    }
+    
+    // Bound the rest of the body by the request's deadline and cancellation token.
+    // A read still pending when either fires fails with timed_out or
+    // operation_aborted, and the connection is closed.
+    void set_cancellation(std::optional<std::chrono::steady_clock::time_point> deadline,
+                          std::optional<CancellationToken> token) {
+        deadline_ = deadline;
+        token_ = std::move(token);
+    }
+    
+    // Keep the request's host concurrency slot until the body has been read or the
+    // stream is closed, so the transfer counts against the host's limit. The permit's
+    // outcome and RTT were recorded at the head; however long the body takes, its
+    // release only frees the slot.
+    void hold_permit(HostLimiterRegistry::Permit permit) {
+        permit_ = std::move(permit);
+        if (body_complete_) {
+            permit_.release();
+        }
+    }
+    
+    // Read the rest of the body into memory
+    asio::awaitable<std::string> co_read_all() {
+        std::string body;
+        std::vector<char> buffer(16384);
+        while (size_t n = co_await co_read_some(asio::buffer(buffer))) {
+            body.append(buffer.data(), n);
+        }
+        co_return body;
+    }
+    
+    // True once the whole body has been handed out
+    bool eof() const {
+        return body_complete_ && !inflating() && decoded_pos_ == decoded_.size();
+    }
+    
+    // Stop reading; the connection is closed instead of pooled
+    void close() {
+        body_complete_ = true;
+        decoded_.clear();
+        decoded_pos_ = 0;
+        compressed_.clear();
+        inflater_.reset();
+        finish(false);
+    }
+
+private:
+    enum class Framing { none, length, chunked, until_close };
+    
+    static std::string lowercase(std::string value) {
+        std::transform(value.begin(), value.end(), value.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return value;
+    }
+    
+    // Make decoded body bytes available, reading from the connection as needed.
+    // Returns false once the body has been handed out completely.
+    asio::awaitable<bool> co_fill() {
+        while (decoded_pos_ == decoded_.size()) {
+            decoded_.clear();
+            decoded_pos_ = 0;
+            if (inflating()) {
+                inflate_step();
+                continue;
+            }
+            if (body_complete_) {
+                co_return false;
+            }
+            
+            if (!buffered_.empty()) {
+                std::string raw = std::move(buffered_);
+                buffered_.clear();
+                consume(raw.data(), raw.size());
+                continue;
+            }
+            
+            if (raw_buffer_.empty()) {
+                raw_buffer_.resize(16384);
+            }
+            size_t len = 0;
+            try {
+                len = co_await co_guarded(read_some_(asio::buffer(raw_buffer_)));
+            } catch (...) {
+                finish(false);
+                throw;
+            }
+            
+            if (len == 0) {
+                // Only a body without framing may end with the connection
+                if (framing_ != Framing::until_close) {
+                    finish(false);
+                    throw std::system_error(make_error_code(error::incomplete_body));
+                }
+                complete();
+                continue;
+            }
+            consume(raw_buffer_.data(), len);
+        }
+        co_return true;
+    }
+    
+    void consume(const char* data, size_t size) {
+        try {
+            switch (framing_) {
+                case Framing::length: {
+                    size_t take = static_cast<size_t>(std::min<unsigned long long>(size, remaining_));
+                    decode(data, take);
+                    remaining_ -= take;
+                    if (remaining_ == 0) {
+                        complete();
+                    }
+                    break;
+                }
+                case Framing::chunked: {
+                    std::string chunk_data;
+                    chunked_.feed(data, size, chunk_data);
+                    decode(chunk_data.data(), chunk_data.size());
+                    if (chunked_.done()) {
+                        complete();
+                    }
+                    break;
+                }
+                case Framing::until_close:
+                    decode(data, size);
+                    break;
+                case Framing::none:
+                    break;
+            }
+        } catch (const std::system_error&) {
+            // Malformed chunking or compressed data leaves the connection unusable
+            finish(false);
+            throw;
+        }
+    }
+    
+    // Inflation is bounded per step: compressed input that would expand past
+    // Inflater::output_step waits in compressed_ for the next co_fill()
+    void decode(const char* data, size_t size) {
+        if (inflater_) {
+            size_t used = inflater_->feed(data, size, decoded_, Inflater::output_step);
+            compressed_.assign(data + used, size - used);
+        } else {
+            decoded_.append(data, size);
+        }
+    }
+    
+    bool inflating() const {
+        return inflater_ && (!compressed_.empty() || inflater_->stalled());
+    }
+    
+    void inflate_step() {
+        try {
+            size_t used = inflater_->feed(compressed_.data(), compressed_.size(), decoded_, Inflater::output_step);
+            compressed_.erase(0, used);
+        } catch (const std::system_error&) {
+            finish(false);
+            throw;
+        }
+    }
+    
+    void complete() {
+        body_complete_ = true;
+        finish(reusable_);
+    }
+    
+    // Hand back the connection and the host's concurrency slot
+    void finish(bool reusable) {
+        lease_.finish(reusable);
+        permit_.release();
+    }
+    
+    template<typename T>
+    asio::awaitable<T> co_guarded(asio::awaitable<T> op) {
+        if (!deadline_ && !token_) {
+            co_return co_await std::move(op);
+        }
+        co_return co_await co_with_cancellation(std::move(op), deadline_, token_);
+    }
+    
+    HttpResponse head_;
+    std::string buffered_;              // body bytes that arrived with the headers
+    ReadSome read_some_;
+    SpliceTo splice_;
+    ConnectionLease lease_;
+    HostLimiterRegistry::Permit permit_;
+    std::optional<std::chrono::steady_clock::time_point> deadline_;
+    std::optional<CancellationToken> token_;
+    Framing framing_{Framing::until_close};
+    unsigned long long remaining_{0};   // Content-Length bytes still to read
+    bool reusable_{false};
+    bool body_complete_{false};
+    ChunkedDecoder chunked_;
+    std::unique_ptr<Inflater> inflater_;
+    std::vector<char> raw_buffer_;
+    std::string compressed_;            // body bytes read but not yet inflated
+    std::string decoded_;               // decoded bytes not yet handed out
+    size_t decoded_pos_{0};
+};
+
+}
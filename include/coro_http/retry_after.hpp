@@ -0,0 +1,217 @@
+#pragma once
+
+#include "http_response.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace coro_http {
+
+// Parse an HTTP-date (RFC 9110 section 5.6.7) in any of its three forms:
+//   IMF-fixdate  "Sun, 06 Nov 1994 08:49:37 GMT"
+//   RFC 850      "Sunday, 06-Nov-94 08:49:37 GMT"
+//   asctime      "Sun Nov  6 08:49:37 1994"
+inline std::optional<std::chrono::system_clock::time_point> parse_http_date(const std::string& value) {
+    static const char* const months[] = {"jan", "feb", "mar", "apr", "may", "jun",
+                                         "jul", "aug", "sep", "oct", "nov", "dec"};
+    
+    std::string normalized = value;
+    std::replace(normalized.begin(), normalized.end(), ',', ' ');
+    std::replace(normalized.begin(), normalized.end(), '-', ' ');
+    
+    std::istringstream tokens(normalized);
+    std::string token;
+    int day = -1, month = -1, year = -1;
+    int hour = -1, minute = -1, second = -1;
+    
+    while (tokens >> token) {
+        if (token.find(':') != std::string::npos) {
+            if (std::sscanf(token.c_str(), "%d:%d:%d", &hour, &minute, &second) != 3) {
+                return std::nullopt;
+            }
+        } else if (std::isdigit(static_cast<unsigned char>(token[0]))) {
+            // The day always comes before the year
+            int number = std::atoi(token.c_str());
+            if (day < 0) {
+                day = number;
+            } else if (year < 0) {
+                if (token.size() > 4) {
+                    return std::nullopt;
+                }
+                year = token.size() <= 2 ? (number < 70 ? 2000 + number : 1900 + number) : number;
+            }
+        } else if (month < 0 && token.size() == 3) {
+            std::transform(token.begin(), token.end(), token.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            for (int i = 0; i < 12; ++i) {
+                if (token == months[i]) {
+                    month = i + 1;
+                }
+            }
+        }
+    }
+    
+    if (day < 1 || day > 31 || month < 1 || year < 1970 ||
+        hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 60) {
+        return std::nullopt;
+    }
+    
+    // Days since the epoch for a proleptic Gregorian date (H. Hinnant's days_from_civil)
+    int y = year - (month <= 2 ? 1 : 0);
+    int era = y / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    long long days = static_cast<long long>(era) * 146097 + doe - 719468;
+    long long seconds = days * 86400 + hour * 3600 + minute * 60 + second;
+    
+    // Far-future dates saturate rather than overflow the clock's representation
+    using time_point = std::chrono::system_clock::time_point;
+    if (seconds > std::chrono::duration_cast<std::chrono::seconds>(time_point::max().time_since_epoch()).count()) {
+        return time_point::max();
+    }
+    return time_point(std::chrono::seconds(seconds));
+}
+
+namespace detail {
+
+// Longer server-requested delays are clamped to this; far beyond any
+// max_retry_after, but small enough to add to a clock without overflow
+constexpr long long max_delay_seconds = 10LL * 365 * 86400;
+
+inline std::chrono::milliseconds delay_from_seconds(long long seconds) {
+    return std::chrono::milliseconds(std::min(seconds, max_delay_seconds) * 1000);
+}
+
+}
+
+// Parse a Retry-After value, either delta-seconds or an HTTP-date.
+// Dates in the past yield a zero delay; absurdly long delays are clamped.
+inline std::optional<std::chrono::milliseconds> parse_retry_after(
+    const std::string& value,
+    std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) {
+    
+    size_t start = value.find_first_not_of(" \t");
+    if (start == std::string::npos) {
+        return std::nullopt;
+    }
+    size_t end = value.find_last_not_of(" \t") + 1;
+    std::string trimmed = value.substr(start, end - start);
+    
+    if (std::all_of(trimmed.begin(), trimmed.end(), [](unsigned char c) { return std::isdigit(c); })) {
+        try {
+            return detail::delay_from_seconds(std::stoll(trimmed));
+        } catch (...) {
+            return std::nullopt;
+        }
+    }
+    
+    auto date = parse_http_date(trimmed);
+    if (!date) {
+        return std::nullopt;
+    }
+    if (*date <= now) {
+        return std::chrono::milliseconds(0);
+    }
+    return std::min(std::chrono::ceil<std::chrono::milliseconds>(*date - now),
+                    detail::delay_from_seconds(detail::max_delay_seconds));
+}
+
+namespace detail {
+
+inline std::optional<long long> parse_header_number(const std::string& value) {
+    size_t start = value.find_first_not_of(" \t\"");
+    if (start == std::string::npos || !std::isdigit(static_cast<unsigned char>(value[start]))) {
+        return std::nullopt;
+    }
+    try {
+        return std::stoll(value.substr(start));
+    } catch (...) {
+        return std::nullopt;
+    }
+}
+
+// Reset values above this are epoch timestamps (as some X-RateLimit-Reset
+// implementations send) rather than delta-seconds
+constexpr long long epoch_reset_threshold = 1000000000;
+
+inline std::chrono::milliseconds reset_to_delay(long long reset, std::chrono::system_clock::time_point now) {
+    if (reset < epoch_reset_threshold) {
+        return std::chrono::milliseconds(reset * 1000);
+    }
+    long long now_seconds = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
+    if (reset - now_seconds > max_delay_seconds) {
+        return delay_from_seconds(max_delay_seconds);
+    }
+    auto at = std::chrono::system_clock::time_point(std::chrono::seconds(reset));
+    return at > now ? std::chrono::ceil<std::chrono::milliseconds>(at - now) : std::chrono::milliseconds(0);
+}
+
+}
+
+// How long the server asked us to stay away, if it did:
+// - Retry-After on 429 and 503 responses
+// - an exhausted quota in RateLimit-Remaining/RateLimit-Reset, the combined
+//   "RateLimit: limit=.., remaining=.., reset=.." (or "r=..;t=..") header, or
+//   X-RateLimit-Remaining/X-RateLimit-Reset
+inline std::optional<std::chrono::milliseconds> get_server_backoff(
+    const HttpResponse& response,
+    std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) {
+    
+    int status = response.status_code();
+    if (status == 429 || status == 503) {
+        std::string retry_after = response.get_header("Retry-After");
+        if (!retry_after.empty()) {
+            if (auto delay = parse_retry_after(retry_after, now)) {
+                return delay;
+            }
+        }
+    }
+    
+    std::optional<long long> remaining;
+    std::optional<long long> reset;
+    
+    std::string combined = response.get_header("RateLimit");
+    if (!combined.empty()) {
+        std::string normalized = combined;
+        std::replace(normalized.begin(), normalized.end(), ';', ',');
+        std::istringstream params(normalized);
+        std::string param;
+        while (std::getline(params, param, ',')) {
+            size_t eq = param.find('=');
+            if (eq == std::string::npos) continue;
+            std::string key = param.substr(0, eq);
+            key.erase(0, key.find_first_not_of(" \t"));
+            key.erase(key.find_last_not_of(" \t") + 1);
+            auto number = detail::parse_header_number(param.substr(eq + 1));
+            if (key == "remaining" || key == "r") {
+                remaining = number;
+            } else if (key == "reset" || key == "t") {
+                reset = number;
+            }
+        }
+    }
+    
+    for (const char* prefix : {"RateLimit-", "X-RateLimit-"}) {
+        if (!remaining) {
+            remaining = detail::parse_header_number(response.get_header(std::string(prefix) + "Remaining"));
+        }
+        if (!reset) {
+            reset = detail::parse_header_number(response.get_header(std::string(prefix) + "Reset"));
+        }
+    }
+    
+    if (remaining && *remaining == 0 && reset) {
+        return detail::reset_to_delay(*reset, now);
+    }
+    
+    return std::nullopt;
+}
+
+}
@@ -1,12 +1,40 @@
 #pragma once
 
+#include "error.hpp"
+#include <algorithm>
 #include <chrono>
-#include <thread>
+#include <cmath>
+#include <cstdint>
 #include <random>
 #include <string>
+#include <system_error>
 
 namespace coro_http {
 
+namespace detail {
+
+// Uniform double in [0, 1) from a per-thread xorshift64* generator. Seeded once
+// per thread, so jitter costs no lock and no random_device syscall per call.
+inline double thread_local_uniform() {
+    thread_local uint64_t state = [] {
+        std::random_device rd;
+        uint64_t seed = (static_cast<uint64_t>(rd()) << 32) ^ rd();
+        return seed ? seed : 0x9E3779B97F4A7C15ull;
+    }();
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return static_cast<double>((state * 0x2545F4914F6CDD1Dull) >> 11) * 0x1.0p-53;
+}
+
+}
+
+// Retry progress of a single request. RetryPolicy itself holds no per-request
+// state and is shared by all concurrent requests.
+struct RetryState {
+    int attempt{0};    // retries already made
+};
+
 class RetryPolicy {
 public:
     RetryPolicy(int max_retries, 
@@ -22,92 +50,68 @@ public:
           max_delay_(max_delay),
           retry_on_timeout_(retry_on_timeout),
           retry_on_connection_error_(retry_on_connection_error),
-          retry_on_5xx_(retry_on_5xx),
-          current_attempt_(0) {}
+          retry_on_5xx_(retry_on_5xx) {}
     
-    bool should_retry(const std::exception& e, int status_code = 0) const {
-        if (current_attempt_ >= max_retries_) {
+    bool can_retry(const RetryState& state) const {
+        return state.attempt < max_retries_;
+    }
+    
+    // Whether a failed attempt is worth retrying, judged by its error code.
+    // A request that may have reached the server is only retried when it is
+    // idempotent; one that was never sent (HttpError with !request_sent())
+    // is always safe to replay.
+    bool should_retry(const std::exception& e, const RetryState& state, bool idempotent = true) const {
+        if (!can_retry(state)) {
             return false;
         }
         
-        std::string error_msg = e.what();
-        
-        // Check for timeout errors
-        if (retry_on_timeout_) {
-            if (error_msg.find("timeout") != std::string::npos ||
-                error_msg.find("Timeout") != std::string::npos ||
-                error_msg.find("timed out") != std::string::npos) {
-                return true;
-            }
+        auto* system_error = dynamic_cast<const std::system_error*>(&e);
+        if (!system_error) {
+            return false;
         }
         
-        // Check for connection errors
-        if (retry_on_connection_error_) {
-            if (error_msg.find("Connection") != std::string::npos ||
-                error_msg.find("connection") != std::string::npos ||
-                error_msg.find("refused") != std::string::npos ||
-                error_msg.find("reset") != std::string::npos ||
-                error_msg.find("broken pipe") != std::string::npos ||
-                error_msg.find("network") != std::string::npos) {
-                return true;
-            }
+        auto* http_error = dynamic_cast<const HttpError*>(&e);
+        bool request_sent = !http_error || http_error->request_sent();
+        if (request_sent && !idempotent) {
+            return false;
         }
         
-        // Check for 5xx server errors
-        if (retry_on_5xx_ && status_code >= 500 && status_code < 600) {
-            return true;
+        switch (classify_error(system_error->code())) {
+            case ErrorKind::timeout:
+                return retry_on_timeout_;
+            case ErrorKind::connect_refused:
+            case ErrorKind::connection_reset:
+            case ErrorKind::eof_before_headers:
+            case ErrorKind::dns:
+            case ErrorKind::tls:
+                return retry_on_connection_error_;
+            // A rejected certificate or a name that does not exist fails the same way again
+            default:
+                return false;
         }
-        
-        return false;
     }
     
-    std::chrono::milliseconds get_delay() const {
-        if (current_attempt_ == 0) {
-            return initial_delay_;
-        }
-        
+    bool should_retry_status(int status_code) const {
+        return retry_on_5xx_ && status_code >= 500 && status_code < 600;
+    }
+    
+    // Delay before the next retry: initial_delay * backoff_factor^attempt
+    std::chrono::milliseconds get_delay(const RetryState& state) const {
         // Calculate exponential backoff with jitter
         double base_delay = initial_delay_.count() * 
-                           std::pow(backoff_factor_, current_attempt_);
+                           std::pow(backoff_factor_, state.attempt);
         
         // Add jitter (±25% random variation)
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_real_distribution<> dis(0.75, 1.25);
-        double jitter = dis(gen);
-        
-        auto delay = std::chrono::milliseconds(
-            static_cast<long long>(base_delay * jitter)
-        );
+        double jitter = 0.75 + 0.5 * detail::thread_local_uniform();
         
         // Cap at max delay
-        if (delay > max_delay_) {
-            delay = max_delay_;
-        }
-        
-        return delay;
-    }
-    
-    void increment_attempt() {
-        current_attempt_++;
-    }
-    
-    void reset() {
-        current_attempt_ = 0;
-    }
-    
-    int current_attempt() const {
-        return current_attempt_;
+        double capped = std::min(base_delay * jitter, static_cast<double>(max_delay_.count()));
+        return std::chrono::milliseconds(static_cast<long long>(capped));
     }
     
     int max_retries() const {
         return max_retries_;
     }
-    
-    void sleep_for_retry() const {
-        auto delay = get_delay();
-        std::this_thread::sleep_for(delay);
-    }
 
 private:
     int max_retries_;
@@ -117,7 +121,6 @@ private:
     bool retry_on_timeout_;
     bool retry_on_connection_error_;
     bool retry_on_5xx_;
-    mutable int current_attempt_;
 };
 
 }
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace coro_http {
+
+struct SegmentedDownloadOptions {
+    int connections{4};                         // Segments fetched at once, each on its own connection
+    uint64_t segment_size{16 * 1024 * 1024};    // Bytes per Range request; smaller objects use one request
+    bool resume{true};                          // Continue from the progress file of an interrupted download
+};
+
+// Byte range [start, end) of the object, of which the first `done` bytes are on disk
+struct DownloadSegment {
+    uint64_t start{0};
+    uint64_t end{0};
+    uint64_t done{0};
+
+    uint64_t size() const { return end - start; }
+    bool complete() const { return done == size(); }
+};
+
+// Progress of a segmented download, kept next to the destination file as
+// "<path>.part" until it completes. It records the object's size and validator
+// (ETag or Last-Modified), so a download is only resumed against the same object.
+struct DownloadState {
+    uint64_t size{0};
+    std::string validator;
+    std::vector<DownloadSegment> segments;
+
+    static DownloadState split(uint64_t size, const std::string& validator, uint64_t segment_size) {
+        DownloadState state;
+        state.size = size;
+        state.validator = validator;
+        for (uint64_t start = 0; start < size; start += segment_size) {
+            state.segments.push_back({start, std::min(size, start + segment_size), 0});
+        }
+        return state;
+    }
+
+    bool complete() const {
+        for (const auto& segment : segments) {
+            if (!segment.complete()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static std::optional<DownloadState> load(const std::string& path) {
+        std::ifstream in(path);
+        std::string magic;
+        DownloadState state;
+        size_t count = 0;
+        if (!(in >> magic >> state.size >> count) || magic != "coro-http-download/1") {
+            return std::nullopt;
+        }
+        in.ignore(1);
+        std::getline(in, state.validator);
+
+        uint64_t expected = 0;
+        for (size_t i = 0; i < count; ++i) {
+            DownloadSegment segment;
+            if (!(in >> segment.start >> segment.end >> segment.done) || segment.start != expected ||
+                segment.end <= segment.start || segment.done > segment.size()) {
+                return std::nullopt;
+            }
+            expected = segment.end;
+            state.segments.push_back(segment);
+        }
+        if (expected != state.size) {
+            return std::nullopt;
+        }
+        return state;
+    }
+
+    // Written to a temporary file and renamed over the old one, so an interruption
+    // leaves either the previous or the new progress behind
+    void save(const std::string& path) const {
+        std::string temp = path + ".tmp";
+        {
+            std::ofstream out(temp, std::ios::trunc);
+            out << "coro-http-download/1 " << size << " " << segments.size() << "\n" << validator << "\n";
+            for (const auto& segment : segments) {
+                out << segment.start << " " << segment.end << " " << segment.done << "\n";
+            }
+            if (!out.flush()) {
+                return;
+            }
+        }
+        std::rename(temp.c_str(), path.c_str());
+    }
+};
+
+}
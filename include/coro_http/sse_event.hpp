@@ -1,7 +1,10 @@
 #pragma once
 
+#include <chrono>
 #include <string>
+#include <string_view>
 #include <map>
+#include <optional>
 #include <sstream>
 #include <vector>
 
@@ -190,4 +193,145 @@ inline void parse_sse_line(const std::string& line, SseEvent& current_event,
     }
 }
 
+// Incremental event stream parser for SSE bodies that arrive in pieces. Lines are
+// parsed in place in the buffer passed to feed(); only a line split across two
+// reads is copied, into a buffer that keeps its capacity. The event being built
+// is reused for the next one, so parsing a stream allocates nothing once the
+// buffers have grown to the size of its events.
+class SseParser {
+public:
+    // Parse `data`, calling on_event(const SseEvent&) for each complete event. The
+    // event is only valid during the call; copy what you want to keep.
+    template <typename OnEvent>
+    void feed(std::string_view data, OnEvent&& on_event) {
+        size_t start = 0;
+        if (!pending_.empty()) {
+            size_t newline = data.find('\n');
+            if (newline == std::string_view::npos) {
+                pending_.append(data);
+                return;
+            }
+            pending_.append(data.substr(0, newline));
+            process_line(pending_, on_event);
+            pending_.clear();
+            start = newline + 1;
+        }
+
+        while (start < data.size()) {
+            size_t newline = data.find('\n', start);
+            if (newline == std::string_view::npos) {
+                pending_.append(data.substr(start));
+                return;
+            }
+            process_line(data.substr(start, newline - start), on_event);
+            start = newline + 1;
+        }
+    }
+
+    // End of stream: a last line without a newline is still applied, but an event
+    // not terminated by a blank line is discarded
+    template <typename OnEvent>
+    void finish(OnEvent&& on_event) {
+        if (!pending_.empty()) {
+            process_line(pending_, on_event);
+            pending_.clear();
+        }
+        clear_event();
+    }
+
+    // Drop a partly received line and event, for a new connection to the same
+    // stream. The last event ID and retry interval are kept.
+    void reset() {
+        pending_.clear();
+        clear_event();
+    }
+
+    // ID of the last completed event block that had an id field, to be resumed
+    // from with Last-Event-ID; empty if none, or if the server reset it
+    const std::string& last_event_id() const { return last_event_id_; }
+
+    // Reconnection delay most recently set by a retry field, if any
+    std::optional<std::chrono::milliseconds> retry() const { return retry_; }
+
+private:
+    void clear_event() {
+        event_.type.clear();
+        event_.data.clear();
+        event_.id.clear();
+        event_.retry.clear();
+        event_.fields.clear();
+        has_data_ = false;
+        has_id_ = false;
+    }
+
+    template <typename OnEvent>
+    void process_line(std::string_view line, OnEvent& on_event) {
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+
+        // Empty line indicates end of event
+        if (line.empty()) {
+            if (has_id_) {
+                last_event_id_.assign(event_.id);
+            }
+            if (has_data_ || !event_.type.empty() || !event_.id.empty() || !event_.retry.empty()) {
+                if (!event_.empty()) {
+                    on_event(static_cast<const SseEvent&>(event_));
+                }
+                clear_event();
+            }
+            has_id_ = false;
+            return;
+        }
+
+        // Line starting with : is a comment
+        if (line.front() == ':') {
+            return;
+        }
+
+        std::string_view field = line;
+        std::string_view value;
+        size_t colon_pos = line.find(':');
+        if (colon_pos != std::string_view::npos) {
+            field = line.substr(0, colon_pos);
+            value = line.substr(colon_pos + 1);
+            if (!value.empty() && value.front() == ' ') {
+                value.remove_prefix(1);
+            }
+        }
+
+        if (field == "data") {
+            if (has_data_) {
+                event_.data += '\n';
+            }
+            event_.data.append(value);
+            has_data_ = true;
+        } else if (field == "event") {
+            event_.type.assign(value);
+        } else if (field == "id") {
+            // An ID containing NUL is ignored, as it could not be sent back
+            if (value.find('\0') == std::string_view::npos) {
+                event_.id.assign(value);
+                has_id_ = true;
+            }
+        } else if (field == "retry") {
+            event_.retry.assign(value);
+            if (!value.empty() && value.size() <= 9 &&
+                value.find_first_not_of("0123456789") == std::string_view::npos) {
+                retry_ = std::chrono::milliseconds(std::stol(std::string(value)));
+            }
+        } else {
+            event_.fields[std::string(field)].assign(value);
+        }
+    }
+
+    SseEvent event_;
+    bool has_data_{false};
+    bool has_id_{false};
+    std::string pending_;
+    std::string last_event_id_;
+    std::optional<std::chrono::milliseconds> retry_;
+};
+
 }
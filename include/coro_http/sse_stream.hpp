@@ -0,0 +1,210 @@
+#pragma once
+
+#include "sse_event.hpp"
+#include <asio.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace coro_http {
+
+// What an SseEventStream does with a new event while its queue is full
+enum class SseOverflowPolicy {
+    block,        // Stop reading from the connection until the consumer catches up
+    drop_oldest,  // Discard the oldest queued event
+    coalesce,     // Replace the newest queued event of the same type, else drop the oldest
+};
+
+struct SseStreamOptions {
+    size_t capacity{256};   // Queued events before the overflow policy applies
+    SseOverflowPolicy overflow{SseOverflowPolicy::block};
+};
+
+// Bounded queue between the coroutine reading an event stream and its consumer.
+// Both sides run on the same io_context; it is not safe to use from other threads.
+// With the block policy a read may still add all the events it carried to a full
+// queue; the next read waits until the queue has room again.
+class SseEventQueue {
+public:
+    SseEventQueue(const asio::any_io_executor& executor, SseStreamOptions options)
+        : options_(options),
+          readable_(executor, asio::steady_timer::time_point::max()),
+          writable_(executor, asio::steady_timer::time_point::max()) {
+        options_.capacity = std::max<size_t>(options_.capacity, 1);
+    }
+
+    void push(const SseEvent& event) {
+        if (closed_) {
+            return;
+        }
+        if (events_.size() >= options_.capacity) {
+            if (options_.overflow == SseOverflowPolicy::coalesce) {
+                auto same_type = std::find_if(events_.rbegin(), events_.rend(), [&](const SseEvent& queued) {
+                    return queued.type == event.type;
+                });
+                if (same_type != events_.rend()) {
+                    *same_type = event;
+                    ++dropped_;
+                    return;
+                }
+            }
+            if (options_.overflow != SseOverflowPolicy::block) {
+                events_.pop_front();
+                ++dropped_;
+            }
+        }
+        events_.push_back(event);
+        readable_.expires_at(asio::steady_timer::time_point::min());
+    }
+
+    // Producer side: wait until the consumer has made room, for the block policy.
+    // Throws operation_aborted once the consumer has closed the stream.
+    asio::awaitable<void> co_wait_room() {
+        while (!closed_ && options_.overflow == SseOverflowPolicy::block && events_.size() >= options_.capacity) {
+            writable_.expires_at(asio::steady_timer::time_point::max());
+            co_await writable_.async_wait(asio::as_tuple(asio::use_awaitable));
+            co_await throw_if_cancelled();
+        }
+        if (closed_) {
+            throw std::system_error(make_error_code(asio::error::operation_aborted));
+        }
+    }
+
+    // End of the stream. Queued events can still be taken; after them the consumer
+    // gets `error`, or the end of the stream. Only the first call counts.
+    void close(std::exception_ptr error = nullptr) {
+        if (closed_) {
+            return;
+        }
+        closed_ = true;
+        error_ = std::move(error);
+        readable_.expires_at(asio::steady_timer::time_point::min());
+        writable_.expires_at(asio::steady_timer::time_point::min());
+    }
+
+    // Consumer side: the next event, or nullopt at the end of the stream
+    asio::awaitable<std::optional<SseEvent>> co_pop() {
+        co_await co_wait_readable();
+        if (events_.empty()) {
+            co_return std::nullopt;
+        }
+        SseEvent event = std::move(events_.front());
+        events_.pop_front();
+        writable_.expires_at(asio::steady_timer::time_point::min());
+        co_return std::move(event);
+    }
+
+    // Consumer side: every queued event, up to `max_events`; empty at the end of the stream
+    asio::awaitable<std::vector<SseEvent>> co_pop_batch(size_t max_events) {
+        co_await co_wait_readable();
+        size_t count = std::min(std::max<size_t>(max_events, 1), events_.size());
+        std::vector<SseEvent> batch(std::make_move_iterator(events_.begin()),
+                                    std::make_move_iterator(events_.begin() + count));
+        events_.erase(events_.begin(), events_.begin() + count);
+        writable_.expires_at(asio::steady_timer::time_point::min());
+        co_return batch;
+    }
+
+    // Drop what is queued and end the stream for the consumer, without an error
+    void discard() {
+        events_.clear();
+        close();
+    }
+
+    bool closed() const { return closed_; }
+    size_t size() const { return events_.size(); }
+
+    // Events discarded or replaced by the drop_oldest and coalesce policies
+    uint64_t dropped() const { return dropped_; }
+
+private:
+    // Wait for an event or the end of the stream, which throws the stream's error
+    // once no events are left
+    asio::awaitable<void> co_wait_readable() {
+        while (events_.empty() && !closed_) {
+            readable_.expires_at(asio::steady_timer::time_point::max());
+            co_await readable_.async_wait(asio::as_tuple(asio::use_awaitable));
+            co_await throw_if_cancelled();
+        }
+        if (events_.empty() && error_) {
+            std::rethrow_exception(error_);
+        }
+    }
+
+    // The waits above swallow the timer's own cancellation; a cancelled caller must
+    // not go on waiting
+    static asio::awaitable<void> throw_if_cancelled() {
+        auto state = co_await asio::this_coro::cancellation_state;
+        if (state.cancelled() != asio::cancellation_type::none) {
+            throw std::system_error(make_error_code(asio::error::operation_aborted));
+        }
+    }
+
+    SseStreamOptions options_;
+    std::deque<SseEvent> events_;
+    asio::steady_timer readable_;  // Expires when an event arrives or the stream ends
+    asio::steady_timer writable_;  // Expires when the consumer takes events
+    bool closed_{false};
+    std::exception_ptr error_;
+    uint64_t dropped_{0};
+};
+
+// Pull-based event stream, from CoroHttpClient::open_event_stream(). The events
+// are read by a coroutine of the client's into a bounded queue; next() takes them
+// one at a time, next_batch() all that have arrived. Closing or destroying the
+// stream stops the reading coroutine and closes its connection.
+class SseEventStream {
+public:
+    SseEventStream(std::shared_ptr<SseEventQueue> queue, std::shared_ptr<asio::cancellation_signal> stop)
+        : queue_(std::move(queue)), stop_(std::move(stop)) {}
+
+    SseEventStream(SseEventStream&&) = default;
+    SseEventStream& operator=(SseEventStream&& other) noexcept {
+        if (this != &other) {
+            close();
+            queue_ = std::move(other.queue_);
+            stop_ = std::move(other.stop_);
+        }
+        return *this;
+    }
+
+    ~SseEventStream() {
+        close();
+    }
+
+    // The next event; nullopt once the stream has ended or been closed. A failed
+    // stream throws its error once the events before the failure have been taken.
+    asio::awaitable<std::optional<SseEvent>> next() {
+        co_return co_await queue_->co_pop();
+    }
+
+    // Every event that has arrived since the last call, waiting for at least one;
+    // empty once the stream has ended. Fails like next().
+    asio::awaitable<std::vector<SseEvent>> next_batch(size_t max_events = std::numeric_limits<size_t>::max()) {
+        co_return co_await queue_->co_pop_batch(max_events);
+    }
+
+    // Stop reading and drop queued events. Call from the client's io_context.
+    void close() {
+        if (queue_ && !queue_->closed()) {
+            queue_->discard();
+            stop_->emit(asio::cancellation_type::terminal);
+        }
+    }
+
+    uint64_t dropped() const { return queue_->dropped(); }
+
+private:
+    std::shared_ptr<SseEventQueue> queue_;
+    std::shared_ptr<asio::cancellation_signal> stop_;
+};
+
+}
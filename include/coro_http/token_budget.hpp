@@ -0,0 +1,37 @@
+#pragma once
+
+#include <algorithm>
+#include <mutex>
+
+namespace coro_http {
+
+// Caps extra requests (retries, hedges) to a fraction of primary traffic as a
+// token bucket: every primary request deposits `ratio` tokens and every extra
+// request spends one whole token. The bucket holds at most `max_tokens` and
+// starts with `initial_tokens`.
+class TokenBudget {
+public:
+    TokenBudget(double ratio, double max_tokens, double initial_tokens)
+        : ratio_(ratio), max_tokens_(max_tokens), tokens_(std::min(initial_tokens, max_tokens)) {}
+    
+    void deposit() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tokens_ = std::min(max_tokens_, tokens_ + ratio_);
+    }
+    
+    bool try_withdraw() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Tolerate rounding so that exactly 1/ratio deposits buy one token
+        if (tokens_ < 1.0 - 1e-9) return false;
+        tokens_ = std::max(0.0, tokens_ - 1.0);
+        return true;
+    }
+
+private:
+    double ratio_;
+    double max_tokens_;
+    double tokens_;
+    std::mutex mutex_;
+};
+
+}
@@ -0,0 +1,177 @@
+#include "coro_http/coro_http_client.hpp"
+#include "test_server.hpp"
+#include <cassert>
+#include <iostream>
+#include <chrono>
+
+/**
+ * Test server backpressure handling
+ *
+ * Key Points:
+ * - Retry-After is understood as delta-seconds and as all three HTTP-date forms
+ * - RateLimit-* / X-RateLimit-* headers with an exhausted quota ask for backoff
+ * - A paused host holds back every request to it until the pause ends
+ * - 429/503 are only retried for requests that are safe to send again
+ */
+
+using namespace std::chrono_literals;
+
+int test_parse_retry_after() {
+    std::cout << "Test: Parse Retry-After\n";
+    
+    assert(coro_http::parse_retry_after("120") == 120000ms);
+    assert(coro_http::parse_retry_after(" 0 ") == 0ms);
+    assert(!coro_http::parse_retry_after("soon"));
+    assert(!coro_http::parse_retry_after(""));
+    
+    // Huge values are clamped instead of overflowing
+    auto clamped = coro_http::parse_retry_after("9000000000000000000");
+    assert(clamped && *clamped > 24h * 365 && *clamped < 24h * 365 * 20);
+    auto far_date = coro_http::parse_retry_after("Fri, 31 Dec 9999 23:59:59 GMT");
+    assert(far_date && *far_date == *clamped);
+    assert(!coro_http::parse_retry_after("Fri, 31 Dec 99999 23:59:59 GMT"));
+    
+    // 784111777 is Sun, 06 Nov 1994 08:49:37 GMT
+    auto expected = std::chrono::system_clock::time_point(std::chrono::seconds(784111777));
+    assert(coro_http::parse_http_date("Sun, 06 Nov 1994 08:49:37 GMT") == expected);
+    assert(coro_http::parse_http_date("Sunday, 06-Nov-94 08:49:37 GMT") == expected);
+    assert(coro_http::parse_http_date("Sun Nov  6 08:49:37 1994") == expected);
+    assert(!coro_http::parse_http_date("Sun, 06 Foo 1994 08:49:37 GMT"));
+    
+    auto now = expected - 30s;
+    assert(coro_http::parse_retry_after("Sun, 06 Nov 1994 08:49:37 GMT", now) == 30000ms);
+    assert(coro_http::parse_retry_after("Sun, 06 Nov 1994 08:49:37 GMT", expected + 1s) == 0ms);
+    
+    std::cout << "✓ Parse Retry-After test passed\n";
+    return 0;
+}
+
+int test_server_backoff_headers() {
+    std::cout << "Test: Server backoff headers\n";
+    
+    coro_http::HttpResponse too_many;
+    too_many.set_status_code(429);
+    too_many.add_header("Retry-After", "3");
+    assert(coro_http::get_server_backoff(too_many) == 3000ms);
+    
+    // Retry-After on a redirect means something else
+    coro_http::HttpResponse moved;
+    moved.set_status_code(301);
+    moved.add_header("Retry-After", "3");
+    assert(!coro_http::get_server_backoff(moved));
+    
+    coro_http::HttpResponse exhausted;
+    exhausted.set_status_code(200);
+    exhausted.add_header("RateLimit-Remaining", "0");
+    exhausted.add_header("RateLimit-Reset", "7");
+    assert(coro_http::get_server_backoff(exhausted) == 7000ms);
+    
+    coro_http::HttpResponse combined;
+    combined.set_status_code(200);
+    combined.add_header("RateLimit", "limit=100, remaining=0, reset=2");
+    assert(coro_http::get_server_backoff(combined) == 2000ms);
+    
+    coro_http::HttpResponse quota_left;
+    quota_left.set_status_code(200);
+    quota_left.add_header("X-RateLimit-Remaining", "42");
+    quota_left.add_header("X-RateLimit-Reset", "60");
+    assert(!coro_http::get_server_backoff(quota_left));
+    
+    coro_http::HttpResponse far_reset;
+    far_reset.set_status_code(200);
+    far_reset.add_header("X-RateLimit-Remaining", "0");
+    far_reset.add_header("X-RateLimit-Reset", "9000000000000000000");
+    assert(coro_http::get_server_backoff(far_reset) == coro_http::parse_retry_after("9000000000000000000"));
+    
+    std::cout << "✓ Server backoff headers test passed\n";
+    return 0;
+}
+
+int test_host_pause() {
+    std::cout << "Test: Paused host holds back requests\n";
+    
+    asio::io_context io_context;
+    coro_http::HostLimiterRegistry registry;
+    registry.pause("api.example.com", std::chrono::steady_clock::now() + 100ms);
+    assert(registry.paused_until("api.example.com"));
+    assert(!registry.paused_until("other.example.com"));
+    
+    std::chrono::steady_clock::duration paused_wait{};
+    std::chrono::steady_clock::duration other_wait{};
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        auto started = std::chrono::steady_clock::now();
+        auto permit = co_await registry.co_acquire("api.example.com", "/");
+        paused_wait = std::chrono::steady_clock::now() - started;
+    }, asio::detached);
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        auto started = std::chrono::steady_clock::now();
+        auto permit = co_await registry.co_acquire("other.example.com", "/");
+        other_wait = std::chrono::steady_clock::now() - started;
+    }, asio::detached);
+    
+    io_context.run();
+    
+    assert(paused_wait >= 90ms);
+    assert(other_wait < 50ms);
+    assert(!registry.paused_until("api.example.com"));
+    
+    std::cout << "✓ Host pause test passed\n";
+    return 0;
+}
+
+int test_status_retry_idempotency() {
+    std::cout << "Test: 503 is only retried for idempotent requests\n";
+    
+    coro_http::ClientConfig config;
+    config.enable_retry = true;
+    config.max_retries = 2;
+    config.initial_retry_delay = 10ms;
+    
+    asio::io_context io_context;
+    TestServer server(io_context, [](TestConnection& connection, const std::string&) -> asio::awaitable<void> {
+        co_await connection.co_write("HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n");
+    });
+    coro_http::CoroHttpClient client(io_context, config);
+    
+    int get_status = 0;
+    int post_status = 0;
+    int get_requests = 0;
+    int post_requests = 0;
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        auto response = co_await client.co_get(server.url("/"));
+        get_status = response.status_code();
+        get_requests = server.requests();
+        
+        // The server may already have acted on the POST
+        response = co_await client.co_post(server.url("/"), "data");
+        post_status = response.status_code();
+        post_requests = server.requests() - get_requests;
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+    
+    assert(get_status == 503 && get_requests == 3);
+    assert(post_status == 503 && post_requests == 1);
+    
+    std::cout << "✓ Status retry idempotency test passed\n";
+    return 0;
+}
+
+int main() {
+    std::cout << "=== Backpressure Tests ===\n\n";
+    
+    try {
+        test_parse_retry_after();
+        test_server_backoff_headers();
+        test_host_pause();
+        test_status_retry_idempotency();
+        
+        std::cout << "\n=== All backpressure tests passed ===\n";
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << "\n";
+        return 1;
+    }
+}
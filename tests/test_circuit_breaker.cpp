@@ -0,0 +1,251 @@
+#include "coro_http/coro_http_client.hpp"
+#include "test_server.hpp"
+#include <cassert>
+#include <iostream>
+#include <chrono>
+
+/**
+ * Test the per-host circuit breaker
+ *
+ * Key Points:
+ * - Consecutive failures or a high failure ratio open the circuit
+ * - An open circuit rejects requests until open_duration has passed
+ * - Half-open admits probes one at a time and closes once they all succeed
+ * - Requests to a dead host fail fast without touching the network
+ * - A host that accepts connections and then hangs trips the breaker through request_timeout
+ */
+
+using namespace std::chrono_literals;
+using coro_http::CircuitState;
+
+int test_consecutive_failures() {
+    std::cout << "Test: Consecutive failures open the circuit\n";
+    
+    coro_http::CircuitBreakerOptions options;
+    options.failure_threshold = 3;
+    options.open_duration = 1000ms;
+    options.half_open_probes = 2;
+    coro_http::CircuitBreaker breaker(options);
+    auto now = std::chrono::steady_clock::now();
+    
+    for (int i = 0; i < 3; ++i) {
+        bool allowed = breaker.allow(now);
+        assert(allowed);
+        breaker.on_failure(false, now);
+    }
+    assert(breaker.state() == CircuitState::open);
+    bool allowed = breaker.allow(now + 500ms);
+    assert(!allowed);
+    
+    // Half-open: one probe at a time
+    now += 1000ms;
+    allowed = breaker.allow(now);
+    assert(allowed);
+    assert(breaker.state() == CircuitState::half_open);
+    allowed = breaker.allow(now);
+    assert(!allowed);
+    breaker.on_success(true, now);
+    assert(breaker.state() == CircuitState::half_open);
+    allowed = breaker.allow(now);
+    assert(allowed);
+    breaker.on_success(true, now);
+    assert(breaker.state() == CircuitState::closed);
+    
+    auto stats = breaker.get_stats(now);
+    assert(stats.times_opened == 1);
+    assert(stats.times_half_opened == 1);
+    assert(stats.times_closed == 1);
+    assert(stats.rejected == 2);
+    
+    std::cout << "✓ Consecutive failures test passed\n";
+    return 0;
+}
+
+int test_probe_failure_reopens() {
+    std::cout << "Test: Failed probe reopens the circuit\n";
+    
+    coro_http::CircuitBreakerOptions options;
+    options.failure_threshold = 1;
+    options.open_duration = 100ms;
+    coro_http::CircuitBreaker breaker(options);
+    auto now = std::chrono::steady_clock::now();
+    
+    breaker.on_failure(false, now);
+    assert(breaker.state() == CircuitState::open);
+    
+    // A cancelled probe frees its slot without deciding anything
+    now += 100ms;
+    bool allowed = breaker.allow(now);
+    assert(allowed);
+    breaker.on_ignored(true);
+    allowed = breaker.allow(now);
+    assert(allowed);
+    breaker.on_failure(true, now);
+    assert(breaker.state() == CircuitState::open);
+    allowed = breaker.allow(now + 50ms);
+    assert(!allowed);
+    assert(breaker.get_stats(now).times_opened == 2);
+    
+    // Late outcome of a request admitted while closed does not count as a probe
+    now += 100ms;
+    allowed = breaker.allow(now);
+    assert(allowed);
+    breaker.on_success(false, now);
+    allowed = breaker.allow(now);
+    assert(!allowed);
+    
+    std::cout << "✓ Probe failure test passed\n";
+    return 0;
+}
+
+int test_failure_rate() {
+    std::cout << "Test: Failure ratio opens the circuit\n";
+    
+    coro_http::CircuitBreakerOptions options;
+    options.failure_threshold = 100;
+    options.failure_rate_threshold = 0.5;
+    options.minimum_requests = 10;
+    coro_http::CircuitBreaker breaker(options);
+    auto now = std::chrono::steady_clock::now();
+    
+    // Alternating outcomes never build a streak, but half of them fail
+    for (int i = 0; i < 4; ++i) {
+        breaker.on_success(false, now);
+        breaker.on_failure(false, now);
+    }
+    assert(breaker.state() == CircuitState::closed);
+    breaker.on_success(false, now);
+    breaker.on_failure(false, now);
+    assert(breaker.state() == CircuitState::open);
+    
+    // Outcomes older than the window are forgotten
+    coro_http::CircuitBreaker fresh(options);
+    for (int i = 0; i < 4; ++i) {
+        fresh.on_failure(false, now);
+        fresh.on_success(false, now);
+    }
+    fresh.on_success(false, now);
+    now += options.window + 1000ms;
+    fresh.on_failure(false, now);
+    fresh.on_failure(false, now);
+    assert(fresh.state() == CircuitState::closed);
+    assert(fresh.get_stats(now).failure_rate == 1.0);
+    
+    std::cout << "✓ Failure ratio test passed\n";
+    return 0;
+}
+
+int test_client_fails_fast() {
+    std::cout << "Test: Client fails fast while the circuit is open\n";
+    
+    asio::io_context io_context;
+    
+    // A port nothing listens on
+    unsigned short port;
+    {
+        asio::ip::tcp::acceptor acceptor(io_context, {asio::ip::make_address("127.0.0.1"), 0});
+        port = acceptor.local_endpoint().port();
+    }
+    std::string url = "http://127.0.0.1:" + std::to_string(port) + "/";
+    
+    coro_http::ClientConfig config;
+    config.enable_circuit_breaker = true;
+    config.circuit_failure_threshold = 2;
+    config.circuit_open_duration = std::chrono::milliseconds(60000);
+    coro_http::CoroHttpClient client(io_context, config);
+    
+    int refused = 0;
+    int rejected = 0;
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        for (int i = 0; i < 4; ++i) {
+            try {
+                co_await client.co_get(url);
+            } catch (const coro_http::HttpError& e) {
+                if (e.code() == coro_http::error::circuit_open) {
+                    assert(!e.request_sent());
+                    ++rejected;
+                } else {
+                    ++refused;
+                }
+            }
+        }
+    }, asio::detached);
+    io_context.run();
+    
+    assert(refused == 2);
+    assert(rejected == 2);
+    auto stats = client.get_circuit_stats("127.0.0.1:" + std::to_string(port));
+    assert(stats.state == CircuitState::open);
+    assert(stats.times_opened == 1);
+    assert(stats.rejected == 2);
+    
+    // Circuits are kept per host and port
+    assert(client.get_circuit_stats("127.0.0.1:1").state == CircuitState::closed);
+    
+    std::cout << "✓ Client fail-fast test passed\n";
+    return 0;
+}
+
+int test_request_timeout_trips() {
+    std::cout << "Test: Requests that run into request_timeout count as failures\n";
+    
+    asio::io_context io_context;
+    
+    // Accepts connections and never answers
+    TestServer server(io_context, [](TestConnection&, const std::string&) -> asio::awaitable<void> {
+        co_return;
+    });
+    std::string url = server.url("/");
+    
+    coro_http::ClientConfig config;
+    config.enable_circuit_breaker = true;
+    config.circuit_failure_threshold = 2;
+    config.circuit_open_duration = std::chrono::milliseconds(60000);
+    config.request_timeout = std::chrono::milliseconds(100);
+    coro_http::CoroHttpClient client(io_context, config);
+    
+    int timed_out = 0;
+    int rejected = 0;
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        for (int i = 0; i < 3; ++i) {
+            try {
+                co_await client.co_get(url);
+            } catch (const std::system_error& e) {
+                if (e.code() == coro_http::error::circuit_open) {
+                    ++rejected;
+                } else if (e.code() == asio::error::timed_out) {
+                    ++timed_out;
+                }
+            }
+        }
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+    
+    assert(timed_out == 2);
+    assert(rejected == 1);
+    assert(client.get_circuit_stats(server.host_port()).state == CircuitState::open);
+    
+    std::cout << "✓ Request timeout test passed\n";
+    return 0;
+}
+
+int main() {
+    std::cout << "=== Circuit Breaker Tests ===\n\n";
+    
+    try {
+        test_consecutive_failures();
+        test_probe_failure_reopens();
+        test_failure_rate();
+        test_client_fails_fast();
+        test_request_timeout_trips();
+        
+        std::cout << "\n=== All circuit breaker tests passed ===\n";
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << "\n";
+        return 1;
+    }
+}
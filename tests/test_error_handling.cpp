@@ -1,7 +1,10 @@
 #include "coro_http/coro_http_client.hpp"
+#include "test_server.hpp"
 #include <cassert>
 #include <iostream>
 #include <stdexcept>
+#include <chrono>
+#include <memory>
 
 /**
  * Test error handling in coroutines
@@ -11,6 +14,8 @@
  * - Proper cleanup on error paths
  * - No resource leaks on exception
  * - Timeout handling (common error case)
+ * - Errors are classified by error_code, not by message text
+ * - Requests on a pooled connection the server already closed are replayed
  */
 
 int test_network_error_handling() {
@@ -174,6 +179,107 @@ int test_memory_limit_exceeded() {
     return 0;
 }
 
+int test_error_classification() {
+    std::cout << "Test: Error classification\n";
+    
+    using coro_http::ErrorKind;
+    assert(coro_http::classify_error(asio::error::timed_out) == ErrorKind::timeout);
+    assert(coro_http::classify_error(asio::error::connection_refused) == ErrorKind::connect_refused);
+    assert(coro_http::classify_error(asio::error::connection_reset) == ErrorKind::connection_reset);
+    assert(coro_http::classify_error(asio::error::broken_pipe) == ErrorKind::connection_reset);
+    assert(coro_http::classify_error(asio::error::host_not_found) == ErrorKind::dns_not_found);
+    assert(coro_http::classify_error(asio::error::host_not_found_try_again) == ErrorKind::dns);
+    assert(coro_http::classify_error(asio::ssl::error::stream_truncated) == ErrorKind::tls);
+    std::error_code verify_failed(1, asio::error::get_ssl_category());
+    assert(coro_http::classify_error(verify_failed) == ErrorKind::tls_handshake);
+    assert(coro_http::classify_error(asio::error::operation_aborted) == ErrorKind::cancelled);
+    assert(coro_http::classify_error(coro_http::error::empty_response) == ErrorKind::eof_before_headers);
+    assert(coro_http::classify_error(coro_http::error::protocol_error) == ErrorKind::protocol);
+    
+    // HttpError keeps the underlying code
+    coro_http::HttpError sent(asio::error::timed_out, true);
+    assert(sent.code() == asio::error::timed_out);
+    assert(sent.kind() == ErrorKind::timeout);
+    
+    coro_http::RetryPolicy policy(3, std::chrono::milliseconds(10), 2.0, std::chrono::milliseconds(100),
+                                  true, true, false);
+    coro_http::RetryState state;
+    
+    // A request that reached the server is only retried when idempotent
+    assert(policy.should_retry(sent, state, true));
+    assert(!policy.should_retry(sent, state, false));
+    coro_http::HttpError unsent(asio::error::connection_refused, false);
+    assert(policy.should_retry(unsent, state, false));
+    
+    // Connection errors are retried, but not a rejected certificate or an unknown host
+    assert(policy.should_retry(coro_http::HttpError(asio::error::host_not_found_try_again, false), state));
+    assert(!policy.should_retry(coro_http::HttpError(asio::error::host_not_found, false), state));
+    assert(!policy.should_retry(coro_http::HttpError(verify_failed, false), state));
+    
+    // Message text no longer decides anything
+    assert(!policy.should_retry(std::runtime_error("Connection timed out"), state));
+    assert(!policy.should_retry(std::system_error(coro_http::error::protocol_error), state));
+    assert(!policy.should_retry(std::system_error(asio::error::operation_aborted), state));
+    
+    assert(coro_http::HttpRequest(coro_http::HttpMethod::PUT, "http://x/").is_idempotent());
+    assert(!coro_http::HttpRequest(coro_http::HttpMethod::POST, "http://x/").is_idempotent());
+    assert(coro_http::HttpRequest(coro_http::HttpMethod::POST, "http://x/")
+               .add_header("Idempotency-Key", "42").is_idempotent());
+    
+    std::cout << "✓ Error classification test passed\n";
+    return 0;
+}
+
+// Answers each request with a keep-alive response, then closes the connection
+// as a server with a short idle timeout would.
+static asio::awaitable<void> answer_and_close(TestConnection& connection, const std::string&) {
+    co_await connection.co_write("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    connection.close();
+}
+
+int test_stale_connection_replay() {
+    std::cout << "Test: Stale pooled connection replay\n";
+    
+    // The second request goes out on the pooled connection the server has since
+    // closed. A GET is replayed on a new connection without spending a retry;
+    // a POST that was written is not, as the server may have processed it.
+    asio::io_context io_context;
+    TestServer server(io_context, answer_and_close);
+    coro_http::CoroHttpClient client(io_context);
+    
+    bool get_ok = false;
+    bool post_failed = false;
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        asio::steady_timer timer(io_context);
+        
+        co_await client.co_get(server.url("/"));
+        timer.expires_after(std::chrono::milliseconds(50));
+        co_await timer.async_wait(asio::use_awaitable);
+        
+        auto response = co_await client.co_get(server.url("/"));
+        get_ok = response.status_code() == 200;
+        
+        timer.expires_after(std::chrono::milliseconds(50));
+        co_await timer.async_wait(asio::use_awaitable);
+        try {
+            co_await client.co_post(server.url("/"), "data");
+        } catch (const coro_http::HttpError& e) {
+            post_failed = e.request_sent() && e.code() == coro_http::error::empty_response;
+        }
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+    
+    assert(get_ok);
+    assert(post_failed);
+    assert(server.accepted() == 2);
+    assert(client.get_retry_stats().stale_replays == 1);
+    
+    std::cout << "✓ Stale pooled connection replay test passed\n";
+    return 0;
+}
+
 int main() {
     std::cout << "=== Error Handling Tests ===\n\n";
     
@@ -187,6 +293,8 @@ int main() {
         test_error_recovery_and_retry();
         test_exception_in_response_handler();
         test_memory_limit_exceeded();
+        test_error_classification();
+        test_stale_connection_replay();
         
         std::cout << "\n=== All error handling tests passed ===\n";
         return 0;
@@ -0,0 +1,185 @@
+#include "coro_http/coro_http_client.hpp"
+#include <cassert>
+#include <iostream>
+#include <chrono>
+#include <thread>
+
+/**
+ * Test per-host and per-route limits
+ *
+ * Key Points:
+ * - Requests over max_in_flight queue until a slot is released
+ * - Each route prefix of a host gets its own limiter entry
+ * - Hosts without a rule or default limit create no entry at all
+ * - Idle entries are dropped
+ * - The adaptive limit grows while latency is flat and backs off on overload
+ */
+
+using namespace std::chrono_literals;
+
+int test_concurrency_cap() {
+    std::cout << "Test: Concurrency cap queues excess requests\n";
+    
+    asio::io_context io_context;
+    coro_http::HostLimiterRegistry registry;
+    registry.set_limit("api.example.com", coro_http::HostLimit{0, 1000ms, 2});
+    
+    int in_flight = 0;
+    int max_seen = 0;
+    int completed = 0;
+    
+    for (int i = 0; i < 5; ++i) {
+        asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+            auto permit = co_await registry.co_acquire("api.example.com", "/v1/items");
+            max_seen = std::max(max_seen, ++in_flight);
+            
+            asio::steady_timer timer(io_context);
+            timer.expires_after(30ms);
+            co_await timer.async_wait(asio::use_awaitable);
+            
+            --in_flight;
+            ++completed;
+        }, asio::detached);
+    }
+    
+    io_context.run();
+    
+    assert(completed == 5);
+    assert(max_seen == 2);
+    
+    std::cout << "✓ Concurrency cap test passed\n";
+    return 0;
+}
+
+int test_route_limits() {
+    std::cout << "Test: Route prefixes get separate entries\n";
+    
+    asio::io_context io_context;
+    coro_http::HostLimiterRegistry registry;
+    registry.set_limit("api.example.com", coro_http::HostLimit{0, 1000ms, 1});
+    registry.set_route_limit("api.example.com", "/search", coro_http::HostLimit{0, 1000ms, 1});
+    
+    bool done = false;
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        // Both permits are granted at once because they belong to different entries
+        auto search = co_await registry.co_acquire("api.example.com", "/search?q=x");
+        auto items = co_await registry.co_acquire("api.example.com", "/items");
+        assert(registry.size() == 2);
+        
+        // Unconfigured hosts are not limited and not tracked
+        auto other = co_await registry.co_acquire("other.example.com", "/");
+        assert(registry.size() == 2);
+        done = true;
+    }, asio::detached);
+    
+    io_context.run();
+    assert(done);
+    
+    std::cout << "✓ Route limits test passed\n";
+    return 0;
+}
+
+int test_idle_expiry() {
+    std::cout << "Test: Idle entries expire\n";
+    
+    asio::io_context io_context;
+    coro_http::HostLimiterRegistry registry(0s);
+    registry.set_default_limit(coro_http::HostLimit{100, 1000ms, 4});
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        for (int i = 0; i < 10; ++i) {
+            auto permit = co_await registry.co_acquire("host" + std::to_string(i) + ".example.com", "/");
+        }
+    }, asio::detached);
+    
+    io_context.run();
+    
+    std::this_thread::sleep_for(5ms);
+    registry.expire_idle();
+    assert(registry.size() == 0);
+    
+    std::cout << "✓ Idle expiry test passed\n";
+    return 0;
+}
+
+int test_adaptive_limit() {
+    std::cout << "Test: Adaptive limit follows latency and overload\n";
+    
+    coro_http::AdaptiveLimit options;
+    options.initial_limit = 10;
+    options.max_limit = 100;
+    coro_http::AdaptiveLimiter limiter(options);
+    
+    // Saturated with flat latency: the limit grows
+    for (int i = 0; i < 200; ++i) {
+        limiter.on_sample(10ms, limiter.limit(), false);
+    }
+    int grown = limiter.limit();
+    assert(grown > 10);
+    assert(limiter.rtt() == 10ms);
+    
+    // Latency several times the baseline: the limit shrinks
+    for (int i = 0; i < 50; ++i) {
+        limiter.on_sample(80ms, limiter.limit(), false);
+    }
+    int shrunk = limiter.limit();
+    assert(shrunk < grown);
+    
+    // 5xx / timeouts back off multiplicatively
+    for (int i = 0; i < 5; ++i) {
+        limiter.on_sample(10ms, limiter.limit(), true);
+    }
+    assert(limiter.limit() < shrunk);
+    
+    // Registry exposes the limit per host
+    asio::io_context io_context;
+    coro_http::HostLimiterRegistry registry;
+    registry.set_adaptive_limit(options);
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        auto permit = co_await registry.co_acquire("api.example.com", "/");
+        permit.record_outcome(true);
+    }, asio::detached);
+    io_context.run();
+    
+    auto stats = registry.get_stats("api.example.com");
+    assert(stats);
+    assert(stats->in_flight == 0);
+    assert(stats->limit == 9);
+    assert(!registry.get_stats("other.example.com"));
+    
+    // The RTT sample ends at record_outcome(), not when a held slot is released
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        auto permit = co_await registry.co_acquire("stream.example.com", "/");
+        permit.record_outcome(false);
+        asio::steady_timer timer(io_context);
+        timer.expires_after(100ms);
+        co_await timer.async_wait(asio::use_awaitable);
+    }, asio::detached);
+    io_context.restart();
+    io_context.run();
+    
+    auto streamed = registry.get_stats("stream.example.com");
+    assert(streamed && streamed->in_flight == 0);
+    assert(streamed->rtt < 50ms);
+    
+    std::cout << "✓ Adaptive limit test passed\n";
+    return 0;
+}
+
+int main() {
+    std::cout << "=== Host Limiter Tests ===\n\n";
+    
+    try {
+        test_concurrency_cap();
+        test_route_limits();
+        test_idle_expiry();
+        test_adaptive_limit();
+        
+        std::cout << "\n=== All host limiter tests passed ===\n";
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << "\n";
+        return 1;
+    }
+}
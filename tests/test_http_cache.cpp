@@ -0,0 +1,462 @@
+#include "coro_http/coro_http_client.hpp"
+#include "test_server.hpp"
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Test the in-memory HTTP response cache
+ *
+ * Key Points:
+ * - Freshness follows Cache-Control max-age, Expires and Age
+ * - no-store responses are not stored; Vary selects the matching variant only
+ * - A full shard only admits entries more popular than those they would evict
+ * - The disk tier survives a reopen, serves large bodies mapped from its
+ *   segments, discards a torn trailing record and evicts whole segments
+ * - The client serves fresh hits without I/O and revalidates stale entries with
+ *   If-None-Match, reusing the stored body on 304
+ * - Identical concurrent requests are coalesced into one exchange whose body
+ *   buffer all callers share
+ */
+
+using namespace std::chrono_literals;
+static coro_http::HttpResponse make_response(const std::string& cache_control, const std::string& body = "body") {
+    coro_http::HttpResponse response;
+    response.set_status_code(200);
+    response.set_reason("OK");
+    if (!cache_control.empty()) {
+        response.add_header("Cache-Control", cache_control);
+    }
+    response.set_body(body);
+    return response;
+}
+
+int test_freshness() {
+    std::cout << "Test: Freshness lifetime and age\n";
+
+    coro_http::HttpCache cache(1024 * 1024, 4);
+    coro_http::HttpRequest request(coro_http::HttpMethod::GET, "http://example.com/config");
+    auto now = std::chrono::steady_clock::now();
+
+    auto entry = cache.store(request, make_response("max-age=60, stale-while-revalidate=30"), now, now);
+    assert(entry);
+    assert(entry->fresh(now + 59s));
+    assert(!entry->fresh(now + 61s));
+    assert(entry->serve_while_revalidating(now + 80s));
+    assert(!entry->serve_while_revalidating(now + 91s));
+    assert(cache.lookup(request) == entry);
+
+    // Age already spent upstream counts against the lifetime
+    auto aged = make_response("max-age=60");
+    aged.add_header("Age", "50");
+    entry = cache.store(request, aged, now, now);
+    assert(entry->fresh(now + 9s));
+    assert(!entry->fresh(now + 11s));
+
+    // must-revalidate turns off stale-while-revalidate; no-cache always revalidates
+    entry = cache.store(request, make_response("max-age=60, must-revalidate, stale-while-revalidate=30"), now, now);
+    assert(!entry->serve_while_revalidating(now + 70s));
+    auto no_cache = make_response("no-cache");
+    no_cache.add_header("ETag", "\"v1\"");
+    entry = cache.store(request, no_cache, now, now);
+    assert(entry && !entry->fresh(now));
+
+    // Not storable at all
+    entry = cache.store(request, make_response("no-store, max-age=60"), now, now);
+    assert(!entry);
+    assert(!cache.lookup(request) || cache.lookup(request)->no_cache);
+    coro_http::HttpRequest post(coro_http::HttpMethod::POST, "http://example.com/config");
+    assert(!coro_http::HttpCache::is_cacheable_request(post));
+
+    std::cout << "✓ Freshness test passed\n";
+    return 0;
+}
+
+int test_vary() {
+    std::cout << "Test: Vary selects the stored variant\n";
+
+    coro_http::HttpCache cache(1024 * 1024, 4);
+    auto now = std::chrono::steady_clock::now();
+
+    coro_http::HttpRequest english(coro_http::HttpMethod::GET, "http://example.com/page");
+    english.add_header("Accept-Language", "en");
+    coro_http::HttpRequest german(coro_http::HttpMethod::GET, "http://example.com/page");
+    german.add_header("accept-language", "de");
+
+    auto response = make_response("max-age=60", "hello");
+    response.add_header("Vary", "Accept-Language");
+    auto stored = cache.store(english, response, now, now);
+    assert(stored);
+    assert(cache.lookup(english));
+    assert(!cache.lookup(german));
+
+    response.add_header("Vary", "*");
+    stored = cache.store(german, response, now, now);
+    assert(!stored);
+
+    std::cout << "✓ Vary test passed\n";
+    return 0;
+}
+
+int test_admission() {
+    std::cout << "Test: Byte budget and TinyLFU admission\n";
+
+    // One shard with room for three entries
+    coro_http::HttpCache cache(3 * 1100, 1);
+    auto now = std::chrono::steady_clock::now();
+    std::string body(1000, 'x');
+    auto url = [](int i) { return "http://example.com/" + std::to_string(i); };
+
+    for (int i = 0; i < 3; ++i) {
+        coro_http::HttpRequest request(coro_http::HttpMethod::GET, url(i));
+        for (int hit = 0; hit < 3; ++hit) {
+            cache.lookup(request);
+        }
+        auto stored = cache.store(request, make_response("max-age=60", body), now, now);
+        assert(stored);
+    }
+    assert(cache.stats().entries == 3);
+
+    // A one-off URL does not push out the popular ones
+    coro_http::HttpRequest once(coro_http::HttpMethod::GET, url(100));
+    cache.lookup(once);
+    cache.store(once, make_response("max-age=60", body), now, now);
+    assert(!cache.lookup(once));
+    assert(cache.lookup(coro_http::HttpRequest(coro_http::HttpMethod::GET, url(0))));
+
+    // A URL requested more often than the least recently used entry replaces it
+    coro_http::HttpRequest popular(coro_http::HttpMethod::GET, url(200));
+    for (int hit = 0; hit < 10; ++hit) {
+        cache.lookup(popular);
+    }
+    auto stored = cache.store(popular, make_response("max-age=60", body), now, now);
+    assert(stored);
+    assert(cache.lookup(popular));
+    assert(!cache.lookup(coro_http::HttpRequest(coro_http::HttpMethod::GET, url(1))));
+    assert(cache.stats().entries == 3);
+    assert(cache.stats().bytes <= 3 * 1100);
+
+    std::cout << "✓ Admission test passed\n";
+    return 0;
+}
+
+int test_disk_cache() {
+    std::cout << "Test: Disk cache tier\n";
+
+#if defined(_WIN32)
+    // DiskCache needs mmap and pwrite; the constructor throws operation_not_supported
+    std::cout << "- Disk cache test skipped on Windows\n";
+    return 0;
+#else
+    auto directory = std::filesystem::temp_directory_path() / "coro_http_disk_cache_test";
+    std::filesystem::remove_all(directory);
+    auto now = std::chrono::steady_clock::now();
+    std::string large(200 * 1024, 'L');
+    coro_http::HttpRequest big(coro_http::HttpMethod::GET, "http://example.com/reference.bin");
+    coro_http::HttpRequest small(coro_http::HttpMethod::GET, "http://example.com/small");
+    coro_http::HttpRequest gone(coro_http::HttpMethod::GET, "http://example.com/gone");
+
+    {
+        coro_http::HttpCache cache(1024 * 1024, 4,
+                                   std::make_unique<coro_http::DiskCache>(directory.string(), 64 * 1024 * 1024, 1024 * 1024));
+        auto stored = cache.store(big, make_response("max-age=3600", large), now, now);
+        assert(stored);
+        stored = cache.store(small, make_response("max-age=3600", "tiny"), now, now);
+        assert(stored);
+        stored = cache.store(gone, make_response("max-age=3600", "bye"), now, now);
+        assert(stored);
+        cache.erase(gone.url());
+        assert(cache.stats().disk_entries == 2);
+    }
+
+    // A crash in the middle of a write leaves a torn record at the end
+    std::filesystem::path segment;
+    for (const auto& file : std::filesystem::directory_iterator(directory)) {
+        segment = file.path();
+    }
+    auto intact_size = std::filesystem::file_size(segment);
+    {
+        std::ofstream out(segment, std::ios::binary | std::ios::app);
+        out << "CHC1 torn record";
+    }
+
+    {
+        coro_http::HttpCache cache(1024 * 1024, 4,
+                                   std::make_unique<coro_http::DiskCache>(directory.string(), 64 * 1024 * 1024, 1024 * 1024));
+        assert(std::filesystem::file_size(segment) == intact_size);
+        assert(cache.stats().disk_entries == 2);
+
+        auto entry = cache.lookup(big);
+        assert(entry && entry->fresh(std::chrono::steady_clock::now()));
+        assert(entry->response.body_file());
+        assert(entry->response.body().empty());
+        assert(entry->response.body_view() == large);
+        assert(entry->response.get_header("Cache-Control") == "max-age=3600");
+
+        entry = cache.lookup(small);
+        assert(entry && entry->response.body() == "tiny");
+        assert(!cache.lookup(gone));
+
+        // Entries promoted from disk are charged against the memory budget
+        assert(cache.stats().entries == 2);
+        assert(cache.stats().bytes >= small.url().size() + big.url().size() + 4);
+    }
+
+    // Mapped bodies share their segment's descriptor instead of holding one each
+    std::filesystem::remove_all(directory);
+    {
+        std::string body(100 * 1024, 'm');
+        {
+            coro_http::HttpCache cache(64 * 1024 * 1024, 1,
+                                       std::make_unique<coro_http::DiskCache>(directory.string(), 64 * 1024 * 1024, 16 * 1024 * 1024));
+            for (int i = 0; i < 32; ++i) {
+                coro_http::HttpRequest request(coro_http::HttpMethod::GET, "http://example.com/m" + std::to_string(i));
+                auto stored = cache.store(request, make_response("max-age=3600", body), now, now);
+                assert(stored);
+            }
+        }
+        coro_http::HttpCache cache(64 * 1024 * 1024, 1,
+                                   std::make_unique<coro_http::DiskCache>(directory.string(), 64 * 1024 * 1024, 16 * 1024 * 1024));
+        auto open_descriptors = [] {
+            return std::distance(std::filesystem::directory_iterator("/proc/self/fd"),
+                                 std::filesystem::directory_iterator());
+        };
+        auto before = open_descriptors();
+        std::vector<std::shared_ptr<const coro_http::CachedResponse>> held;
+        for (int i = 0; i < 32; ++i) {
+            held.push_back(cache.lookup(coro_http::HttpRequest(coro_http::HttpMethod::GET,
+                                                               "http://example.com/m" + std::to_string(i))));
+            assert(held.back() && held.back()->response.body_view() == body);
+        }
+        assert(open_descriptors() == before);
+        assert(cache.stats().bytes >= 32 * 4096);
+    }
+
+    // Whole segments are dropped, oldest first, to stay within the budget
+    std::filesystem::remove_all(directory);
+    {
+        coro_http::HttpCache cache(64 * 1024, 1,
+                                   std::make_unique<coro_http::DiskCache>(directory.string(), 400 * 1024, 100 * 1024));
+        std::string body(60 * 1024, 'x');
+        for (int i = 0; i < 10; ++i) {
+            coro_http::HttpRequest request(coro_http::HttpMethod::GET, "http://example.com/" + std::to_string(i));
+            cache.store(request, make_response("max-age=3600", body), now, now);
+        }
+        auto stats = cache.stats();
+        assert(stats.disk_bytes <= 400 * 1024);
+        assert(stats.disk_entries < 10);
+        cache.clear();
+        assert(!cache.lookup(coro_http::HttpRequest(coro_http::HttpMethod::GET, "http://example.com/9")));
+    }
+    std::filesystem::remove_all(directory);
+
+    std::cout << "✓ Disk cache test passed\n";
+    return 0;
+#endif
+}
+
+// Answers every request with a cacheable response carrying an ETag, and with
+// 304 Not Modified when the request's If-None-Match matches it
+struct CacheableResource {
+    std::string cache_control;
+    int not_modified{0};
+
+    TestServer::Handler handler() {
+        return [this](TestConnection& connection, const std::string& head) -> asio::awaitable<void> {
+            std::string response;
+            if (head.find("If-None-Match: \"v1\"") != std::string::npos) {
+                ++not_modified;
+                response = "HTTP/1.1 304 Not Modified\r\nETag: \"v1\"\r\nCache-Control: " + cache_control +
+                           "\r\nX-Revalidated: yes\r\n\r\n";
+            } else {
+                std::string body = "{\"feature\": true}";
+                response = "HTTP/1.1 200 OK\r\nETag: \"v1\"\r\nCache-Control: " + cache_control +
+                           "\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+            }
+            co_await connection.co_write(response);
+        };
+    }
+};
+
+int test_client_cache() {
+    std::cout << "Test: Client serves fresh hits and revalidates stale entries\n";
+
+    coro_http::ClientConfig config;
+    config.enable_cache = true;
+
+    // Fresh for a minute: one request to the server, then hits. With hedging on,
+    // only the request that went to the server is a latency sample.
+    {
+        coro_http::ClientConfig hedged = config;
+        hedged.enable_hedging = true;
+        asio::io_context io_context;
+        CacheableResource resource{"max-age=60"};
+        TestServer server(io_context, resource.handler());
+        coro_http::CoroHttpClient client(io_context, hedged);
+        bool same = true;
+        asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+            auto first = co_await client.co_get(server.url("/config.json"));
+            for (int i = 0; i < 10; ++i) {
+                auto again = co_await client.co_get(server.url("/config.json"));
+                same = same && again.status_code() == 200 && again.body() == first.body();
+            }
+            server.stop();
+        }, asio::detached);
+        io_context.run();
+
+        assert(same);
+        assert(server.requests() == 1);
+        auto stats = client.get_cache_stats();
+        assert(stats.hits == 10 && stats.misses == 1 && stats.entries == 1);
+
+        std::string host_key = server.host_port();
+        auto fastest = client.get_host_latency(host_key, 0.0);
+        auto slowest = client.get_host_latency(host_key, 1.0);
+        assert(fastest && slowest && *fastest == *slowest);
+    }
+
+    // Always stale: each use revalidates, and the 304 reuses the stored body
+    {
+        asio::io_context io_context;
+        CacheableResource resource{"max-age=0"};
+        TestServer server(io_context, resource.handler());
+        coro_http::CoroHttpClient client(io_context, config);
+        std::string body;
+        std::string revalidated;
+        asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+            co_await client.co_get(server.url("/config.json"));
+            auto again = co_await client.co_get(server.url("/config.json"));
+            body = again.body();
+            revalidated = again.get_header("X-Revalidated");
+            server.stop();
+        }, asio::detached);
+        io_context.run();
+
+        assert(server.requests() == 2 && resource.not_modified == 1);
+        assert(body == "{\"feature\": true}");
+        assert(revalidated == "yes");
+        assert(client.get_cache_stats().revalidated == 1);
+    }
+
+    // Stale-while-revalidate: the stale entry is served at once and refreshed behind it
+    {
+        asio::io_context io_context;
+        CacheableResource resource{"max-age=0, stale-while-revalidate=60"};
+        TestServer server(io_context, resource.handler());
+        coro_http::CoroHttpClient client(io_context, config);
+        std::string body;
+        asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+            co_await client.co_get(server.url("/config.json"));
+            auto stale = co_await client.co_get(server.url("/config.json"));
+            body = stale.body();
+
+            asio::steady_timer timer(io_context);
+            timer.expires_after(200ms);
+            co_await timer.async_wait(asio::use_awaitable);
+            server.stop();
+        }, asio::detached);
+        io_context.run();
+
+        assert(body == "{\"feature\": true}");
+        assert(client.get_cache_stats().stale_hits == 1);
+        assert(resource.not_modified == 1);
+    }
+
+    std::cout << "✓ Client cache test passed\n";
+    return 0;
+}
+
+int test_coalescing() {
+    std::cout << "Test: Identical in-flight requests share one exchange\n";
+
+    coro_http::ClientConfig config;
+    config.coalesce_requests = true;
+
+    asio::io_context io_context;
+    CacheableResource resource{"no-cache"};
+    TestServer server(io_context, resource.handler());
+    coro_http::CoroHttpClient client(io_context, config);
+
+    constexpr int callers = 50;
+    std::vector<coro_http::HttpResponse> responses;
+    int finished = 0;
+    for (int i = 0; i < callers; ++i) {
+        asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+            responses.push_back(co_await client.co_get(server.url("/config.json")));
+            if (++finished == callers) {
+                // Once the first exchange is over, the next request goes out again
+                co_await client.co_get(server.url("/config.json"));
+                server.stop();
+            }
+        }, asio::detached);
+    }
+    io_context.run();
+
+    assert(static_cast<int>(responses.size()) == callers);
+    assert(server.requests() == 2);
+    assert(client.get_coalesced_count() == callers - 1);
+    for (const auto& response : responses) {
+        assert(response.status_code() == 200);
+        assert(response.shared_body() == responses.front().shared_body());
+    }
+
+    // The first caller's short timeout ends its own wait, not the shared exchange
+    {
+        asio::io_context io_context;
+        TestServer server(io_context, [&](TestConnection& connection, const std::string&) -> asio::awaitable<void> {
+            asio::steady_timer timer(io_context);
+            timer.expires_after(200ms);
+            co_await timer.async_wait(asio::use_awaitable);
+            co_await connection.co_write("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+        });
+        coro_http::CoroHttpClient client(io_context, config);
+        bool leader_timed_out = false;
+        std::string follower_body;
+        asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+            coro_http::HttpRequest request(coro_http::HttpMethod::GET, server.url("/slow"));
+            request.set_timeout(50ms);
+            try {
+                co_await client.co_execute(request);
+            } catch (const std::system_error& e) {
+                leader_timed_out = e.code() == asio::error::timed_out;
+            }
+        }, asio::detached);
+        asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+            auto response = co_await client.co_get(server.url("/slow"));
+            follower_body = response.body();
+            server.stop();
+        }, asio::detached);
+        io_context.run();
+
+        assert(leader_timed_out);
+        assert(follower_body == "ok");
+        assert(server.requests() == 1);
+    }
+
+    std::cout << "✓ Coalescing test passed\n";
+    return 0;
+}
+
+int main() {
+    std::cout << "=== HTTP Cache Tests ===\n\n";
+
+    try {
+        test_freshness();
+        test_vary();
+        test_admission();
+        test_disk_cache();
+        test_client_cache();
+        test_coalescing();
+
+        std::cout << "\n=== All HTTP cache tests passed ===\n";
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << "\n";
+        return 1;
+    }
+}
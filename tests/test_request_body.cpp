@@ -0,0 +1,380 @@
+#include "coro_http/coro_http_client.hpp"
+#include "coro_http/form_data.hpp"
+#include "test_server.hpp"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+/**
+ * Test streaming request bodies
+ *
+ * Key Points:
+ * - A body source of unknown size is sent with Transfer-Encoding: chunked
+ * - A known size is announced with Content-Length and checked while sending
+ * - Pieces are produced while the request is being written
+ * - A source that cannot be rewound is never sent twice
+ * - File bodies are sent from the file itself, a window or a sendfile() at a time
+ * - Multipart forms are encoded lazily with an exact Content-Length
+ * - Bodies can be compressed on the way out, with pooled zlib state
+ */
+
+int test_request_framing() {
+    std::cout << "Test: Request framing for body sources\n";
+    
+    auto url_info = coro_http::parse_url("http://example.com/upload");
+    
+    coro_http::HttpRequest chunked(coro_http::HttpMethod::POST, "http://example.com/upload");
+    int calls = 0;
+    chunked.set_body_source(std::make_shared<coro_http::CallbackBodySource>([&calls]() {
+        return ++calls <= 2 ? std::string("piece") : std::string();
+    }));
+    std::string head = coro_http::build_request(chunked, url_info);
+    assert(head.find("Transfer-Encoding: chunked\r\n") != std::string::npos);
+    assert(head.find("Content-Length") == std::string::npos);
+    assert(head.substr(head.size() - 4) == "\r\n\r\n");
+    assert(calls == 0);
+    
+    coro_http::HttpRequest sized(coro_http::HttpMethod::PUT, "http://example.com/upload");
+    sized.set_body("ignored");
+    sized.set_body_source(std::make_shared<coro_http::MemoryBodySource>("0123456789"));
+    head = coro_http::build_request(sized, url_info);
+    assert(head.find("Content-Length: 10\r\n") != std::string::npos);
+    assert(head.find("Transfer-Encoding") == std::string::npos);
+    assert(head.find("ignored") == std::string::npos);
+    
+    // Memory sources can be replayed, generators cannot
+    asio::io_context io_context;
+    std::string first;
+    std::string second;
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        auto& source = *sized.body_source();
+        while (true) {
+            auto piece = co_await source.co_next();
+            if (piece.empty()) break;
+            first += piece;
+        }
+        bool rewound = source.rewind();
+        assert(rewound);
+        second = std::string(co_await source.co_next());
+    }, asio::detached);
+    io_context.run();
+    
+    assert(first == "0123456789");
+    assert(second == first);
+    bool rewound = chunked.body_source()->rewind();
+    assert(!rewound);
+    
+    std::cout << "✓ Request framing test passed\n";
+    return 0;
+}
+
+// Reads a request body in either framing and answers with what it received
+struct UploadReceiver {
+    size_t wire_bytes{0};  // Size of the last request body as it arrived
+    
+    TestServer::Handler handler() {
+        return [this](TestConnection& connection, const std::string& request_head) -> asio::awaitable<void> {
+            size_t line_end = request_head.find("\r\n") + 2;
+            auto head = coro_http::parse_response_head("HTTP/1.1 200 OK\r\n" + request_head.substr(line_end) +
+                                                       "\r\n\r\n");
+            std::string body;
+            bool chunked = !head.get_header("Transfer-Encoding").empty();
+            
+            if (chunked) {
+                coro_http::ChunkedDecoder decoder;
+                while (!decoder.done()) {
+                    std::string data = co_await connection.co_read_some();
+                    if (data.empty()) co_return;
+                    decoder.feed(data.data(), data.size(), body);
+                }
+            } else {
+                size_t length = std::stoull(head.get_header("Content-Length"));
+                while (body.size() < length) {
+                    std::string data = co_await connection.co_read_some();
+                    if (data.empty()) co_return;
+                    body += data;
+                }
+            }
+            
+            // Compressed bodies are reported decoded, with the coding in front
+            std::string coding = head.get_header("Content-Encoding");
+            wire_bytes = body.size();
+            if (coding == "gzip") {
+                body = coro_http::decompress_gzip(body);
+            } else if (coding == "deflate") {
+                body = coro_http::decompress_deflate(body);
+            }
+            
+            std::string reply = (coding.empty() ? "" : coding + "/") + (chunked ? "chunked:" : "length:") +
+                                std::to_string(body.size()) + ":" + body.substr(0, 16);
+            co_await connection.co_write("HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(reply.size()) +
+                                         "\r\nConnection: close\r\n\r\n" + reply);
+        };
+    }
+};
+
+int test_streamed_upload() {
+    std::cout << "Test: Streamed upload in both framings\n";
+    
+    asio::io_context io_context;
+    UploadReceiver upload;
+    TestServer server(io_context, upload.handler());
+    coro_http::CoroHttpClient client(io_context);
+    
+    std::string chunked_reply;
+    std::string sized_reply;
+    bool short_body_failed = false;
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        // 64 pieces of 64 KiB produced on demand, 4 MiB without ever holding it all
+        int produced = 0;
+        coro_http::HttpRequest chunked(coro_http::HttpMethod::POST, server.url("/chunked"));
+        chunked.set_body_source(std::make_shared<coro_http::ProducerBodySource>(
+            [&produced]() -> asio::awaitable<std::string> {
+                if (produced == 64) co_return std::string();
+                co_return std::string(65536, static_cast<char>('a' + produced++ % 26));
+            }));
+        chunked_reply = (co_await client.co_execute(chunked)).body();
+        
+        int pieces = 0;
+        coro_http::HttpRequest sized(coro_http::HttpMethod::PUT, server.url("/sized"));
+        sized.set_body_source(std::make_shared<coro_http::CallbackBodySource>(
+            [&pieces]() { return pieces++ < 3 ? std::string("abcd") : std::string(); }, 12));
+        sized_reply = (co_await client.co_execute(sized)).body();
+        
+        // Declared size not matched by the source
+        pieces = 0;
+        coro_http::HttpRequest short_body(coro_http::HttpMethod::PUT, server.url("/short"));
+        short_body.set_body_source(std::make_shared<coro_http::CallbackBodySource>(
+            [&pieces]() { return pieces++ < 1 ? std::string("abcd") : std::string(); }, 12));
+        try {
+            co_await client.co_execute(short_body);
+        } catch (const std::runtime_error&) {
+            short_body_failed = true;
+        }
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+    
+    assert(chunked_reply == "chunked:4194304:" + std::string(16, 'a'));
+    assert(sized_reply == "length:12:abcdabcdabcd");
+    assert(short_body_failed);
+    
+    std::cout << "✓ Streamed upload test passed\n";
+    return 0;
+}
+
+static std::string write_temp_file(const std::string& name, size_t size) {
+    std::string path = name + ".tmp";
+    std::string data(size, '\0');
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<char>('a' + (i * 7 + i / 4096) % 26);
+    }
+    std::ofstream(path, std::ios::binary).write(data.data(), static_cast<std::streamsize>(data.size()));
+    return path;
+}
+
+int test_file_upload() {
+    std::cout << "Test: File upload\n";
+    
+    // Odd size so the last window is partial
+    const size_t file_size = 3 * 1024 * 1024 + 123;
+    std::string path = write_temp_file("test_request_body_upload", file_size);
+    std::string expected;
+    {
+        std::ifstream in(path, std::ios::binary);
+        expected.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    
+    asio::io_context io_context;
+    UploadReceiver upload;
+    TestServer server(io_context, upload.handler());
+    coro_http::CoroHttpClient client(io_context);
+    
+    std::string read_back;
+    size_t windows = 0;
+    std::string reply;
+    std::string replay;
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        // Mapped window by window; a 1 byte window is rounded up to a page
+        coro_http::FileBodySource windowed(path, 1);
+        assert(windowed.size() == file_size);
+        while (true) {
+            auto piece = co_await windowed.co_next();
+            if (piece.empty()) break;
+            read_back += piece;
+            ++windows;
+        }
+        assert(windowed.remaining() == 0);
+        
+        auto source = std::make_shared<coro_http::FileBodySource>(path);
+        coro_http::HttpRequest request(coro_http::HttpMethod::PUT, server.url("/file"));
+        request.set_body_source(source);
+        reply = (co_await client.co_execute(request)).body();
+        
+        // The same source can be sent again after a rewind
+        bool rewound = source->rewind();
+        assert(rewound);
+        replay = (co_await client.co_execute(request)).body();
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+    std::remove(path.c_str());
+    
+    assert(read_back == expected);
+    assert(windows > 1);
+    assert(reply == "length:" + std::to_string(file_size) + ":" + expected.substr(0, 16));
+    assert(replay == reply);
+    
+    std::cout << "✓ File upload test passed\n";
+    return 0;
+}
+
+int test_multipart_form() {
+    std::cout << "Test: Multipart form data\n";
+    
+    std::string path = write_temp_file("test_request_body_form", 200000);
+    std::string file_data;
+    {
+        std::ifstream in(path, std::ios::binary);
+        file_data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    std::string thumbnail = "\x89PNG...";
+    
+    coro_http::MultipartFormData form;
+    form.add("title", "Holiday \"2024\"")
+        .add_buffer("thumb", thumbnail, "thumb.png", "image/png")
+        .add_file("photo", path);
+    
+    const std::string& b = form.boundary();
+    std::string expected =
+        "--" + b + "\r\nContent-Disposition: form-data; name=\"title\"\r\n\r\nHoliday \"2024\"\r\n" +
+        "--" + b + "\r\nContent-Disposition: form-data; name=\"thumb\"; filename=\"thumb.png\"\r\n" +
+        "Content-Type: image/png\r\n\r\n" + thumbnail + "\r\n" +
+        "--" + b + "\r\nContent-Disposition: form-data; name=\"photo\"; filename=\"" + path + "\"\r\n" +
+        "Content-Type: application/octet-stream\r\n\r\n" + file_data + "\r\n" +
+        "--" + b + "--\r\n";
+    assert(form.content_type() == "multipart/form-data; boundary=" + b);
+    assert(form.content_length() == expected.size());
+    
+    asio::io_context io_context;
+    UploadReceiver upload;
+    TestServer server(io_context, upload.handler());
+    coro_http::CoroHttpClient client(io_context);
+    std::string encoded;
+    std::string reply;
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        auto source = form.body_source();
+        while (true) {
+            auto piece = co_await source->co_next();
+            if (piece.empty()) break;
+            encoded += piece;
+            // Asking for the length mid-send must not rewind the parts being sent
+            uint64_t length = form.content_length();
+            assert(length == expected.size());
+        }
+        
+        coro_http::HttpRequest request(coro_http::HttpMethod::POST, server.url("/form"));
+        form.apply_to(request);
+        reply = (co_await client.co_execute(request)).body();
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+    std::remove(path.c_str());
+    
+    assert(encoded == expected);
+    assert(reply == "length:" + std::to_string(expected.size()) + ":" + expected.substr(0, 16));
+    
+    std::cout << "✓ Multipart form test passed\n";
+    return 0;
+}
+
+int test_request_compression() {
+    std::cout << "Test: Request body compression\n";
+    
+    std::string batch;
+    for (int i = 0; i < 5000; ++i) {
+        batch += "{\"id\":" + std::to_string(i) + ",\"event\":\"page_view\",\"path\":\"/home\"}\n";
+    }
+    
+    // Deflaters go back to the pool and are reset for the next body
+    coro_http::DeflaterPool pool;
+    {
+        auto deflater = pool.acquire(coro_http::Deflater::Format::gzip, 6);
+        assert(coro_http::decompress_gzip(coro_http::compress(batch, *deflater)) == batch);
+    }
+    assert(pool.idle() == 1);
+    {
+        auto deflater = pool.acquire(coro_http::Deflater::Format::gzip, 6);
+        assert(pool.idle() == 0);
+        assert(coro_http::decompress_gzip(coro_http::compress("again", *deflater)) == "again");
+    }
+    assert(pool.idle() == 1);
+    
+    coro_http::ClientConfig config;
+    config.compress_request_hosts = {"127.0.0.1"};
+    config.request_compression_min_size = 100;
+    
+    asio::io_context io_context;
+    UploadReceiver upload;
+    TestServer server(io_context, upload.handler());
+    coro_http::CoroHttpClient client(io_context, config);
+    
+    std::string memory_reply;
+    size_t memory_wire = 0;
+    std::string stream_reply;
+    std::string small_reply;
+    std::string opted_out_reply;
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        memory_reply = (co_await client.co_post(server.url("/ingest"), batch)).body();
+        memory_wire = upload.wire_bytes;
+        
+        // A body source is compressed as it is read and sent chunked
+        int pieces = 0;
+        coro_http::HttpRequest streamed(coro_http::HttpMethod::POST, server.url("/ingest"));
+        streamed.set_body_source(std::make_shared<coro_http::CallbackBodySource>(
+            [&]() { return pieces++ < 4 ? batch : std::string(); }, batch.size() * 4));
+        stream_reply = (co_await client.co_execute(streamed)).body();
+        
+        small_reply = (co_await client.co_post(server.url("/ingest"), "{\"id\":1}")).body();
+        
+        coro_http::HttpRequest opted_out(coro_http::HttpMethod::POST, server.url("/ingest"));
+        opted_out.set_body(batch).set_compress_body(false);
+        opted_out_reply = (co_await client.co_execute(opted_out)).body();
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+    
+    assert(memory_reply == "gzip/length:" + std::to_string(batch.size()) + ":" + batch.substr(0, 16));
+    assert(memory_wire * 5 < batch.size());
+    assert(stream_reply == "gzip/chunked:" + std::to_string(batch.size() * 4) + ":" + batch.substr(0, 16));
+    assert(small_reply == "length:8:{\"id\":1}");
+    assert(opted_out_reply == "length:" + std::to_string(batch.size()) + ":" + batch.substr(0, 16));
+    
+    std::cout << "✓ Request compression test passed\n";
+    return 0;
+}
+
+int main() {
+    std::cout << "=== Request Body Tests ===\n\n";
+    
+    try {
+        test_request_framing();
+        test_streamed_upload();
+        test_file_upload();
+        test_multipart_form();
+        test_request_compression();
+        
+        std::cout << "\n=== All request body tests passed ===\n";
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,557 @@
+#include "coro_http/coro_http_client.hpp"
+#include "test_server.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Test the streaming response API
+ *
+ * Key Points:
+ * - Chunked and gzip bodies are decoded incrementally, whatever the piece size
+ * - Status and headers are available before the body is read
+ * - The connection returns to the pool once the body has been read to its end
+ * - The request's cancellation token and the host's concurrency slot cover the body
+ * - A body cut short by the peer is an error, not a silently short read
+ * - Bodies can be written straight to a file, spliced from the socket when plain
+ * - Oversized responses fail instead of growing without bound; large bodies can
+ *   spill to a temporary file
+ * - Segmented downloads fetch ranges in parallel, retry a broken segment from
+ *   where it stopped and resume from a partial file
+ */
+
+int test_incremental_decoders() {
+    std::cout << "Test: Incremental chunked and gzip decoding\n";
+    
+    coro_http::ChunkedDecoder decoder;
+    std::string wire = "4\r\nWiki\r\n5;name=value\r\npedia\r\n0\r\nX-Trailer: 1\r\n\r\nNEXT";
+    std::string out;
+    size_t consumed = 0;
+    for (size_t i = 0; i < wire.size() && !decoder.done(); ++i) {
+        consumed += decoder.feed(wire.data() + i, 1, out);
+    }
+    assert(decoder.done());
+    assert(out == "Wikipedia");
+    assert(consumed == wire.size() - 4);
+    
+    // Malformed framing and compressed data are protocol errors, like a bad head
+    bool bad_chunk = false;
+    try {
+        coro_http::ChunkedDecoder broken;
+        std::string ignored;
+        broken.feed("zz\r\n", 4, ignored);
+    } catch (const std::system_error& e) {
+        bad_chunk = e.code() == coro_http::error::protocol_error;
+    }
+    assert(bad_chunk);
+    bool bad_gzip = false;
+    try {
+        coro_http::Inflater broken(coro_http::Inflater::Format::gzip);
+        std::string ignored;
+        broken.feed("not gzip data", 13, ignored);
+    } catch (const std::system_error& e) {
+        bad_gzip = e.code() == coro_http::error::protocol_error;
+    }
+    assert(bad_gzip);
+    
+    std::string text;
+    for (int i = 0; i < 2000; ++i) {
+        text += "line " + std::to_string(i) + "\n";
+    }
+    std::string compressed = gzip(text);
+    coro_http::Inflater inflater(coro_http::Inflater::Format::gzip);
+    std::string inflated;
+    for (size_t pos = 0; pos < compressed.size(); pos += 7) {
+        inflater.feed(compressed.data() + pos, std::min<size_t>(7, compressed.size() - pos), inflated);
+    }
+    assert(inflater.done());
+    assert(inflated == text);
+    
+    // A highly compressible body is expanded one bounded step at a time
+    std::string zeros(8 * 1024 * 1024, '\0');
+    std::string bomb = gzip(zeros);
+    coro_http::Inflater bounded(coro_http::Inflater::Format::gzip);
+    std::string expanded;
+    size_t used = 0;
+    do {
+        std::string step;
+        used += bounded.feed(bomb.data() + used, bomb.size() - used, step, coro_http::Inflater::output_step);
+        assert(step.size() <= coro_http::Inflater::output_step);
+        expanded += step;
+    } while (used < bomb.size() || bounded.stalled());
+    assert(bounded.done());
+    assert(expanded == zeros);
+    
+    std::cout << "✓ Incremental decoders test passed\n";
+    return 0;
+}
+
+// Raw response bytes handed out a few at a time, as a slow network would
+static coro_http::HttpResponseStream make_stream(const std::string& raw, size_t piece, int& released,
+                                                 bool& reusable) {
+    size_t header_end = raw.find("\r\n\r\n") + 4;
+    auto body = std::make_shared<std::string>(raw.substr(header_end));
+    auto pos = std::make_shared<size_t>(0);
+    
+    coro_http::HttpResponseStream::ReadSome read_some =
+        [body, pos, piece](asio::mutable_buffer buffer) -> asio::awaitable<size_t> {
+        size_t n = std::min({piece, buffer.size(), body->size() - *pos});
+        std::memcpy(buffer.data(), body->data() + *pos, n);
+        *pos += n;
+        co_return n;
+    };
+    
+    return coro_http::HttpResponseStream(
+        coro_http::parse_response_head(raw.substr(0, header_end)), "", coro_http::HttpMethod::GET,
+        std::move(read_some),
+        coro_http::ConnectionLease([&released, &reusable](bool keep) {
+            ++released;
+            reusable = keep;
+        }));
+}
+
+int test_stream_decoding() {
+    std::cout << "Test: Stream decoding and connection release\n";
+    
+    std::string text(100000, 'x');
+    for (size_t i = 0; i < text.size(); i += 7) {
+        text[i] = static_cast<char>('a' + i % 26);
+    }
+    
+    asio::io_context io_context;
+    int released = 0;
+    bool reusable = false;
+    std::string body;
+    bool threw = false;
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        // gzip inside chunked, arriving 13 bytes at a time, read 1000 bytes at a time
+        auto stream = make_stream("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n"
+                                  "Content-Encoding: gzip\r\n\r\n" + chunked(gzip(text), 333),
+                                  13, released, reusable);
+        assert(stream.status_code() == 200);
+        assert(released == 0);
+        std::vector<char> buffer(1000);
+        while (size_t n = co_await stream.co_read_some(asio::buffer(buffer))) {
+            body.append(buffer.data(), n);
+        }
+        assert(stream.eof());
+        
+        // Content-Length body cut short by the peer
+        int short_released = 0;
+        bool short_reusable = true;
+        auto truncated = make_stream("HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nabc", 100,
+                                     short_released, short_reusable);
+        try {
+            co_await truncated.co_read_all();
+        } catch (const std::system_error& e) {
+            threw = e.code() == coro_http::error::incomplete_body;
+        }
+        assert(short_released == 1 && !short_reusable);
+    }, asio::detached);
+    io_context.run();
+    
+    assert(body == text);
+    assert(released == 1 && reusable);
+    assert(threw);
+    
+    std::cout << "✓ Stream decoding test passed\n";
+    return 0;
+}
+
+static std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+int test_stream_to_file() {
+    std::cout << "Test: Decoded stream written to a file\n";
+    
+    std::string text;
+    for (int i = 0; i < 20000; ++i) {
+        text += "record " + std::to_string(i) + "\n";
+    }
+    std::string path = "test_response_stream_sink.tmp";
+    
+    asio::io_context io_context;
+    int released = 0;
+    bool reusable = false;
+    uint64_t written = 0;
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        auto stream = make_stream("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n"
+                                  "Content-Encoding: gzip\r\n\r\n" + chunked(gzip(text), 1000),
+                                  4096, released, reusable);
+        
+        // Space reserved for more than the body is given back on finish()
+        coro_http::FileSink sink(io_context.get_executor(), path);
+        sink.preallocate(text.size() * 2);
+        written = co_await stream.co_read_to(sink);
+        sink.finish();
+    }, asio::detached);
+    io_context.run();
+    
+    assert(written == text.size());
+    assert(read_file(path) == text);
+    assert(released == 1 && reusable);
+    std::remove(path.c_str());
+    
+    std::cout << "✓ Stream to file test passed\n";
+    return 0;
+}
+
+// Answers every request with the same keep-alive response
+static TestServer::Handler body_handler(std::string body) {
+    return [body = std::move(body)](TestConnection& connection, const std::string&) -> asio::awaitable<void> {
+        co_await connection.co_write("HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) +
+                                     "\r\n\r\n" + body);
+    };
+}
+
+int test_streaming_download() {
+    std::cout << "Test: Streaming download over a pooled connection\n";
+    
+    asio::io_context io_context;
+    std::string payload(4 * 1024 * 1024, 'z');
+    TestServer server(io_context, body_handler(payload));
+    coro_http::CoroHttpClient client(io_context);
+    
+    size_t received = 0;
+    bool pooled_while_reading = false;
+    bool second_ok = false;
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        auto stream = co_await client.co_execute_stream(
+            coro_http::HttpRequest(coro_http::HttpMethod::GET, server.url("/big")));
+        assert(stream.status_code() == 200);
+        pooled_while_reading = client.get_pool_stats().active_http_connections == 1;
+        
+        std::vector<char> buffer(65536);
+        while (size_t n = co_await stream.co_read_some(asio::buffer(buffer))) {
+            received += n;
+        }
+        
+        // Fully read: the connection is idle in the pool and serves the next request
+        assert(client.get_pool_stats().active_http_connections == 0);
+        auto response = co_await client.co_get(server.url("/again"));
+        second_ok = response.body().size() == payload.size();
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+    
+    assert(pooled_while_reading);
+    assert(received == payload.size());
+    assert(second_ok);
+    assert(server.accepted() == 1);
+    
+    std::cout << "✓ Streaming download test passed\n";
+    return 0;
+}
+
+int test_stream_cancellation() {
+    std::cout << "Test: Streamed body bounded by the request's token and host slot\n";
+    
+    asio::io_context io_context;
+    TestServer server(io_context, body_handler(std::string(4 * 1024 * 1024, 'z')));
+    coro_http::CoroHttpClient client(io_context);
+    client.host_limits().set_limit("127.0.0.1", coro_http::HostLimit{0, std::chrono::milliseconds(1000), 4});
+    
+    coro_http::CancellationToken token;
+    bool slot_held = false;
+    bool aborted = false;
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        coro_http::HttpRequest request(coro_http::HttpMethod::GET, server.url("/big"));
+        request.set_cancellation_token(token);
+        auto stream = co_await client.co_execute_stream(request);
+        
+        // The body transfer still counts against the host's concurrency limit
+        std::vector<char> buffer(65536);
+        co_await stream.co_read_some(asio::buffer(buffer));
+        slot_held = client.get_host_limit_stats("127.0.0.1")->in_flight == 1;
+        
+        token.cancel();
+        try {
+            while (co_await stream.co_read_some(asio::buffer(buffer))) {}
+        } catch (const std::system_error& e) {
+            aborted = e.code() == asio::error::operation_aborted;
+        }
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+    
+    assert(slot_held);
+    assert(aborted);
+    assert(client.get_host_limit_stats("127.0.0.1")->in_flight == 0);
+    assert(client.get_pool_stats().total_http_connections == 0);
+    
+    std::cout << "✓ Stream cancellation test passed\n";
+    return 0;
+}
+
+int test_download_to_file() {
+    std::cout << "Test: Download to file over a pooled connection\n";
+    
+    asio::io_context io_context;
+    std::string payload(3 * 1024 * 1024 + 17, '\0');
+    for (size_t i = 0; i < payload.size(); ++i) {
+        payload[i] = static_cast<char>('A' + (i * 31 + i / 1000) % 26);
+    }
+    TestServer server(io_context, body_handler(payload));
+    coro_http::CoroHttpClient client(io_context);
+    std::string path = "test_response_stream_download.tmp";
+    
+    int status = 0;
+    bool second_ok = false;
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        auto response = co_await client.co_download(
+            coro_http::HttpRequest(coro_http::HttpMethod::GET, server.url("/artifact")), path);
+        status = response.status_code();
+        assert(response.body().empty());
+        
+        // The body was consumed exactly, so the connection is reused
+        auto again = co_await client.co_get(server.url("/again"));
+        second_ok = again.body() == payload;
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+    
+    assert(status == 200);
+    assert(read_file(path) == payload);
+    assert(second_ok);
+    assert(server.accepted() == 1);
+    std::remove(path.c_str());
+    
+    std::cout << "✓ Download to file test passed\n";
+    return 0;
+}
+
+int test_response_limits() {
+    std::cout << "Test: Response size limits and spill to disk\n";
+    
+    asio::io_context io_context;
+    std::string payload;
+    for (int i = 0; i < 100000; ++i) {
+        payload += "row " + std::to_string(i) + "\n";
+    }
+    TestServer server(io_context, body_handler(payload));
+    
+    coro_http::ClientConfig config;
+    config.response_spill_threshold = 64 * 1024;
+    coro_http::CoroHttpClient client(io_context, config);
+    
+    bool body_rejected = false;
+    bool headers_rejected = false;
+    bool spilled = false;
+    bool in_memory = false;
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        try {
+            co_await client.co_execute(coro_http::HttpRequest(coro_http::HttpMethod::GET, server.url("/big"))
+                                           .set_max_response_body_size(payload.size() - 1));
+        } catch (const coro_http::HttpError& e) {
+            body_rejected = e.code() == coro_http::error::response_too_large;
+        }
+        
+        try {
+            co_await client.co_execute(coro_http::HttpRequest(coro_http::HttpMethod::GET, server.url("/big"))
+                                           .set_max_response_header_size(16));
+        } catch (const coro_http::HttpError& e) {
+            headers_rejected = e.code() == coro_http::error::response_too_large;
+        }
+        
+        auto response = co_await client.co_get(server.url("/spill"));
+        spilled = response.body().empty() && response.body_file() &&
+                  response.body_file()->size() == payload.size() && response.body_view() == payload;
+        
+        auto kept = co_await client.co_execute(coro_http::HttpRequest(coro_http::HttpMethod::GET, server.url("/keep"))
+                                                   .set_response_spill_threshold(0));
+        in_memory = !kept.body_file() && kept.body() == payload && kept.body_view() == payload;
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+    
+    assert(body_rejected);
+    assert(headers_rejected);
+    assert(spilled);
+    assert(in_memory);
+    
+    std::cout << "✓ Response limits test passed\n";
+    return 0;
+}
+
+// Serves HEAD and single-range GET requests for one object. The first request
+// for the range starting at `break_offset` gets half of its body, then the
+// connection is closed.
+struct RangeObject {
+    std::string body;
+    uint64_t break_offset;
+    bool broken{false};
+    std::vector<uint64_t> range_starts;
+    
+    TestServer::Handler handler() {
+        return [this](TestConnection& connection, const std::string& head) -> asio::awaitable<void> {
+            std::string response;
+            bool cut = false;
+            size_t range = head.find("Range: bytes=");
+            if (head.rfind("HEAD", 0) == 0) {
+                response = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) +
+                           "\r\nAccept-Ranges: bytes\r\nETag: \"v1\"\r\n\r\n";
+            } else if (range != std::string::npos) {
+                unsigned long long first = 0, last = 0;
+                std::sscanf(head.c_str() + range, "Range: bytes=%llu-%llu", &first, &last);
+                range_starts.push_back(first);
+                std::string part = body.substr(first, last - first + 1);
+                response = "HTTP/1.1 206 Partial Content\r\nContent-Length: " + std::to_string(part.size()) +
+                           "\r\nContent-Range: bytes " + std::to_string(first) + "-" + std::to_string(last) +
+                           "/" + std::to_string(body.size()) + "\r\n\r\n";
+                cut = first == break_offset && !broken;
+                broken = broken || cut;
+                response += cut ? part.substr(0, part.size() / 2) : part;
+            } else {
+                response = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+            }
+            
+            co_await connection.co_write(response);
+            if (cut) {
+                connection.close();
+            }
+        };
+    }
+};
+
+int test_segmented_download() {
+    std::cout << "Test: Segmented range download with retry and resume\n";
+    
+    std::string payload;
+    for (int i = 0; payload.size() < 1024 * 1024; ++i) {
+        payload += "block " + std::to_string(i) + "\n";
+    }
+    const uint64_t segment = 64 * 1024;
+    std::string path = "test_segmented_download.tmp";
+    
+    coro_http::ClientConfig config;
+    config.enable_retry = true;
+    config.initial_retry_delay = std::chrono::milliseconds(10);
+    coro_http::SegmentedDownloadOptions options;
+    options.connections = 4;
+    options.segment_size = segment;
+    
+    // Fresh download; the segment at 3 * 64 KiB breaks off once and is resumed
+    {
+        asio::io_context io_context;
+        RangeObject object{payload, 3 * segment};
+        TestServer server(io_context, object.handler());
+        coro_http::CoroHttpClient client(io_context, config);
+        int status = 0;
+        asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+            auto response = co_await client.co_download(
+                coro_http::HttpRequest(coro_http::HttpMethod::GET, server.url("/object.bin")), path, options);
+            status = response.status_code();
+            server.stop();
+        }, asio::detached);
+        io_context.run();
+        
+        assert(status == 200);
+        assert(read_file(path) == payload);
+        assert(!std::ifstream(path + ".part").good());
+        
+        // Every segment once, plus the rest of the broken one
+        const auto& starts = object.range_starts;
+        size_t segments = (payload.size() + segment - 1) / segment;
+        assert(starts.size() == segments + 1);
+        assert(std::count(starts.begin(), starts.end(), 3 * segment) == 1);
+        assert(std::count_if(starts.begin(), starts.end(),
+                             [&](uint64_t start) { return start > 3 * segment && start < 4 * segment; }) == 1);
+        assert(client.get_retry_stats().retries == 1);
+    }
+    
+    // With retries off, the broken segment fails the download
+    {
+        coro_http::ClientConfig no_retry = config;
+        no_retry.enable_retry = false;
+        asio::io_context io_context;
+        RangeObject object{payload, 3 * segment};
+        TestServer server(io_context, object.handler());
+        coro_http::CoroHttpClient client(io_context, no_retry);
+        bool failed = false;
+        asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+            try {
+                co_await client.co_download(
+                    coro_http::HttpRequest(coro_http::HttpMethod::GET, server.url("/object.bin")), path, options);
+            } catch (const std::system_error&) {
+                failed = true;
+            }
+            server.stop();
+        }, asio::detached);
+        io_context.run();
+        
+        assert(failed);
+        assert(client.get_retry_stats().retries == 0);
+        std::remove((path + ".part").c_str());
+    }
+    
+    // Resume: the first half is on disk and recorded as done, so only the rest is fetched
+    {
+        uint64_t half = 8 * segment;
+        auto state = coro_http::DownloadState::split(payload.size(), "\"v1\"", segment);
+        for (auto& part : state.segments) {
+            if (part.end <= half) {
+                part.done = part.size();
+            }
+        }
+        state.save(path + ".part");
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out << payload.substr(0, half) << std::string(payload.size() - half, '\0');
+        }
+        
+        asio::io_context io_context;
+        RangeObject object{payload, payload.size()};
+        TestServer server(io_context, object.handler());
+        coro_http::CoroHttpClient client(io_context, config);
+        asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+            co_await client.co_download(coro_http::HttpRequest(coro_http::HttpMethod::GET, server.url("/object.bin")),
+                                        path, options);
+            server.stop();
+        }, asio::detached);
+        io_context.run();
+        
+        assert(read_file(path) == payload);
+        const auto& starts = object.range_starts;
+        assert(!starts.empty());
+        assert(*std::min_element(starts.begin(), starts.end()) == half);
+    }
+    std::remove(path.c_str());
+    
+    std::cout << "✓ Segmented download test passed\n";
+    return 0;
+}
+
+int main() {
+    std::cout << "=== Response Stream Tests ===\n\n";
+    
+    try {
+        test_incremental_decoders();
+        test_stream_decoding();
+        test_streaming_download();
+        test_stream_cancellation();
+        test_stream_to_file();
+        test_download_to_file();
+        test_response_limits();
+        test_segmented_download();
+        
+        std::cout << "\n=== All response stream tests passed ===\n";
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << "\n";
+        return 1;
+    }
+}
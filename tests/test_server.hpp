@@ -0,0 +1,183 @@
+#pragma once
+
+#include "coro_http/coro_http_client.hpp"
+#include <array>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <zlib.h>
+
+/**
+ * Loopback HTTP server for the client tests
+ *
+ * Accepts connections on 127.0.0.1 and reads request heads off each one. Every
+ * request is passed to the test's handler, which writes the answer and may
+ * read a request body or close the connection. Connections stay open until
+ * the peer or the handler closes them, or until stop().
+ */
+
+// One accepted connection, as the handler sees it
+class TestConnection {
+public:
+    explicit TestConnection(asio::ip::tcp::socket socket) : socket_(std::move(socket)) {}
+    
+    // The next request's head, up to and without the blank line; nullopt once the
+    // peer has gone. Bytes after the head are kept for co_read_some().
+    asio::awaitable<std::optional<std::string>> co_read_head() {
+        while (buffered_.find("\r\n\r\n") == std::string::npos) {
+            std::string more = co_await co_receive();
+            if (more.empty()) {
+                co_return std::nullopt;
+            }
+            buffered_ += more;
+        }
+        size_t end = buffered_.find("\r\n\r\n");
+        std::string head = buffered_.substr(0, end);
+        buffered_.erase(0, end + 4);
+        co_return head;
+    }
+    
+    // Request body bytes: those that arrived with the head, then what the socket
+    // has; empty once the peer has gone
+    asio::awaitable<std::string> co_read_some() {
+        if (!buffered_.empty()) {
+            co_return std::exchange(buffered_, std::string());
+        }
+        co_return co_await co_receive();
+    }
+    
+    // Write `data`; false once the peer has gone
+    asio::awaitable<bool> co_write(const std::string& data) {
+        auto [ec, len] = co_await asio::async_write(socket_, asio::buffer(data), asio::as_tuple(asio::use_awaitable));
+        co_return !ec;
+    }
+    
+    // Shut the connection down; the server stops reading requests from it
+    void close() {
+        asio::error_code ec;
+        socket_.shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+        socket_.close(ec);
+    }
+    
+    bool is_open() const { return socket_.is_open(); }
+    
+    asio::ip::tcp::socket& socket() { return socket_; }
+
+private:
+    asio::awaitable<std::string> co_receive() {
+        std::array<char, 4096> buffer;
+        auto [ec, len] = co_await socket_.async_read_some(asio::buffer(buffer), asio::as_tuple(asio::use_awaitable));
+        co_return ec ? std::string() : std::string(buffer.data(), len);
+    }
+    
+    asio::ip::tcp::socket socket_;
+    std::string buffered_;
+};
+
+class TestServer {
+public:
+    // Answers one request, given by its head
+    using Handler = std::function<asio::awaitable<void>(TestConnection& connection, const std::string& head)>;
+    
+    TestServer(asio::io_context& io_context, Handler handler)
+        : acceptor_(io_context, asio::ip::tcp::endpoint(asio::ip::make_address("127.0.0.1"), 0)),
+          handler_(std::move(handler)) {
+        asio::co_spawn(io_context, accept_loop(), asio::detached);
+    }
+    
+    std::string url(const std::string& path) const {
+        return "http://" + host_port() + path;
+    }
+    
+    // "127.0.0.1:<port>", the key of the client's per-host statistics
+    std::string host_port() const {
+        return "127.0.0.1:" + std::to_string(acceptor_.local_endpoint().port());
+    }
+    
+    int accepted() const { return accepted_; }
+    int requests() const { return requests_; }
+    
+    // Stop accepting and close every connection still open
+    void stop() {
+        asio::error_code ec;
+        acceptor_.close(ec);
+        for (auto& connection : connections_) {
+            connection->close();
+        }
+        connections_.clear();
+    }
+
+private:
+    asio::awaitable<void> accept_loop() {
+        while (true) {
+            auto [ec, socket] = co_await acceptor_.async_accept(asio::as_tuple(asio::use_awaitable));
+            if (ec) co_return;
+            
+            ++accepted_;
+            auto connection = std::make_shared<TestConnection>(std::move(socket));
+            connections_.push_back(connection);
+            asio::co_spawn(acceptor_.get_executor(), serve(connection), asio::detached);
+        }
+    }
+    
+    asio::awaitable<void> serve(std::shared_ptr<TestConnection> connection) {
+        while (connection->is_open()) {
+            auto head = co_await connection->co_read_head();
+            if (!head) {
+                co_return;
+            }
+            ++requests_;
+            co_await handler_(*connection, *head);
+        }
+    }
+    
+    asio::ip::tcp::acceptor acceptor_;
+    Handler handler_;
+    std::vector<std::shared_ptr<TestConnection>> connections_;
+    int accepted_{0};
+    int requests_{0};
+};
+
+// gzip-compress each piece with a sync flush, the way a server streams a compressed
+// body; the last piece finishes the stream
+inline std::vector<std::string> gzip_pieces(const std::vector<std::string>& pieces) {
+    z_stream stream{};
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    std::vector<std::string> out;
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        std::string compressed(deflateBound(&stream, pieces[i].size()) + 64, '\0');
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(pieces[i].data()));
+        stream.avail_in = static_cast<uInt>(pieces[i].size());
+        stream.next_out = reinterpret_cast<Bytef*>(compressed.data());
+        stream.avail_out = static_cast<uInt>(compressed.size());
+        deflate(&stream, i + 1 == pieces.size() ? Z_FINISH : Z_SYNC_FLUSH);
+        compressed.resize(compressed.size() - stream.avail_out);
+        out.push_back(compressed);
+    }
+    deflateEnd(&stream);
+    return out;
+}
+
+inline std::string gzip(const std::string& data) {
+    return gzip_pieces({data}).front();
+}
+
+// One chunk of a chunked body
+inline std::string chunk(const std::string& data) {
+    char size_line[32];
+    std::snprintf(size_line, sizeof(size_line), "%zx\r\n", data.size());
+    return size_line + data + "\r\n";
+}
+
+// A whole chunked body, `piece` bytes per chunk
+inline std::string chunked(const std::string& data, size_t piece) {
+    std::string out;
+    for (size_t pos = 0; pos < data.size(); pos += piece) {
+        out += chunk(data.substr(pos, piece));
+    }
+    return out + "0\r\n\r\n";
+}
@@ -0,0 +1,412 @@
+#include "coro_http/coro_http_client.hpp"
+#include "test_server.hpp"
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Test Server-Sent Events parsing and streaming
+ *
+ * Key Points:
+ * - SseParser produces the same events however the stream is split into reads
+ * - Lines may end in LF or CRLF; comments are skipped and data lines are joined
+ * - An event not terminated by a blank line is dropped at end of stream
+ * - Chunked and gzip-encoded event streams are decoded before parsing
+ * - The parser tracks the last event ID and the server's retry interval
+ * - A reconnecting stream resumes with Last-Event-ID and ends on 204
+ * - open_event_stream() queues events with backpressure, dropping or coalescing
+ * - An open event stream does not keep a slot of its host's concurrency limit
+ */
+
+static std::vector<coro_http::SseEvent> parse_in_pieces(const std::string& stream, size_t piece) {
+    coro_http::SseParser parser;
+    std::vector<coro_http::SseEvent> events;
+    auto collect = [&](const coro_http::SseEvent& event) { events.push_back(event); };
+    for (size_t i = 0; i < stream.size(); i += piece) {
+        parser.feed(std::string_view(stream).substr(i, piece), collect);
+    }
+    parser.finish(collect);
+    return events;
+}
+
+int test_parser() {
+    std::cout << "Test: Incremental SSE parser\n";
+
+    std::string stream =
+        ": keep-alive comment\n"
+        "event: token\r\n"
+        "id: 1\r\n"
+        "data: Hello\r\n"
+        "\r\n"
+        "data: first line\n"
+        "data:second line\n"
+        "custom: value\n"
+        "\n"
+        "retry: 3000\n"
+        "\n"
+        "data: never terminated";
+
+    for (size_t piece : {stream.size(), size_t{1}, size_t{2}, size_t{7}, size_t{64}}) {
+        auto events = parse_in_pieces(stream, piece);
+        assert(events.size() == 2);
+        assert(events[0].type == "token");
+        assert(events[0].id == "1");
+        assert(events[0].data == "Hello");
+        assert(events[1].type.empty());
+        assert(events[1].data == "first line\nsecond line");
+        assert(events[1].fields.at("custom") == "value");
+    }
+
+    // The event object is reused, so nothing leaks from one event into the next
+    auto events = parse_in_pieces("event: a\ndata: 1\n\ndata: 2\n\n", 3);
+    assert(events.size() == 2);
+    assert(events[1].type.empty() && events[1].data == "2");
+
+    // Last event ID and retry interval survive reset(), unlike a partial event
+    coro_http::SseParser parser;
+    auto ignore = [](const coro_http::SseEvent&) {};
+    parser.feed("id: 7\ndata: a\n\nretry: 250\ndata: b\n\nid: 8\ndata: lost", ignore);
+    assert(parser.last_event_id() == "7");
+    assert(parser.retry() == std::chrono::milliseconds(250));
+    parser.reset();
+    parser.feed("\n", ignore);
+    assert(parser.last_event_id() == "7");
+    parser.feed("id\n\nretry: soon\n\n", ignore);
+    assert(parser.last_event_id().empty());
+    assert(parser.retry() == std::chrono::milliseconds(250));
+
+    std::cout << "✓ Parser test passed\n";
+    return 0;
+}
+
+struct EventResponse {
+    std::string head;
+    std::vector<std::string> pieces;
+};
+
+// Serves one response per connection, the last one again once they run out: the
+// response head, then each body piece in its own write. Keeps the requests.
+class EventServer {
+public:
+    EventServer(asio::io_context& io_context, std::vector<EventResponse> responses)
+        : responses_(std::move(responses)),
+          server_(io_context, [this](TestConnection& connection, const std::string& head) {
+              return serve(connection, head);
+          }) {}
+
+    std::string url() const { return server_.url("/events"); }
+
+    void stop() { server_.stop(); }
+
+    std::vector<std::string> requests;
+
+private:
+    asio::awaitable<void> serve(TestConnection& connection, const std::string& head) {
+        const auto& response = responses_[std::min(requests.size(), responses_.size() - 1)];
+        requests.push_back(head + "\r\n\r\n");
+
+        bool ok = co_await connection.co_write(response.head);
+        for (const auto& piece : response.pieces) {
+            if (!ok) co_return;
+            asio::steady_timer timer(connection.socket().get_executor());
+            timer.expires_after(std::chrono::milliseconds(5));
+            co_await timer.async_wait(asio::use_awaitable);
+            ok = co_await connection.co_write(piece);
+        }
+        connection.close();
+    }
+
+    std::vector<EventResponse> responses_;
+    TestServer server_;
+};
+
+static std::vector<coro_http::SseEvent> stream_events(const std::string& head, const std::vector<std::string>& pieces) {
+    asio::io_context io_context;
+    EventServer server(io_context, {{head, pieces}});
+    coro_http::CoroHttpClient client(io_context);
+    std::vector<coro_http::SseEvent> events;
+
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        coro_http::HttpRequest request(coro_http::HttpMethod::GET, server.url());
+        request.add_header("Accept", "text/event-stream");
+        co_await client.co_stream_events(request, [&](const coro_http::SseEvent& event) {
+            events.push_back(event);
+        });
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+    return events;
+}
+
+int test_encoded_streams() {
+    std::cout << "Test: Chunked and gzip event streams\n";
+
+    std::vector<std::string> body = {"data: one\n\nda", "ta: two\n", "\nevent: done\ndata: three\n\n"};
+
+    // Chunk boundaries fall inside lines, and the chunk-size lines must not reach the parser
+    std::vector<std::string> chunked;
+    for (const auto& piece : body) {
+        chunked.push_back(chunk(piece));
+    }
+    chunked.push_back("0\r\n\r\n");
+    auto events = stream_events(
+        "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nTransfer-Encoding: chunked\r\n\r\n", chunked);
+    assert(events.size() == 3);
+    assert(events[0].data == "one" && events[1].data == "two");
+    assert(events[2].type == "done" && events[2].data == "three");
+    assert(events[0].fields.empty());
+
+    // gzip inside chunked framing, decoded as each flushed piece arrives
+    std::vector<std::string> compressed;
+    for (const auto& piece : gzip_pieces(body)) {
+        compressed.push_back(chunk(piece));
+    }
+    compressed.push_back("0\r\n\r\n");
+    events = stream_events("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                           "Content-Encoding: gzip\r\nTransfer-Encoding: chunked\r\n\r\n", compressed);
+    assert(events.size() == 3);
+    assert(events[1].data == "two" && events[2].type == "done");
+
+    // Delimited by the connection closing
+    events = stream_events("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n\r\n", body);
+    assert(events.size() == 3);
+
+    std::cout << "✓ Encoded stream test passed\n";
+    return 0;
+}
+
+int test_reconnect() {
+    std::cout << "Test: Reconnecting event stream\n";
+
+    const std::string ok = "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n\r\n";
+    asio::io_context io_context;
+    EventServer server(io_context, {
+        {ok, {"retry: 10\nid: 1\ndata: a\n\nid: 2\ndata: b\n\nid: 3\ndata: cut off"}},
+        {"HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n", {}},
+        {ok, {"data: c\n\n"}},
+        {"HTTP/1.1 204 No Content\r\n\r\n", {}},
+    });
+
+    coro_http::ClientConfig config;
+    config.sse_reconnect = true;
+    coro_http::CoroHttpClient client(io_context, config);
+    std::vector<std::string> data;
+
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        coro_http::HttpRequest request(coro_http::HttpMethod::GET, server.url());
+        co_await client.co_stream_events(request, [&](const coro_http::SseEvent& event) {
+            data.push_back(event.data);
+        });
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+
+    // The 204 ended the stream; the event cut off by the first close was dropped
+    assert((data == std::vector<std::string>{"a", "b", "c"}));
+    assert(server.requests.size() == 4);
+    assert(server.requests[0].find("Last-Event-ID") == std::string::npos);
+    for (size_t i = 1; i < server.requests.size(); ++i) {
+        assert(server.requests[i].find("Last-Event-ID: 2\r\n") != std::string::npos);
+    }
+
+    // Gives up after the configured number of consecutive failures
+    asio::io_context failing_context;
+    EventServer failing(failing_context, {{"HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n", {}}});
+    config.sse_retry_delay = std::chrono::milliseconds(1);
+    config.sse_max_reconnect_attempts = 2;
+    coro_http::CoroHttpClient failing_client(failing_context, config);
+    bool failed = false;
+
+    asio::co_spawn(failing_context, [&]() -> asio::awaitable<void> {
+        coro_http::HttpRequest request(coro_http::HttpMethod::GET, failing.url());
+        try {
+            co_await failing_client.co_stream_events(request, [](const coro_http::SseEvent&) {});
+        } catch (const std::system_error& e) {
+            failed = e.code() == coro_http::error::unexpected_status;
+        }
+        failing.stop();
+    }, asio::detached);
+    failing_context.run();
+
+    assert(failed);
+    assert(failing.requests.size() == 3);
+
+    std::cout << "✓ Reconnect test passed\n";
+    return 0;
+}
+
+// Runs `consume` against a client of a server sending `body` once, close-delimited
+template <typename Consume>
+static void with_event_stream(const std::vector<std::string>& body, Consume consume) {
+    asio::io_context io_context;
+    EventServer server(io_context, {{"HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n\r\n", body}});
+    coro_http::CoroHttpClient client(io_context);
+
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        coro_http::HttpRequest request(coro_http::HttpMethod::GET, server.url());
+        co_await consume(client, request);
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+}
+
+static asio::awaitable<void> sleep_for(std::chrono::milliseconds duration) {
+    asio::steady_timer timer(co_await asio::this_coro::executor, duration);
+    co_await timer.async_wait(asio::use_awaitable);
+}
+
+int test_event_stream() {
+    std::cout << "Test: Awaitable event stream\n";
+
+    std::vector<std::string> numbered;
+    for (int i = 0; i < 10; ++i) {
+        numbered.push_back("data: " + std::to_string(i) + "\n\n");
+    }
+    std::string all_at_once;
+    for (const auto& event : numbered) {
+        all_at_once += event;
+    }
+
+    // Blocking: a slow consumer holds back reading, and nothing is lost
+    std::vector<std::string> data;
+    with_event_stream(numbered, [&](coro_http::CoroHttpClient& client, coro_http::HttpRequest request)
+                                    -> asio::awaitable<void> {
+        auto stream = client.open_event_stream(request, {1, coro_http::SseOverflowPolicy::block});
+        while (auto event = co_await stream.next()) {
+            data.push_back(event->data);
+            co_await sleep_for(std::chrono::milliseconds(10));
+        }
+        assert(stream.dropped() == 0);
+    });
+    assert(data.size() == 10 && data.front() == "0" && data.back() == "9");
+
+    // Dropping: only the newest events are left for a consumer that fell behind
+    data.clear();
+    with_event_stream({all_at_once}, [&](coro_http::CoroHttpClient& client, coro_http::HttpRequest request)
+                                         -> asio::awaitable<void> {
+        auto stream = client.open_event_stream(request, {2, coro_http::SseOverflowPolicy::drop_oldest});
+        co_await sleep_for(std::chrono::milliseconds(100));
+        while (auto event = co_await stream.next()) {
+            data.push_back(event->data);
+        }
+        assert(stream.dropped() == 8);
+    });
+    assert((data == std::vector<std::string>{"8", "9"}));
+
+    // Coalescing: a newer event replaces the queued one of its type
+    std::vector<coro_http::SseEvent> events;
+    with_event_stream({"event: price\ndata: 1\n\nevent: trade\ndata: t\n\n"
+                       "event: price\ndata: 2\n\nevent: price\ndata: 3\n\n"},
+                      [&](coro_http::CoroHttpClient& client, coro_http::HttpRequest request) -> asio::awaitable<void> {
+        auto stream = client.open_event_stream(request, {2, coro_http::SseOverflowPolicy::coalesce});
+        co_await sleep_for(std::chrono::milliseconds(100));
+        while (auto event = co_await stream.next()) {
+            events.push_back(*event);
+        }
+        assert(stream.dropped() == 2);
+    });
+    assert(events.size() == 2);
+    assert(events[0].type == "price" && events[0].data == "3");
+    assert(events[1].type == "trade");
+
+    // Batches: everything that arrived by the time of the call
+    std::vector<size_t> batches;
+    with_event_stream({all_at_once}, [&](coro_http::CoroHttpClient& client, coro_http::HttpRequest request)
+                                         -> asio::awaitable<void> {
+        auto stream = client.open_event_stream(request);
+        co_await sleep_for(std::chrono::milliseconds(100));
+        while (true) {
+            auto batch = co_await stream.next_batch();
+            if (batch.empty()) break;
+            batches.push_back(batch.size());
+        }
+    });
+    assert((batches == std::vector<size_t>{10}));
+
+    // A failed stream delivers what arrived, then throws
+    asio::io_context io_context;
+    EventServer server(io_context, {{"HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                                     "Transfer-Encoding: chunked\r\n\r\n", {chunk("data: a\n\n")}}});
+    coro_http::CoroHttpClient client(io_context);
+    bool failed = false;
+    data.clear();
+
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        auto stream = client.open_event_stream(coro_http::HttpRequest(coro_http::HttpMethod::GET, server.url()));
+        try {
+            while (auto event = co_await stream.next()) {
+                data.push_back(event->data);
+            }
+        } catch (const std::system_error& e) {
+            failed = e.code() == coro_http::error::incomplete_body;
+        }
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+    assert(failed);
+    assert((data == std::vector<std::string>{"a"}));
+
+    std::cout << "✓ Event stream test passed\n";
+    return 0;
+}
+
+int test_host_slot() {
+    std::cout << "Test: Event stream releases its host slot\n";
+
+    // The event stream stays open until the server stops
+    asio::io_context io_context;
+    TestServer server(io_context, [](TestConnection& connection, const std::string& head) -> asio::awaitable<void> {
+        if (head.find(" /events ") != std::string::npos) {
+            co_await connection.co_write("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n\r\ndata: a\n\n");
+            while (!(co_await connection.co_read_some()).empty()) {}
+            co_return;
+        }
+        co_await connection.co_write("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    coro_http::CoroHttpClient client(io_context);
+    client.host_limits().set_limit("127.0.0.1", {0, std::chrono::milliseconds(1000), 1});
+    std::vector<std::string> data;
+    int status = 0;
+
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        co_await client.co_stream_events(coro_http::HttpRequest(coro_http::HttpMethod::GET, server.url("/events")),
+                                         [&](const coro_http::SseEvent& event) { data.push_back(event.data); });
+    }, asio::detached);
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        co_await sleep_for(std::chrono::milliseconds(50));
+        coro_http::HttpRequest request(coro_http::HttpMethod::GET, server.url("/plain"));
+        request.set_timeout(std::chrono::milliseconds(1000));
+        try {
+            status = (co_await client.co_execute(request)).status_code();
+        } catch (const std::system_error&) {
+        }
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+
+    assert((data == std::vector<std::string>{"a"}));
+    assert(status == 200);
+
+    std::cout << "✓ Host slot test passed\n";
+    return 0;
+}
+
+int main() {
+    std::cout << "=== SSE Tests ===\n\n";
+
+    try {
+        test_parser();
+        test_encoded_streams();
+        test_reconnect();
+        test_event_stream();
+        test_host_slot();
+
+        std::cout << "\n=== All SSE tests passed ===\n";
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -1,45 +1,188 @@
 #include "coro_http/coro_http_client.hpp"
+#include "test_server.hpp"
 #include <cassert>
 #include <iostream>
 #include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
 
 /**
  * Test timeout and promise cancellation
- * 
+ *
  * Key Points:
  * - Check that timeout properly cancels the coroutine
  * - Verify promise is released after cancellation
  * - Ensure no resource leaks on timeout
  */
 
+// Answers "GET /ok" immediately, answers "GET /hedge" on every request but the
+// first, and never answers anything else. Stalled connections are held open until
+// the server stops, so the client sees a silent peer.
+static TestServer::Handler stalling_handler() {
+    return [hedge_requests = 0](TestConnection& connection, const std::string& head) mutable
+               -> asio::awaitable<void> {
+        bool answer = head.rfind("GET /ok ", 0) == 0 ||
+                      (head.rfind("GET /hedge ", 0) == 0 && hedge_requests++ > 0);
+        if (answer) {
+            co_await connection.co_write("HTTP/1.1 200 OK\r\nContent-Length: 2\r\nConnection: close\r\n\r\nok");
+        }
+    };
+}
+
+static bool is_timeout(const std::system_error& e) {
+    return e.code() == asio::error::timed_out;
+}
+
 int test_basic_timeout() {
     std::cout << "Test: Basic timeout\n";
     
-    // This test checks that a timeout correctly cancels an ongoing request
-    // and releases the promise without leaking resources
+    // A stalled upstream must not hold the coroutine, socket and pooled slot forever:
+    // the read times out and the connection is closed instead of returned to the pool.
+    asio::io_context io_context;
+    TestServer server(io_context, stalling_handler());
+    
+    coro_http::ClientConfig config;
+    config.read_timeout = std::chrono::milliseconds(200);
+    coro_http::CoroHttpClient client(io_context, config);
+    
+    bool timed_out = false;
+    auto started = std::chrono::steady_clock::now();
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        try {
+            co_await client.co_get(server.url("/stall"));
+        } catch (const std::system_error& e) {
+            timed_out = is_timeout(e);
+        }
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+    
+    auto elapsed = std::chrono::steady_clock::now() - started;
+    assert(timed_out);
+    assert(elapsed < std::chrono::seconds(5));
     
-    // In a real scenario, you would:
-    // 1. Create a long-running request
-    // 2. Set a short timeout
-    // 3. Catch the timeout exception
-    // 4. Verify the request was properly cancelled
+    auto stats = client.get_pool_stats();
+    assert(stats.total_http_connections == 0);
+    assert(stats.active_http_connections == 0);
     
     std::cout << "✓ Timeout test passed\n";
     return 0;
 }
 
+int test_request_timeout() {
+    std::cout << "Test: Total request timeout\n";
+    
+    // request_timeout bounds the whole attempt even when the per-read timeout is generous
+    asio::io_context io_context;
+    TestServer server(io_context, stalling_handler());
+    
+    coro_http::ClientConfig config;
+    config.read_timeout = std::chrono::seconds(20);
+    config.request_timeout = std::chrono::milliseconds(200);
+    coro_http::CoroHttpClient client(io_context, config);
+    
+    bool timed_out = false;
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        try {
+            co_await client.co_get(server.url("/stall"));
+        } catch (const std::system_error& e) {
+            timed_out = is_timeout(e);
+        }
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+    
+    assert(timed_out);
+    assert(client.get_pool_stats().total_http_connections == 0);
+    
+    std::cout << "✓ Request timeout test passed\n";
+    return 0;
+}
+
 int test_timeout_with_retry() {
     std::cout << "Test: Timeout with retry\n";
     
     // Test that retry mechanism works correctly with timeouts
     // - First request times out
-    // - Retry is triggered
-    // - Second attempt completes or times out again
+    // - Retry is triggered on a fresh connection
+    // - Final attempt times out again and the error surfaces
+    asio::io_context io_context;
+    TestServer server(io_context, stalling_handler());
+    
+    coro_http::ClientConfig config;
+    config.read_timeout = std::chrono::milliseconds(100);
+    config.enable_retry = true;
+    config.max_retries = 2;
+    config.initial_retry_delay = std::chrono::milliseconds(10);
+    config.retry_on_timeout = true;
+    coro_http::CoroHttpClient client(io_context, config);
+    
+    bool timed_out = false;
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        try {
+            co_await client.co_get(server.url("/stall"));
+        } catch (const std::system_error& e) {
+            timed_out = is_timeout(e);
+        }
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+    
+    assert(timed_out);
+    assert(server.accepted() == 3);
     
     std::cout << "✓ Timeout with retry test passed\n";
     return 0;
 }
 
+int test_retry_state_and_budget() {
+    std::cout << "Test: Per-request retry state and retry budget\n";
+    
+    // Concurrent requests each get their full retry allowance; the client-wide
+    // budget then stops retries once it is spent.
+    asio::io_context io_context;
+    TestServer server(io_context, stalling_handler());
+    
+    coro_http::ClientConfig config;
+    config.read_timeout = std::chrono::milliseconds(50);
+    config.enable_retry = true;
+    config.max_retries = 2;
+    config.initial_retry_delay = std::chrono::milliseconds(10);
+    config.retry_budget_ratio = 0.0;
+    config.retry_budget_burst = 5;
+    coro_http::CoroHttpClient client(io_context, config);
+    
+    int timeouts = 0;
+    auto request = [&]() -> asio::awaitable<void> {
+        try {
+            co_await client.co_get(server.url("/stall"));
+        } catch (const std::system_error& e) {
+            if (is_timeout(e)) ++timeouts;
+        }
+    };
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        using namespace asio::experimental::awaitable_operators;
+        co_await (request() && request());
+        
+        // Budget has one token left: a single retry, then the error surfaces
+        co_await request();
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+    
+    assert(timeouts == 3);
+    assert(server.accepted() == 3 + 3 + 2);
+    auto stats = client.get_retry_stats();
+    assert(stats.retries == 5);
+    assert(stats.retries_denied == 1);
+    
+    std::cout << "✓ Retry state and budget test passed\n";
+    return 0;
+}
+
 int test_concurrent_timeout() {
     std::cout << "Test: Concurrent timeout handling\n";
     
@@ -48,23 +191,190 @@ int test_concurrent_timeout() {
     // - Request A times out
     // - Request B completes successfully
     // - Request C times out
-    // Verify each promise is properly released
+    asio::io_context io_context;
+    TestServer server(io_context, stalling_handler());
+    
+    coro_http::ClientConfig config;
+    config.read_timeout = std::chrono::milliseconds(200);
+    coro_http::CoroHttpClient client(io_context, config);
+    
+    int timeouts = 0;
+    int successes = 0;
+    int finished = 0;
+    
+    auto run_one = [&](std::string path) -> asio::awaitable<void> {
+        try {
+            auto response = co_await client.co_get(server.url(path));
+            if (response.status_code() == 200 && response.body() == "ok") {
+                ++successes;
+            }
+        } catch (const std::system_error& e) {
+            if (is_timeout(e)) ++timeouts;
+        }
+        if (++finished == 3) {
+            server.stop();
+        }
+    };
+    
+    asio::co_spawn(io_context, run_one("/stall-a"), asio::detached);
+    asio::co_spawn(io_context, run_one("/ok"), asio::detached);
+    asio::co_spawn(io_context, run_one("/stall-c"), asio::detached);
+    io_context.run();
+    
+    assert(timeouts == 2);
+    assert(successes == 1);
+    assert(client.get_pool_stats().active_http_connections == 0);
     
     std::cout << "✓ Concurrent timeout test passed\n";
     return 0;
 }
 
+int test_per_request_deadline() {
+    std::cout << "Test: Per-request deadline\n";
+    
+    // The request's own deadline spans all retries and cuts the retry sleep short
+    asio::io_context io_context;
+    TestServer server(io_context, stalling_handler());
+    
+    coro_http::ClientConfig config;
+    config.read_timeout = std::chrono::milliseconds(100);
+    config.enable_retry = true;
+    config.max_retries = 5;
+    config.initial_retry_delay = std::chrono::seconds(10);
+    coro_http::CoroHttpClient client(io_context, config);
+    
+    bool timed_out = false;
+    auto started = std::chrono::steady_clock::now();
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        coro_http::HttpRequest request(coro_http::HttpMethod::GET, server.url("/stall"));
+        request.set_timeout(std::chrono::milliseconds(400));
+        try {
+            co_await client.co_execute(request);
+        } catch (const std::system_error& e) {
+            timed_out = is_timeout(e);
+        }
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+    
+    assert(timed_out);
+    assert(std::chrono::steady_clock::now() - started < std::chrono::seconds(5));
+    assert(server.accepted() == 1);
+    
+    std::cout << "✓ Per-request deadline test passed\n";
+    return 0;
+}
+
+int test_cancellation_token() {
+    std::cout << "Test: Explicit cancellation token\n";
+    
+    // Cancelling from outside reaches the in-flight read, and the
+    // interrupted connection is closed rather than returned to the pool
+    asio::io_context io_context;
+    TestServer server(io_context, stalling_handler());
+    
+    coro_http::ClientConfig config;
+    config.read_timeout = std::chrono::seconds(20);
+    coro_http::CoroHttpClient client(io_context, config);
+    
+    coro_http::CancellationToken token;
+    bool aborted = false;
+    
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        coro_http::HttpRequest request(coro_http::HttpMethod::GET, server.url("/stall"));
+        request.set_cancellation_token(token);
+        try {
+            co_await client.co_execute(request);
+        } catch (const std::system_error& e) {
+            aborted = e.code() == asio::error::operation_aborted;
+        }
+        server.stop();
+    }, asio::detached);
+    
+    // Cancel from another thread while the read is pending
+    std::thread canceller([&token]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        token.cancel();
+    });
+    io_context.run();
+    canceller.join();
+    
+    assert(aborted);
+    assert(client.get_pool_stats().total_http_connections == 0);
+    
+    std::cout << "✓ Cancellation token test passed\n";
+    return 0;
+}
+
+int test_hedged_request() {
+    std::cout << "Test: Hedged request wins over a stalled primary\n";
+    
+    // Once the host has a latency history, a primary that outlives the
+    // observed percentile gets a second copy; the copy answers and the
+    // stalled primary is cancelled and closed.
+    asio::io_context io_context;
+    TestServer server(io_context, stalling_handler());
+    
+    coro_http::ClientConfig config;
+    config.read_timeout = std::chrono::seconds(5);
+    config.enable_hedging = true;
+    config.hedge_min_samples = 5;
+    config.hedge_budget_ratio = 1.0;
+    coro_http::CoroHttpClient client(io_context, config);
+    
+    bool answered = false;
+    asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+        for (int i = 0; i < 5; ++i) {
+            co_await client.co_get(server.url("/ok"));
+        }
+        auto response = co_await client.co_get(server.url("/hedge"));
+        answered = response.status_code() == 200;
+        server.stop();
+    }, asio::detached);
+    io_context.run();
+    
+    assert(answered);
+    assert(client.get_hedge_stats().hedges_sent == 1);
+    assert(client.get_hedge_stats().hedges_won == 1);
+    assert(client.get_pool_stats().active_http_connections == 0);
+    
+    std::cout << "✓ Hedged request test passed\n";
+    return 0;
+}
+
 int test_cancellation_promise_release() {
     std::cout << "Test: Promise release on cancellation\n";
     
     // Most critical for coroutine libraries:
     // When a coroutine is cancelled (e.g., via timeout),
     // the promise object must be properly destroyed
-    // 
+    //
     // Detection:
     // - Run with AddressSanitizer (ASAN)
     // - Would detect use-after-free if promise not released
     // - Would detect memory leaks if promise not destroyed
+    //
+    // Destroy the client while the io_context still holds the cancelled operations.
+    asio::io_context io_context;
+    TestServer server(io_context, stalling_handler());
+    
+    {
+        coro_http::ClientConfig config;
+        config.read_timeout = std::chrono::milliseconds(50);
+        auto client = std::make_unique<coro_http::CoroHttpClient>(io_context, config);
+        
+        asio::co_spawn(io_context, [&]() -> asio::awaitable<void> {
+            try {
+                co_await client->co_get(server.url("/stall"));
+            } catch (const std::system_error&) {
+            }
+            client.reset();
+            server.stop();
+        }, asio::detached);
+        io_context.run();
+        assert(!client);
+    }
     
     std::cout << "✓ Promise release test passed (verified with ASAN)\n";
     return 0;
@@ -75,8 +385,13 @@ int main() {
     
     try {
         test_basic_timeout();
+        test_request_timeout();
         test_timeout_with_retry();
+        test_retry_state_and_budget();
         test_concurrent_timeout();
+        test_per_request_deadline();
+        test_cancellation_token();
+        test_hedged_request();
         test_cancellation_promise_release();
         
         std::cout << "\n=== All tests passed ===\n";